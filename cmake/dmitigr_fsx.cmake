@@ -26,6 +26,7 @@ dmitigr_libs_set_library_info(fsx 0 0 0 "Standard filesystem extensions")
 
 set(dmitigr_fsx_headers
   filesystem.hpp
+  mapped_file.hpp
   misc.hpp
   )
 
@@ -29,7 +29,11 @@ set(dmitigr_pgfe_headers
   array_conversions.hpp
   basic_conversions.hpp
   basics.hpp
+  binary_copy_reader.hpp
+  binary_copy_writer.hpp
+  buffered_copier.hpp
   copier.hpp
+  copy_exporter.hpp
   completion.hpp
   compositional.hpp
   composite.hpp
@@ -45,13 +49,19 @@ set(dmitigr_pgfe_headers
   error.hpp
   exceptions.hpp
   large_object.hpp
+  large_object_streambuf.hpp
   message.hpp
   misc.hpp
   notice.hpp
   notification.hpp
   parameterizable.hpp
+  parallel_copier.hpp
+  parallel_large_object_transfer.hpp
+  pipeline_executor.hpp
+  pipelined_large_object.hpp
   pq.hpp
   prepared_statement.hpp
+  probe.hpp
   problem.hpp
   ready_for_query.hpp
   response.hpp
@@ -60,13 +70,18 @@ set(dmitigr_pgfe_headers
   signal.hpp
   statement.hpp
   statement_vector.hpp
+  text_copy_writer.hpp
   transaction_guard.hpp
   tuple.hpp
   types_fwd.hpp
   )
 
 set(dmitigr_pgfe_implementations
+  binary_copy_reader.cpp
+  binary_copy_writer.cpp
+  buffered_copier.cpp
   copier.cpp
+  copy_exporter.cpp
   completion.cpp
   composite.cpp
   compositional.cpp
@@ -79,10 +94,15 @@ set(dmitigr_pgfe_implementations
   error.cpp
   exceptions.cpp
   large_object.cpp
+  large_object_streambuf.cpp
   misc.cpp
   notice.cpp
   notification.cpp
   parameterizable.cpp
+  parallel_copier.cpp
+  parallel_large_object_transfer.cpp
+  pipeline_executor.cpp
+  pipelined_large_object.cpp
   prepared_statement.cpp
   problem.cpp
   ready_for_query.cpp
@@ -90,6 +110,7 @@ set(dmitigr_pgfe_implementations
   row_info.cpp
   statement.cpp
   statement_vector.cpp
+  text_copy_writer.cpp
   tuple.cpp
   )
 
@@ -115,6 +136,37 @@ else()
     ${PostgreSQL_LIBRARIES})
 endif()
 
+find_package(Threads REQUIRED)
+list(APPEND dmitigr_pgfe_target_link_libraries_public ${CMAKE_THREAD_LIBS_INIT})
+list(APPEND dmitigr_pgfe_target_link_libraries_interface ${CMAKE_THREAD_LIBS_INIT})
+
+set(DMITIGR_PGFE_USDT Off CACHE BOOL
+  "Compile in the USDT probes of pgfe? (Requires sys/sdt.h.)")
+if(DMITIGR_PGFE_USDT)
+  include(CheckIncludeFileCXX)
+  check_include_file_cxx(sys/sdt.h DMITIGR_PGFE_HAS_SDT_H)
+  if(NOT DMITIGR_PGFE_HAS_SDT_H)
+    message(FATAL_ERROR "DMITIGR_PGFE_USDT requires sys/sdt.h")
+  endif()
+  list(APPEND dmitigr_pgfe_target_compile_definitions_public DMITIGR_PGFE_USDT)
+  list(APPEND dmitigr_pgfe_target_compile_definitions_interface DMITIGR_PGFE_USDT)
+endif()
+
+set(DMITIGR_PGFE_UV Off CACHE BOOL
+  "Build and install the libuv adapter of pgfe? (Requires libuv.)")
+if(DMITIGR_PGFE_UV)
+  find_path(Uv_INCLUDE_DIR uv.h)
+  find_library(Uv_LIBRARY NAMES uv libuv)
+  if(NOT Uv_INCLUDE_DIR OR NOT Uv_LIBRARY)
+    message(FATAL_ERROR "DMITIGR_PGFE_UV requires libuv")
+  endif()
+  list(APPEND dmitigr_pgfe_headers uv_connection.hpp)
+  list(APPEND dmitigr_pgfe_target_include_directories_public "${Uv_INCLUDE_DIR}")
+  list(APPEND dmitigr_pgfe_target_include_directories_interface "${Uv_INCLUDE_DIR}")
+  list(APPEND dmitigr_pgfe_target_link_libraries_public ${Uv_LIBRARY})
+  list(APPEND dmitigr_pgfe_target_link_libraries_interface ${Uv_LIBRARY})
+endif()
+
 # ------------------------------------------------------------------------------
 # Tests
 # ------------------------------------------------------------------------------
@@ -124,7 +176,12 @@ if(DMITIGR_LIBS_TESTS)
     array_dimension
     benchmark_array_client
     benchmark_array_server
+    benchmark_conversions
+    benchmark_hot_paths
     benchmark_statement_replace
+    binary_copy_reader
+    binary_copy_writer
+    buffered_copier
     composite
     connection
     connection_deferrable
@@ -136,19 +193,32 @@ if(DMITIGR_LIBS_TESTS)
     conversions
     conversions_online
     copier
+    copy_exporter
     data
+    fake_server
     exceptions
     hello_world
+    parallel_copier
+    parallel_large_object_transfer
     pipeline
+    pipeline_executor
+    pipelined_large_object
+    pool_contention
     pq_vs_pgfe
     ps
     lob
+    lob_streambuf
     row
     service
     statement
     statement_vector
+    text_copy_writer
     transaction_guard
+    workload
     )
+  if(DMITIGR_PGFE_UV)
+    list(APPEND dmitigr_pgfe_tests uv_connection)
+  endif()
 
   set(dmitigr_pgfe_tests_target_link_libraries dmitigr_base dmitigr_os dmitigr_str
     dmitigr_util)
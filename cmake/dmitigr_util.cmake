@@ -36,5 +36,6 @@ set(dmitigr_util_headers
 # ------------------------------------------------------------------------------
 
 if(DMITIGR_LIBS_TESTS)
-  set(dmitigr_util_tests diag)
+  set(dmitigr_util_tests benchmark diag)
+  set(dmitigr_util_tests_target_link_libraries dmitigr_base)
 endif()
@@ -0,0 +1,216 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DMITIGR_FSX_MAPPED_FILE_HPP
+#define DMITIGR_FSX_MAPPED_FILE_HPP
+
+#include "filesystem.hpp"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace dmitigr::fsx {
+
+/**
+ * @brief A read-only memory mapping of a whole regular file.
+ *
+ * @details The content of the file is paged in by the operating system on
+ * demand, so neither buffered reads nor copying to the user space buffer take
+ * place.
+ *
+ * @remarks The behaviour is undefined if the file is truncated while mapped.
+ */
+class Mapped_file final {
+public:
+  /// The destructor.
+  ~Mapped_file()
+  {
+    unmap();
+  }
+
+  /// Default-constructible. (Constructs an empty instance.)
+  Mapped_file() = default;
+
+  /**
+   * @brief Maps the file at `path`.
+   *
+   * @throws `std::system_error` on failure.
+   */
+  explicit Mapped_file(const std::filesystem::path& path)
+  {
+    const auto fail = [&path](const int ev)
+    {
+      throw std::system_error{ev, std::system_category(),
+        std::string{"cannot map file "}.append(path.string())};
+    };
+
+#ifdef _WIN32
+    const HANDLE file{CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+      nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr)};
+    if (file == INVALID_HANDLE_VALUE)
+      fail(static_cast<int>(GetLastError()));
+
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(file, &size)) {
+      const auto ev = static_cast<int>(GetLastError());
+      CloseHandle(file);
+      fail(ev);
+    }
+
+    if (size.QuadPart) {
+      const HANDLE mapping{CreateFileMappingW(file, nullptr, PAGE_READONLY,
+        0, 0, nullptr)};
+      const auto ev = static_cast<int>(GetLastError());
+      CloseHandle(file);
+      if (!mapping)
+        fail(ev);
+
+      data_ = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ,
+        0, 0, 0));
+      const auto view_ev = static_cast<int>(GetLastError());
+      CloseHandle(mapping); // the view keeps the mapping alive
+      if (!data_)
+        fail(view_ev);
+      size_ = static_cast<std::size_t>(size.QuadPart);
+    } else
+      CloseHandle(file);
+#else
+    const int fd{::open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+    if (fd < 0)
+      fail(errno);
+
+    struct stat st{};
+    if (::fstat(fd, &st)) {
+      const int ev{errno};
+      ::close(fd);
+      fail(ev);
+    }
+
+    // Empty files cannot be mapped.
+    if (st.st_size > 0) {
+      void* const data{::mmap(nullptr, static_cast<std::size_t>(st.st_size),
+        PROT_READ, MAP_PRIVATE, fd, 0)};
+      const int ev{errno};
+      ::close(fd); // the mapping keeps the file referenced
+      if (data == MAP_FAILED)
+        fail(ev);
+      data_ = static_cast<const char*>(data);
+      size_ = static_cast<std::size_t>(st.st_size);
+#ifdef POSIX_MADV_SEQUENTIAL
+      ::posix_madvise(data, size_, POSIX_MADV_SEQUENTIAL);
+#endif
+    } else
+      ::close(fd);
+#endif
+  }
+
+  /// Non copy-constructible.
+  Mapped_file(const Mapped_file&) = delete;
+
+  /// Non copy-assignable.
+  Mapped_file& operator=(const Mapped_file&) = delete;
+
+  /// Move-constructible.
+  Mapped_file(Mapped_file&& rhs) noexcept
+    : data_{rhs.data_}
+    , size_{rhs.size_}
+  {
+    rhs.data_ = nullptr;
+    rhs.size_ = 0;
+  }
+
+  /// Move-assignable.
+  Mapped_file& operator=(Mapped_file&& rhs) noexcept
+  {
+    if (this != &rhs) {
+      Mapped_file tmp{std::move(rhs)};
+      swap(tmp);
+    }
+    return *this;
+  }
+
+  /// Swaps the instances.
+  void swap(Mapped_file& rhs) noexcept
+  {
+    using std::swap;
+    swap(data_, rhs.data_);
+    swap(size_, rhs.size_);
+  }
+
+  /// @returns The pointer to the mapped content, or `nullptr` if empty.
+  const char* data() const noexcept
+  {
+    return data_;
+  }
+
+  /// @returns The size of the mapped content.
+  std::size_t size() const noexcept
+  {
+    return size_;
+  }
+
+  /// @returns `true` if the mapped content is empty.
+  bool is_empty() const noexcept
+  {
+    return !size_;
+  }
+
+  /// @returns The view of the mapped content.
+  std::string_view view() const noexcept
+  {
+    return data_ ? std::string_view{data_, size_} : std::string_view{};
+  }
+
+private:
+  const char* data_{};
+  std::size_t size_{};
+
+  void unmap() noexcept
+  {
+    if (data_) {
+#ifdef _WIN32
+      UnmapViewOfFile(data_);
+#else
+      ::munmap(const_cast<char*>(data_), size_);
+#endif
+      data_ = nullptr;
+      size_ = 0;
+    }
+  }
+};
+
+} // namespace dmitigr::fsx
+
+#endif  // DMITIGR_FSX_MAPPED_FILE_HPP
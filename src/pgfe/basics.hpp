@@ -440,6 +440,24 @@ enum class Pipeline_status {
 
 // =============================================================================
 
+/**
+ * @ingroup main
+ *
+ * @brief A reaction of the pipeline to the failure of a statement of sequence.
+ */
+enum class Pipeline_error_policy {
+  /**
+   * The statements which follow the failed one are skipped by the server
+   * (`PGRES_PIPELINE_ABORTED`).
+   */
+  abort = 0,
+
+  /// Each statement is followed by the sync so the failures are isolated.
+  isolate = 100
+};
+
+// =============================================================================
+
 /**
  * @ingroup main
  *
@@ -470,6 +488,21 @@ enum class Data_direction {
 
 // =============================================================================
 
+/**
+ * @ingroup main
+ *
+ * @brief A textual format of data of `COPY`.
+ */
+enum class Copy_text_format {
+  /// The text format.
+  text = 0,
+
+  /// The CSV format.
+  csv = 1
+};
+
+// =============================================================================
+
 /**
  * @ingroup main
  *
@@ -0,0 +1,217 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "../net/conversions.hpp"
+#include "binary_copy_reader.hpp"
+#include "binary_copy_writer.hpp"
+#include "exceptions.hpp"
+
+#include <cstring>
+
+namespace dmitigr::pgfe {
+
+DMITIGR_PGFE_INLINE Binary_copy_reader::Binary_copy_reader(Copier& copier)
+  : copier_{copier}
+{
+  if (!copier_)
+    throw Client_exception{"cannot create binary COPY reader: invalid copier"};
+  else if (copier_.data_direction() != Data_direction::from_server)
+    throw Client_exception{"cannot create binary COPY reader: "
+      "wrong data direction"};
+
+  const auto count = copier_.field_count();
+  for (std::size_t i{}; i < count; ++i) {
+    if (copier_.data_format(i) != Data_format::binary)
+      throw Client_exception{"cannot create binary COPY reader: "
+        "COPY is not in binary format"};
+  }
+  field_count_ = count;
+  offsets_.reserve(count);
+  fields_.reserve(count);
+}
+
+DMITIGR_PGFE_INLINE const Copier& Binary_copy_reader::copier() const noexcept
+{
+  return copier_;
+}
+
+DMITIGR_PGFE_INLINE bool Binary_copy_reader::read()
+{
+  offsets_.clear();
+  fields_.clear();
+  if (is_done_)
+    return false;
+
+  if (pos_ == size_ && !receive()) {
+    is_done_ = true;
+    return false;
+  }
+
+  if (!is_header_read_) {
+    read_header();
+    if (pos_ == size_ && !receive()) {
+      is_done_ = true;
+      return false;
+    }
+  }
+
+  std::size_t start{pos_};
+  require(start, 2);
+  const auto count = net::conv<std::int16_t>(data_ + start, 2);
+  if (count == -1) {
+    // The trailer.
+    pos_ = start + 2;
+    is_done_ = true;
+    while (copier_.receive());
+    return false;
+  } else if (count < 0)
+    throw Client_exception{"cannot read binary COPY tuple: "
+      "invalid field count"};
+  else if (static_cast<std::size_t>(count) != field_count_)
+    throw Client_exception{"cannot read binary COPY tuple: "
+      "field count mismatch"};
+
+  std::size_t offset{2};
+  for (std::int16_t i{}; i < count; ++i) {
+    require(start, offset + 4);
+    const auto length = net::conv<std::int32_t>(data_ + start + offset, 4);
+    offset += 4;
+    if (length > 0) {
+      require(start, offset + length);
+      offsets_.emplace_back(offset, length);
+      offset += length;
+    } else if (length == 0 || length == -1)
+      offsets_.emplace_back(offset, length);
+    else
+      throw Client_exception{"cannot read binary COPY tuple: "
+        "invalid field length"};
+  }
+
+  // The data_ can be changed by require(), so the views are created last.
+  for (const auto& [off, length] : offsets_) {
+    if (length >= 0)
+      fields_.emplace_back(data_ + start + off, static_cast<std::size_t>(length),
+        Data_format::binary);
+    else
+      fields_.emplace_back();
+  }
+  pos_ = start + offset;
+  ++tuple_count_;
+  return true;
+}
+
+DMITIGR_PGFE_INLINE std::size_t Binary_copy_reader::field_count() const noexcept
+{
+  return fields_.size();
+}
+
+DMITIGR_PGFE_INLINE Data_view
+Binary_copy_reader::field(const std::size_t index) const
+{
+  if (!(index < fields_.size()))
+    throw Client_exception{"cannot get binary COPY field: invalid index"};
+  return fields_[index];
+}
+
+DMITIGR_PGFE_INLINE const std::vector<Data_view>&
+Binary_copy_reader::fields() const noexcept
+{
+  return fields_;
+}
+
+DMITIGR_PGFE_INLINE std::size_t Binary_copy_reader::tuple_count() const noexcept
+{
+  return tuple_count_;
+}
+
+DMITIGR_PGFE_INLINE bool Binary_copy_reader::receive()
+{
+  while (true) {
+    const auto data = copier_.receive();
+    if (!data)
+      return false;
+    else if (!data.is_empty()) {
+      data_ = static_cast<const char*>(data.bytes());
+      size_ = data.size();
+      pos_ = 0;
+      return true;
+    }
+  }
+}
+
+DMITIGR_PGFE_INLINE void
+Binary_copy_reader::require(std::size_t& start, const std::size_t size)
+{
+  if (size_ - start >= size)
+    return;
+
+  // Assemble the data split across messages in the spill buffer.
+  if (data_ == spill_.data())
+    spill_.erase(0, start);
+  else
+    spill_.assign(data_ + start, size_ - start);
+  start = 0;
+  while (spill_.size() < size) {
+    const auto data = copier_.receive();
+    if (!data)
+      throw Client_exception{"cannot read binary COPY data: "
+        "unexpected end of data"};
+    spill_.append(static_cast<const char*>(data.bytes()), data.size());
+  }
+  data_ = spill_.data();
+  size_ = spill_.size();
+  pos_ = 0;
+}
+
+DMITIGR_PGFE_INLINE void Binary_copy_reader::read_header()
+{
+  using detail::binary_copy_signature;
+  std::size_t start{pos_};
+  require(start, detail::binary_copy_header_size);
+  if (std::memcmp(data_ + start, binary_copy_signature.data(),
+      binary_copy_signature.size()))
+    throw Client_exception{"cannot read binary COPY header: "
+      "invalid signature"};
+
+  const auto* const bytes = data_ + start + binary_copy_signature.size();
+  const auto flags = net::conv<std::uint32_t>(bytes, 4);
+  if (flags & (1U << 16))
+    throw Client_exception{"cannot read binary COPY header: "
+      "OIDs are not supported"};
+  else if (flags & 0xFFFF0000U)
+    throw Client_exception{"cannot read binary COPY header: "
+      "unknown critical flags"};
+
+  const auto ext_length = net::conv<std::int32_t>(bytes + 4, 4);
+  if (ext_length < 0)
+    throw Client_exception{"cannot read binary COPY header: "
+      "invalid header extension length"};
+  const std::size_t size{detail::binary_copy_header_size +
+    static_cast<std::size_t>(ext_length)};
+  require(start, size);
+  pos_ = start + size;
+  is_header_read_ = true;
+}
+
+DMITIGR_PGFE_INLINE void
+Binary_copy_reader::check_field_count(const std::size_t count) const
+{
+  if (count != fields_.size())
+    throw Client_exception{"cannot convert binary COPY tuple: "
+      "field count mismatch"};
+}
+
+} // namespace dmitigr::pgfe
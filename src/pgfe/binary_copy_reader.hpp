@@ -0,0 +1,160 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DMITIGR_PGFE_BINARY_COPY_READER_HPP
+#define DMITIGR_PGFE_BINARY_COPY_READER_HPP
+
+#include "conversions_api.hpp"
+#include "copier.hpp"
+#include "data.hpp"
+#include "dll.hpp"
+#include "types_fwd.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace dmitigr::pgfe {
+
+/**
+ * @ingroup utilities
+ *
+ * @brief A reader of the data in the binary format of `COPY ... TO STDOUT`.
+ *
+ * @details The reader parses the stream of data received by Copier::receive()
+ * into tuples. Each field of the current tuple is represented as Data_view of
+ * Data_format::binary format which points directly into the data received from
+ * the server, so the fields can be converted by using to() without copying.
+ * (For example, `to<std::int32_t>(reader.field(0))`.) The `NULL` fields are
+ * represented as invalid instances of Data_view.
+ *
+ * @remarks Since the server sends each tuple in a separate message, the tuples
+ * normally are not copied. The tuple which is split across messages (if any)
+ * is assembled in the internal buffer.
+ *
+ * @remarks The binary representation of the field is used by the conversion
+ * routines as is, so the type of the field should be exactly matched (e.g.
+ * `std::int16_t` for `smallint`).
+ */
+class Binary_copy_reader final {
+public:
+  /**
+   * @brief The constructor.
+   *
+   * @param copier The copier to receive the data through.
+   *
+   * @par Requires
+   * `copier.data_direction() == Data_direction::from_server` and each field of
+   * the copier must be of Data_format::binary format.
+   *
+   * @remarks The `copier` must outlive the instance.
+   */
+  explicit DMITIGR_PGFE_API Binary_copy_reader(Copier& copier);
+
+  /// Not copy-constructible.
+  Binary_copy_reader(const Binary_copy_reader&) = delete;
+
+  /// Not copy-assignable.
+  Binary_copy_reader& operator=(const Binary_copy_reader&) = delete;
+
+  /// Not move-constructible.
+  Binary_copy_reader(Binary_copy_reader&&) = delete;
+
+  /// Not move-assignable.
+  Binary_copy_reader& operator=(Binary_copy_reader&&) = delete;
+
+  /// @returns The underlying copier.
+  DMITIGR_PGFE_API const Copier& copier() const noexcept;
+
+  /**
+   * @brief Reads the next tuple.
+   *
+   * @returns `false` if there are no more tuples.
+   *
+   * @par Effects
+   * The fields of the previously read tuple are invalidated.
+   *
+   * @remarks After this method returns `false` the response to the `COPY`
+   * command should be awaited (e.g. by using Connection::wait_response_throw()).
+   */
+  DMITIGR_PGFE_API bool read();
+
+  /// @returns The number of fields of the current tuple.
+  DMITIGR_PGFE_API std::size_t field_count() const noexcept;
+
+  /**
+   * @returns The field of the current tuple, or invalid instance if the field
+   * is `NULL`.
+   *
+   * @par Requires
+   * `index < field_count()`.
+   */
+  DMITIGR_PGFE_API Data_view field(std::size_t index) const;
+
+  /// @returns The fields of the current tuple.
+  DMITIGR_PGFE_API const std::vector<Data_view>& fields() const noexcept;
+
+  /**
+   * @returns The fields of the current tuple converted to the `Types`.
+   *
+   * @par Requires
+   * `sizeof...(Types) == field_count()`.
+   */
+  template<typename ... Types>
+  std::tuple<Types...> to_tuple() const
+  {
+    check_field_count(sizeof...(Types));
+    return to_tuple__<Types...>(std::index_sequence_for<Types...>{});
+  }
+
+  /// @returns The number of tuples read.
+  DMITIGR_PGFE_API std::size_t tuple_count() const noexcept;
+
+private:
+  Copier& copier_;
+  std::size_t field_count_{};
+  const char* data_{};
+  std::size_t size_{};
+  std::size_t pos_{};
+  std::string spill_;
+  std::vector<std::pair<std::size_t, std::int32_t>> offsets_;
+  std::vector<Data_view> fields_;
+  std::size_t tuple_count_{};
+  bool is_header_read_{};
+  bool is_done_{};
+
+  bool receive();
+  void require(std::size_t& start, std::size_t size);
+  void read_header();
+  void check_field_count(std::size_t count) const;
+
+  template<typename ... Types, std::size_t ... I>
+  std::tuple<Types...> to_tuple__(std::index_sequence<I...>) const
+  {
+    return std::tuple<Types...>{to<Types>(fields_[I])...};
+  }
+};
+
+} // namespace dmitigr::pgfe
+
+#ifndef DMITIGR_PGFE_NOT_HEADER_ONLY
+#include "binary_copy_reader.cpp"
+#endif
+
+#endif  // DMITIGR_PGFE_BINARY_COPY_READER_HPP
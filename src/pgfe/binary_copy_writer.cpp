@@ -0,0 +1,70 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "binary_copy_writer.hpp"
+#include "connection.hpp"
+
+namespace dmitigr::pgfe {
+
+DMITIGR_PGFE_INLINE
+Binary_copy_writer::Binary_copy_writer(Copier& copier,
+  const std::size_t buffer_size)
+  : stream_{copier, buffer_size}
+{
+  for (std::size_t i{}; i < copier.field_count(); ++i) {
+    if (copier.data_format(i) != Data_format::binary)
+      throw Client_exception{"cannot create binary COPY writer: "
+        "COPY is not in binary format"};
+  }
+
+  auto& buffer = stream_.buffer();
+  buffer.append(detail::binary_copy_signature);
+  detail::append_binary_integer(buffer, std::int32_t{}); // flags
+  detail::append_binary_integer(buffer, std::int32_t{}); // extension length
+}
+
+DMITIGR_PGFE_INLINE void Binary_copy_writer::flush()
+{
+  stream_.flush();
+}
+
+DMITIGR_PGFE_INLINE void Binary_copy_writer::finish()
+{
+  detail::append_binary_integer(stream_.buffer(), std::int16_t{-1}); // trailer
+  stream_.finish();
+}
+
+DMITIGR_PGFE_INLINE void
+Binary_copy_writer::abort(const std::string& error_message)
+{
+  stream_.abort(error_message);
+}
+
+DMITIGR_PGFE_INLINE std::size_t
+Binary_copy_writer::buffered_size() const noexcept
+{
+  return stream_.buffered_size();
+}
+
+DMITIGR_PGFE_INLINE void
+Binary_copy_writer::check_field_count(const std::size_t count) const
+{
+  if (count != stream_.copier().field_count())
+    throw Client_exception{"cannot write COPY tuple: "
+      "field count mismatch"};
+}
+
+} // namespace dmitigr::pgfe
@@ -0,0 +1,342 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DMITIGR_PGFE_BINARY_COPY_WRITER_HPP
+#define DMITIGR_PGFE_BINARY_COPY_WRITER_HPP
+
+#include "../net/conversions.hpp"
+#include "buffered_copier.hpp"
+#include "copier.hpp"
+#include "data.hpp"
+#include "dll.hpp"
+#include "exceptions.hpp"
+#include "types_fwd.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace dmitigr::pgfe {
+
+/// The implementation details.
+namespace detail {
+
+/// The signature of the binary COPY format.
+constexpr std::string_view binary_copy_signature{"PGCOPY\n\377\r\n\0", 11};
+
+/// The size of the header of the binary COPY format.
+constexpr std::size_t binary_copy_header_size{
+  binary_copy_signature.size() + 4 + 4};
+
+template<typename> struct Is_optional final : std::false_type {};
+template<typename T>
+struct Is_optional<std::optional<T>> final : std::true_type {};
+
+template<typename> struct Is_tuple final : std::false_type {};
+template<typename ... Types>
+struct Is_tuple<std::tuple<Types...>> final : std::true_type {};
+template<typename T, typename U>
+struct Is_tuple<std::pair<T, U>> final : std::true_type {};
+
+/// The number of fields of `T` when written as a part of COPY tuple.
+template<typename T>
+struct Binary_copy_field_count final
+  : std::integral_constant<std::size_t, 1> {};
+template<typename ... Types>
+struct Binary_copy_field_count<std::tuple<Types...>> final
+  : std::integral_constant<std::size_t,
+      (std::size_t{} + ... + Binary_copy_field_count<std::decay_t<Types>>::value)> {};
+template<typename T, typename U>
+struct Binary_copy_field_count<std::pair<T, U>> final
+  : std::integral_constant<std::size_t,
+      Binary_copy_field_count<std::decay_t<T>>::value +
+      Binary_copy_field_count<std::decay_t<U>>::value> {};
+
+/// Appends the value of integral type `T` in network byte order.
+template<typename T>
+inline void append_binary_integer(std::string& buffer, const T value)
+{
+  char bytes[sizeof(T)];
+  net::copy(bytes, value);
+  buffer.append(bytes, sizeof(T));
+}
+
+/**
+ * @brief Appends the field `value` in the binary COPY format (i.e. the
+ * field length followed by the field data).
+ */
+template<typename T>
+void append_binary_copy_field(std::string& buffer, const T& value)
+{
+  using U = std::decay_t<T>;
+  const auto append_bytes = [&buffer](const char* const bytes,
+    const std::size_t size)
+  {
+    if (size > static_cast<std::size_t>(std::numeric_limits<std::int32_t>::max()))
+      throw Client_exception{"cannot encode COPY field: too large data"};
+    append_binary_integer(buffer, static_cast<std::int32_t>(size));
+    buffer.append(bytes, size);
+  };
+
+  if constexpr (Is_tuple<U>::value) {
+    std::apply([&buffer](const auto& ... elements)
+    {
+      (append_binary_copy_field(buffer, elements), ...);
+    }, value);
+  } else if constexpr (std::is_same_v<U, std::nullopt_t> ||
+    std::is_same_v<U, std::nullptr_t>) {
+    append_binary_integer(buffer, std::int32_t{-1});
+  } else if constexpr (Is_optional<U>::value) {
+    if (value)
+      append_binary_copy_field(buffer, *value);
+    else
+      append_binary_integer(buffer, std::int32_t{-1});
+  } else if constexpr (std::is_same_v<U, bool> || std::is_same_v<U, char>) {
+    append_binary_integer(buffer, std::int32_t{1});
+    buffer.push_back(static_cast<char>(value));
+  } else if constexpr (std::is_integral_v<U>) {
+    static_assert(std::is_signed_v<U> && sizeof(U) >= 2 && sizeof(U) <= 8,
+      "unsupported integral type for binary COPY");
+    using I = std::conditional_t<sizeof(U) == 2, std::int16_t,
+      std::conditional_t<sizeof(U) == 4, std::int32_t, std::int64_t>>;
+    append_binary_integer(buffer, static_cast<std::int32_t>(sizeof(I)));
+    append_binary_integer(buffer, static_cast<I>(value));
+  } else if constexpr (std::is_same_v<U, float> || std::is_same_v<U, double>) {
+    static_assert(std::numeric_limits<U>::is_iec559);
+    using I = std::conditional_t<sizeof(U) == 4, std::uint32_t, std::uint64_t>;
+    I bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    append_binary_integer(buffer, static_cast<std::int32_t>(sizeof(I)));
+    append_binary_integer(buffer, bits);
+  } else if constexpr (std::is_same_v<U, std::string> ||
+    std::is_same_v<U, std::string_view>) {
+    append_bytes(value.data(), value.size());
+  } else if constexpr (std::is_same_v<U, const char*> ||
+    std::is_same_v<U, char*>) {
+    if (const char* const str = value)
+      append_bytes(str, std::strlen(str));
+    else
+      append_binary_integer(buffer, std::int32_t{-1});
+  } else if constexpr (std::is_base_of_v<Data, U> ||
+    std::is_same_v<U, Data_view>) {
+    if (value)
+      append_bytes(static_cast<const char*>(value.bytes()), value.size());
+    else
+      append_binary_integer(buffer, std::int32_t{-1});
+  } else
+    static_assert(!sizeof(U), "unsupported type for binary COPY");
+}
+
+} // namespace detail
+
+/**
+ * @ingroup utilities
+ *
+ * @brief A writer of the data in the binary format of `COPY ... FROM STDIN`.
+ *
+ * @details The writer encodes each tuple passed to write() into the binary COPY
+ * format: the signature and header are emitted before the first tuple, each
+ * tuple is prefixed with its field count, and each field is encoded as its
+ * length followed by its data in network byte order. The following field types
+ * are supported:
+ *   - `bool`, `char` (PostgreSQL types `boolean`, `"char"`);
+ *   - `short`, `int`, `long`, `long long` (`smallint`, `integer`, `bigint`);
+ *   - `float`, `double` (`real`, `double precision`);
+ *   - `std::string`, `std::string_view`, `const char*`, Data, Data_view
+ *   (sent as is, i.e. suitable for `text`, `varchar`, `bytea` etc);
+ *   - `std::optional<T>` of the above types, `std::nullopt`, `nullptr`
+ *   (`NULL`).
+ *
+ * The encoded data is sent through Buffered_copier.
+ *
+ * @remarks The types which are not listed above have no binary encoding
+ * implemented in Conversions, so the attempt to write them is rejected at
+ * compile time.
+ */
+class Binary_copy_writer final {
+public:
+  /**
+   * @brief The constructor.
+   *
+   * @param copier The copier to send the data through.
+   * @param buffer_size The size of data accumulated before sending.
+   *
+   * @par Requires
+   * `copier.data_direction() == Data_direction::to_server` and each field of
+   * the copier must be of Data_format::binary format.
+   *
+   * @remarks The `copier` must outlive the instance.
+   */
+  explicit DMITIGR_PGFE_API Binary_copy_writer(Copier& copier,
+    std::size_t buffer_size = 65536);
+
+  /// Not copy-constructible.
+  Binary_copy_writer(const Binary_copy_writer&) = delete;
+
+  /// Not copy-assignable.
+  Binary_copy_writer& operator=(const Binary_copy_writer&) = delete;
+
+  /// Move-constructible.
+  Binary_copy_writer(Binary_copy_writer&&) = default;
+
+  /// Not move-assignable.
+  Binary_copy_writer& operator=(Binary_copy_writer&&) = delete;
+
+  /**
+   * @brief Writes the tuple of `fields`.
+   *
+   * @details The arguments of type either `std::tuple` or `std::pair` are
+   * expanded, i.e. their elements are written as the fields of the tuple.
+   * (Thus, any structure can be written by using `std::tie()`.)
+   *
+   * @par Requires
+   * The number of fields (after expansion) must be equal to
+   * `copier.field_count()`.
+   *
+   * @remarks If a field cannot be encoded, nothing is written.
+   */
+  template<typename ... Types>
+  void write(const Types& ... fields)
+  {
+    constexpr std::size_t count{(std::size_t{} + ... +
+      detail::Binary_copy_field_count<std::decay_t<Types>>::value)};
+    check_field_count(count);
+    write_tuple(count, [&fields...](std::string& buffer)
+    {
+      (detail::append_binary_copy_field(buffer, fields), ...);
+    });
+  }
+
+  /**
+   * @brief Writes the tuple which fields are the elements of the `range`.
+   *
+   * @par Requires
+   * The size of `range` must be equal to `copier.field_count()`.
+   *
+   * @remarks If a field cannot be encoded, nothing is written.
+   */
+  template<class Range>
+  void write_range(const Range& range)
+  {
+    const auto size = static_cast<std::size_t>(
+      std::distance(std::cbegin(range), std::cend(range)));
+    check_field_count(size);
+    write_tuple(size, [&range](std::string& buffer)
+    {
+      for (const auto& field : range)
+        detail::append_binary_copy_field(buffer, field);
+    });
+  }
+
+  /**
+   * @brief Writes the tuples which fields are taken from the `columns`.
+   *
+   * @details The `i`-th tuple is composed of the `i`-th elements of each of
+   * the `columns`.
+   *
+   * @par Requires
+   * `sizeof...(columns) == copier.field_count()` and each of the `columns`
+   * must be of the same size.
+   */
+  template<class ... Ranges>
+  void write_columns(const Ranges& ... columns)
+  {
+    static_assert(sizeof...(Ranges) > 0);
+    check_field_count(sizeof...(Ranges));
+    const std::size_t sizes[] = {static_cast<std::size_t>(
+        std::distance(std::cbegin(columns), std::cend(columns)))...};
+    for (const auto size : sizes) {
+      if (size != sizes[0])
+        throw Client_exception{"cannot write COPY columns: "
+          "columns sizes mismatch"};
+    }
+
+    auto iterators = std::make_tuple(std::cbegin(columns)...);
+    for (std::size_t i{}; i < sizes[0]; ++i) {
+      std::apply([this](auto& ... its)
+      {
+        write(*its++...);
+      }, iterators);
+    }
+  }
+
+  /// Sends the accumulated data to the server.
+  DMITIGR_PGFE_API void flush();
+
+  /**
+   * @brief Writes the trailer, sends the accumulated data and the end-of-data
+   * indication to the server.
+   *
+   * @par Effects
+   * `!copier`.
+   *
+   * @see Copier::end().
+   */
+  DMITIGR_PGFE_API void finish();
+
+  /**
+   * @brief Discards the accumulated data and forces the `COPY` to fail.
+   *
+   * @par Effects
+   * `!copier`.
+   */
+  DMITIGR_PGFE_API void abort(const std::string& error_message);
+
+  /// @returns The size of the data accumulated but not yet sent.
+  DMITIGR_PGFE_API std::size_t buffered_size() const noexcept;
+
+private:
+  Buffered_copier stream_;
+
+  void check_field_count(std::size_t count) const;
+
+  /**
+   * @brief Appends the tuple of `count` fields appended by `append_fields`.
+   *
+   * @details If `append_fields` throws, the partially appended tuple is
+   * discarded, so the buffer never contains an incomplete tuple.
+   */
+  template<typename F>
+  void write_tuple(const std::size_t count, const F& append_fields)
+  {
+    auto& buffer = stream_.buffer();
+    const auto tuple_offset = buffer.size();
+    try {
+      detail::append_binary_integer(buffer, static_cast<std::int16_t>(count));
+      append_fields(buffer);
+    } catch (...) {
+      buffer.resize(tuple_offset);
+      throw;
+    }
+    stream_.flush_if_full();
+  }
+};
+
+} // namespace dmitigr::pgfe
+
+#ifndef DMITIGR_PGFE_NOT_HEADER_ONLY
+#include "binary_copy_writer.cpp"
+#endif
+
+#endif  // DMITIGR_PGFE_BINARY_COPY_WRITER_HPP
@@ -0,0 +1,133 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "buffered_copier.hpp"
+#include "connection.hpp"
+#include "exceptions.hpp"
+
+namespace dmitigr::pgfe {
+
+DMITIGR_PGFE_INLINE
+Buffered_copier::Buffered_copier(Copier& copier, const std::size_t buffer_size)
+  : copier_{copier}
+  , buffer_size_{buffer_size}
+{
+  if (!copier_)
+    throw Client_exception{"cannot create buffered copier: invalid copier"};
+  else if (copier_.data_direction() != Data_direction::to_server)
+    throw Client_exception{"cannot create buffered copier: "
+      "wrong data direction"};
+  else if (!buffer_size_)
+    throw Client_exception{"cannot create buffered copier: "
+      "invalid buffer size"};
+
+  buffer_.reserve(buffer_size_);
+}
+
+DMITIGR_PGFE_INLINE Copier& Buffered_copier::copier() noexcept
+{
+  return copier_;
+}
+
+DMITIGR_PGFE_INLINE const Copier& Buffered_copier::copier() const noexcept
+{
+  return copier_;
+}
+
+DMITIGR_PGFE_INLINE std::size_t Buffered_copier::buffer_size() const noexcept
+{
+  return buffer_size_;
+}
+
+DMITIGR_PGFE_INLINE void Buffered_copier::append(const std::string_view data)
+{
+  if (buffer_.size() + data.size() <= buffer_size_) {
+    buffer_.append(data);
+    flush_if_full();
+  } else {
+    flush();
+    if (data.size() < buffer_size_)
+      buffer_.append(data);
+    else
+      send(data);
+  }
+}
+
+DMITIGR_PGFE_INLINE std::string& Buffered_copier::buffer() noexcept
+{
+  return buffer_;
+}
+
+DMITIGR_PGFE_INLINE bool Buffered_copier::flush_if_full()
+{
+  if (buffer_.size() >= buffer_size_) {
+    flush();
+    return true;
+  } else
+    return false;
+}
+
+DMITIGR_PGFE_INLINE void Buffered_copier::flush()
+{
+  if (!buffer_.empty()) {
+    send(buffer_);
+    buffer_.clear(); // the capacity is preserved
+  }
+}
+
+DMITIGR_PGFE_INLINE void Buffered_copier::finish()
+{
+  flush();
+  while (!copier_.end())
+    wait_output_buffer();
+}
+
+DMITIGR_PGFE_INLINE void
+Buffered_copier::abort(const std::string& error_message)
+{
+  buffer_.clear();
+  while (!copier_.end(error_message.empty() ? "aborted" : error_message))
+    wait_output_buffer();
+}
+
+DMITIGR_PGFE_INLINE std::size_t Buffered_copier::buffered_size() const noexcept
+{
+  return buffer_.size();
+}
+
+DMITIGR_PGFE_INLINE std::size_t Buffered_copier::sent_size() const noexcept
+{
+  return sent_size_;
+}
+
+DMITIGR_PGFE_INLINE void Buffered_copier::send(const std::string_view data)
+{
+  while (!copier_.send(data))
+    wait_output_buffer();
+  sent_size_ += data.size();
+}
+
+DMITIGR_PGFE_INLINE void Buffered_copier::wait_output_buffer()
+{
+  auto& conn = copier_.connection();
+  using Sr = Socket_readiness;
+  const auto sr = conn.wait_socket_readiness(Sr::read_ready | Sr::write_ready);
+  if (bool(sr & Sr::read_ready))
+    conn.read_input();
+  conn.flush_output();
+}
+
+} // namespace dmitigr::pgfe
@@ -0,0 +1,148 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DMITIGR_PGFE_BUFFERED_COPIER_HPP
+#define DMITIGR_PGFE_BUFFERED_COPIER_HPP
+
+#include "copier.hpp"
+#include "dll.hpp"
+#include "types_fwd.hpp"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace dmitigr::pgfe {
+
+/**
+ * @ingroup utilities
+ *
+ * @brief A buffered stream of data for `COPY ... FROM STDIN`.
+ *
+ * @details The data appended to the stream is accumulated in the reusable
+ * buffer which is sent to the server with a single call of Copier::send() upon
+ * reaching the specified size. If the output buffers of the connection are full
+ * (which is possible only if Connection::is_nio_output_enabled() returns
+ * `true`) the stream waits until the connection socket becomes write-ready and
+ * flushes the output before retrying.
+ *
+ * @remarks The data larger than the buffer size is sent without copying to the
+ * buffer.
+ */
+class Buffered_copier final {
+public:
+  /**
+   * @brief The constructor.
+   *
+   * @param copier The copier to send the data through.
+   * @param buffer_size The size of the data accumulated before sending.
+   *
+   * @par Requires
+   * `copier.data_direction() == Data_direction::to_server && buffer_size > 0`.
+   *
+   * @remarks The `copier` must outlive the instance.
+   */
+  explicit DMITIGR_PGFE_API Buffered_copier(Copier& copier,
+    std::size_t buffer_size = 65536);
+
+  /// Not copy-constructible.
+  Buffered_copier(const Buffered_copier&) = delete;
+
+  /// Not copy-assignable.
+  Buffered_copier& operator=(const Buffered_copier&) = delete;
+
+  /// Move-constructible.
+  Buffered_copier(Buffered_copier&&) = default;
+
+  /// Not move-assignable.
+  Buffered_copier& operator=(Buffered_copier&&) = delete;
+
+  /// @returns The underlying copier.
+  DMITIGR_PGFE_API Copier& copier() noexcept;
+
+  /// @overload
+  DMITIGR_PGFE_API const Copier& copier() const noexcept;
+
+  /// @returns The size of the data accumulated before sending.
+  DMITIGR_PGFE_API std::size_t buffer_size() const noexcept;
+
+  /**
+   * @brief Appends the `data` to the stream.
+   *
+   * @details Sends the buffer if its size reaches buffer_size().
+   */
+  DMITIGR_PGFE_API void append(std::string_view data);
+
+  /**
+   * @returns The buffer to encode the data into directly.
+   *
+   * @remarks flush_if_full() should be called after appending to the buffer.
+   */
+  DMITIGR_PGFE_API std::string& buffer() noexcept;
+
+  /**
+   * @brief Sends the buffer if its size reaches buffer_size().
+   *
+   * @returns `true` if the buffer was sent.
+   */
+  DMITIGR_PGFE_API bool flush_if_full();
+
+  /// Sends the accumulated data to the server.
+  DMITIGR_PGFE_API void flush();
+
+  /**
+   * @brief Sends the accumulated data and the end-of-data indication to the
+   * server.
+   *
+   * @par Effects
+   * `!copier()`.
+   *
+   * @see Copier::end().
+   */
+  DMITIGR_PGFE_API void finish();
+
+  /**
+   * @brief Discards the accumulated data and forces the `COPY` to fail with
+   * the `error_message`.
+   *
+   * @par Effects
+   * `!copier()`.
+   */
+  DMITIGR_PGFE_API void abort(const std::string& error_message);
+
+  /// @returns The size of the data accumulated but not yet sent.
+  DMITIGR_PGFE_API std::size_t buffered_size() const noexcept;
+
+  /// @returns The total size of the data sent to the server.
+  DMITIGR_PGFE_API std::size_t sent_size() const noexcept;
+
+private:
+  Copier& copier_;
+  std::size_t buffer_size_{};
+  std::size_t sent_size_{};
+  std::string buffer_;
+
+  void send(std::string_view data);
+  void wait_output_buffer();
+};
+
+} // namespace dmitigr::pgfe
+
+#ifndef DMITIGR_PGFE_NOT_HEADER_ONLY
+#include "buffered_copier.cpp"
+#endif
+
+#endif  // DMITIGR_PGFE_BUFFERED_COPIER_HPP
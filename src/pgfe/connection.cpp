@@ -20,6 +20,7 @@
 #include "copier.hpp"
 #include "exceptions.hpp"
 #include "large_object.hpp"
+#include "probe.hpp"
 #include "ready_for_query.hpp"
 #include "statement.hpp"
 
@@ -118,6 +119,7 @@ DMITIGR_PGFE_INLINE void Connection::swap(Connection& rhs) noexcept
   swap(notice_handler_, rhs.notice_handler_);
   swap(notification_handler_, rhs.notification_handler_);
   swap(default_result_format_, rhs.default_result_format_);
+  swap(is_simple_query_protocol_enabled_, rhs.is_simple_query_protocol_enabled_);
   //
   swap(execute_ps_state_, rhs.execute_ps_state_);
   swap(execute_ps_state_->connection_, rhs.execute_ps_state_->connection_);
@@ -229,7 +231,9 @@ DMITIGR_PGFE_INLINE void Connection::connect_nio()
   } else if (s == Status::establishment_reading ||
     s == Status::establishment_writing) {
     DMITIGR_ASSERT(conn());
-    switch (PQconnectPoll(conn())) {
+    const auto polling_status = PQconnectPoll(conn());
+    DMITIGR_PGFE_PROBE(connect__poll, this, static_cast<int>(polling_status));
+    switch (polling_status) {
     case PGRES_POLLING_READING:
       polling_status_ = Status::establishment_reading;
       DMITIGR_ASSERT(status() == Status::establishment_reading);
@@ -243,6 +247,7 @@ DMITIGR_PGFE_INLINE void Connection::connect_nio()
     case PGRES_POLLING_FAILED:
       polling_status_.reset();
       DMITIGR_ASSERT(status() == Status::failure);
+      DMITIGR_PGFE_PROBE(connect__done, this, 0, 0);
       goto done;
 
     case PGRES_POLLING_OK:
@@ -254,6 +259,8 @@ DMITIGR_PGFE_INLINE void Connection::connect_nio()
        * establishment!
        */
       DMITIGR_ASSERT(status() == Status::connected || status() == Status::failure);
+      DMITIGR_PGFE_PROBE(connect__done, this, static_cast<int>(server_pid()),
+        static_cast<int>(status() == Status::connected));
       goto done;
 
     default:
@@ -280,6 +287,7 @@ DMITIGR_PGFE_INLINE void Connection::connect_nio()
       DMITIGR_ASSERT(status() == Status::establishment_writing);
 
       PQsetNoticeReceiver(conn(), &notice_receiver, this);
+      DMITIGR_PGFE_PROBE(connect__start, this);
     } else
       throw std::bad_alloc{};
   }
@@ -454,6 +462,19 @@ Connection::handle_input(const bool wait_response)
     }
   };
 
+  const auto probe_first_row = [this]() noexcept
+  {
+#ifdef DMITIGR_PGFE_USDT
+    if (auto& request = requests_.front(); !request.is_row_received_) {
+      request.is_row_received_ = true;
+      std::size_t size{};
+      for (int i{}; i < response_.field_count(); ++i)
+        size += static_cast<std::size_t>(response_.data_size(0, i));
+      DMITIGR_PGFE_PROBE(input__first_row, static_cast<int>(server_pid()), size);
+    }
+#endif
+  };
+
   static const auto is_completion_status = [](const auto status) noexcept
   {
     return status == PGRES_FATAL_ERROR ||
@@ -467,6 +488,20 @@ Connection::handle_input(const bool wait_response)
       status == PGRES_BAD_RESPONSE;
   };
 
+  /*
+   * The completion of each command of the simple query requested by
+   * execute_simple_nio() is a separate response. Thus, the request is
+   * dismissed only upon the end of results or upon the error (since the
+   * server skips the remaining commands in this case).
+   */
+  const bool is_simple_query{!requests_.empty() &&
+    requests_.front().is_simple_query_};
+  const auto is_simple_query_completion = [is_simple_query](const auto status)
+  {
+    return is_simple_query && is_completion_status(status) &&
+      status != PGRES_FATAL_ERROR && status != PGRES_BAD_RESPONSE;
+  };
+
   /*
    * According to https://www.postgresql.org/docs/current/libpq-pipeline-mode.html,
    * "To enter single-row mode, call PQsetSingleRowMode() before retrieving
@@ -480,19 +515,33 @@ Connection::handle_input(const bool wait_response)
     set_single_row_mode_enabled();
 
   if (wait_response) {
-    if (response_status_ == Response_status::unready) {
+    if (response_status_ == Response_status::unready && response_ &&
+      !is_simple_query) {
     complete_response:
       while (auto* const r = PQgetResult(conn()))
         PQclear(r);
       response_status_ = Response_status::ready_not_preprocessed;
       dismiss_request();
-    } else if (!response_ || (response_status_ == Response_status::ready &&
+    } else if (!response_ || response_status_ == Response_status::unready ||
+      (response_status_ == Response_status::ready &&
         is_completion_status(response_.status()))) {
       response_.reset(PQgetResult(conn()));
+      DMITIGR_PGFE_PROBE(input__result, static_cast<int>(server_pid()),
+        static_cast<int>(response_.status()));
       if (response_.status() == PGRES_SINGLE_TUPLE) {
         response_status_ = Response_status::ready_not_preprocessed;
         check_state();
+        probe_first_row();
         goto handle_notifications;
+      } else if (is_simple_query_completion(response_.status())) {
+        response_status_ = Response_status::ready_not_preprocessed;
+        last_processed_request_ = Request{Request::Id::execute};
+#ifdef LIBPQ_HAS_PIPELINING
+      } else if (response_.status() == PGRES_PIPELINE_SYNC) {
+        // Unlike the results of the commands, the sync is not followed by NULL.
+        response_status_ = Response_status::ready_not_preprocessed;
+        dismiss_request();
+#endif
       } else if (is_completion_status(response_.status()))
         goto complete_response;
       else if (response_)
@@ -514,7 +563,8 @@ Connection::handle_input(const bool wait_response)
       return PQisBusy(conn) == 1;
     };
 
-    if (response_status_ == Response_status::unready) {
+    if (response_status_ == Response_status::unready && response_ &&
+      !is_simple_query) {
     try_complete_response:
       while (!is_get_result_would_block(conn())) {
         if (auto* const r = PQgetResult(conn()); !r) {
@@ -524,14 +574,27 @@ Connection::handle_input(const bool wait_response)
         } else
           PQclear(r);
       }
-    } else if (!response_ || (response_status_ == Response_status::ready &&
+    } else if (!response_ || response_status_ == Response_status::unready ||
+      (response_status_ == Response_status::ready &&
         is_completion_status(response_.status()))) {
       if (!is_get_result_would_block(conn())) {
         response_.reset(PQgetResult(conn()));
+        DMITIGR_PGFE_PROBE(input__result, static_cast<int>(server_pid()),
+          static_cast<int>(response_.status()));
         if (response_.status() == PGRES_SINGLE_TUPLE) {
           response_status_ = Response_status::ready_not_preprocessed;
           check_state();
+          probe_first_row();
           goto handle_notifications;
+        } else if (is_simple_query_completion(response_.status())) {
+          response_status_ = Response_status::ready_not_preprocessed;
+          last_processed_request_ = Request{Request::Id::execute};
+#ifdef LIBPQ_HAS_PIPELINING
+        } else if (response_.status() == PGRES_PIPELINE_SYNC) {
+          // Unlike the results of the commands, the sync is not followed by NULL.
+          response_status_ = Response_status::ready_not_preprocessed;
+          dismiss_request();
+#endif
         } else if (is_completion_status(response_.status())) {
           response_status_ = Response_status::unready;
           goto try_complete_response;
@@ -539,14 +602,24 @@ Connection::handle_input(const bool wait_response)
           response_status_ = Response_status::ready_not_preprocessed;
         else
           response_status_ = Response_status::empty;
-      } else
+      } else {
+        /*
+         * The previous response (if any) is already handled. Resetting it
+         * here prevents treating it as the completion to be completed by the
+         * next call.
+         */
+        response_.reset();
         response_status_ = Response_status::unready;
+      }
     }
   }
 
   // Preprocessing the response_. (This is done only once for response_!)
   if (response_status_ == Response_status::ready_not_preprocessed) {
     const auto rstatus = response_.status();
+    if (is_completion_status(rstatus))
+      DMITIGR_PGFE_PROBE(input__complete, static_cast<int>(server_pid()),
+        static_cast<int>(rstatus), response_.command_tag());
     DMITIGR_ASSERT(rstatus != PGRES_NONFATAL_ERROR);
     DMITIGR_ASSERT(rstatus != PGRES_SINGLE_TUPLE);
     if (rstatus == PGRES_TUPLES_OK) {
@@ -627,11 +700,10 @@ DMITIGR_PGFE_INLINE bool Connection::is_nio_output_enabled() const noexcept
 
 DMITIGR_PGFE_INLINE bool Connection::flush_output(const bool wait)
 {
-  if (is_output_flushed_)
-    return true;
-
   using Sr = Socket_readiness;
   if (const int r{PQflush(conn())}; r == 1) {
+    DMITIGR_PGFE_PROBE(flush__output, static_cast<int>(server_pid()), 0);
+    is_output_flushed_ = false;
     if (wait) {
       const auto sr = wait_socket_readiness(Sr::read_ready | Sr::write_ready);
       if (sr == Sr::read_ready) {
@@ -642,6 +714,7 @@ DMITIGR_PGFE_INLINE bool Connection::flush_output(const bool wait)
     } else
       return false;
   } else if (!r) {
+    DMITIGR_PGFE_PROBE(flush__output, static_cast<int>(server_pid()), 1);
     if (wait)
       wait_socket_readiness(Sr::read_ready);
     return is_output_flushed_ = true;
@@ -844,7 +917,7 @@ DMITIGR_PGFE_INLINE bool Connection::has_uncompleted_request() const noexcept
 DMITIGR_PGFE_INLINE void
 Connection::prepare_nio(const Statement& statement, const std::string& name)
 {
-  prepare_nio__(statement.to_query_string(*this).c_str(),
+  prepare_nio__(statement.compiled(*this)->query.c_str(),
     name.c_str(), &statement); // can throw
 }
 
@@ -925,6 +998,28 @@ DMITIGR_PGFE_INLINE Completion Connection::unprepare(const std::string& name)
   return completion();
 }
 
+DMITIGR_PGFE_INLINE void Connection::execute_simple_nio(const std::string& queries)
+{
+  if (pipeline_status() != Pipeline_status::disabled)
+    throw Client_exception{"cannot execute simple query: pipeline is enabled"};
+  else if (!is_ready_for_nio_request())
+    throw Client_exception{"cannot execute simple query: "
+      "not ready for non-blocking IO request"};
+
+  requests_.emplace(Request::Id::execute); // can throw
+  requests_.back().is_simple_query_ = true;
+  try {
+    if (!PQsendQuery(conn(), queries.c_str()))
+      throw Client_exception{error_message()};
+    set_single_row_mode_enabled();
+  } catch (...) {
+    requests_.pop(); // rollback
+    throw;
+  }
+
+  assert(is_invariant_ok());
+}
+
 DMITIGR_PGFE_INLINE void Connection::set_pipeline_enabled(const bool value)
 {
 #ifdef LIBPQ_HAS_PIPELINING
@@ -994,6 +1089,18 @@ DMITIGR_PGFE_INLINE Data_format Connection::result_format() const noexcept
   return default_result_format_;
 }
 
+DMITIGR_PGFE_INLINE void
+Connection::set_simple_query_protocol_enabled(const bool value) noexcept
+{
+  is_simple_query_protocol_enabled_ = value;
+}
+
+DMITIGR_PGFE_INLINE bool
+Connection::is_simple_query_protocol_enabled() const noexcept
+{
+  return is_simple_query_protocol_enabled_;
+}
+
 DMITIGR_PGFE_INLINE Oid Connection::create_large_object(const Oid oid)
 {
   if (!is_ready_for_request())
@@ -1259,6 +1366,22 @@ Connection::prepare_nio__(const char* const query, const char* const name,
   assert(is_invariant_ok());
 }
 
+DMITIGR_PGFE_INLINE void
+Connection::execute_nio__(const Statement& statement,
+  const std::vector<const Named_argument*>& arguments)
+{
+  Prepared_statement ps{execute_ps_state_, &statement, false};
+  std::vector<Data_view> data; // the bound data must outlive execute_nio()
+  data.reserve(arguments.size());
+  for (const auto* const argument : arguments) {
+    DMITIGR_ASSERT(argument);
+    const auto index = ps.parameter_index(argument->name());
+    if (index < ps.parameter_count())
+      ps.bind(index, data.emplace_back(argument->data()));
+  }
+  ps.execute_nio(statement);
+}
+
 DMITIGR_PGFE_INLINE Prepared_statement Connection::wait_prepared_statement__()
 {
   wait_response_throw();
@@ -43,6 +43,7 @@
 #include <queue>
 #include <string>
 #include <type_traits>
+#include <vector>
 
 namespace dmitigr::pgfe {
 
@@ -793,6 +794,12 @@ public:
    * @brief Requests the server to prepare and execute the unnamed statement
    * from the preparsed SQL string without waiting for a response.
    *
+   * @details If is_simple_query_protocol_enabled(), the statement is simple
+   * (see Statement::Compiled::is_simple), has no parameters to send, the
+   * pipeline is disabled and the result format is Data_format::text, the
+   * simple query protocol is used instead of the extended one, which saves
+   * the Parse, Bind and Describe messages.
+   *
    * @par Effects
    * `has_uncompleted_request()`.
    *
@@ -802,7 +809,7 @@ public:
    * @par Exception safety guarantee
    * Strong.
    *
-   * @see execute().
+   * @see execute(), Statement::Compiled::is_simple.
    */
   template<typename ... Types>
   void execute_nio(const Statement& statement, Types&& ... parameters)
@@ -851,6 +858,83 @@ public:
       std::forward<Types>(parameters)...);
   }
 
+  /**
+   * @brief Requests the server to execute the `queries` by using the simple
+   * query protocol without waiting for a response.
+   *
+   * @details The `queries` may contain multiple SQL commands separated by
+   * semicolons, which are sent as a single message. The completion of each
+   * command is a separate response. The request is completed upon either the
+   * end of results or the error, since the remaining commands are skipped by
+   * the server in this case.
+   *
+   * @par Effects
+   * `has_uncompleted_request()`.
+   *
+   * @par Requires
+   * `is_ready_for_nio_request() && pipeline_status() == Pipeline_status::disabled`.
+   *
+   * @par Exception safety guarantee
+   * Strong.
+   *
+   * @remarks The rows are always in Data_format::text. The `queries` are sent
+   * as is, so they must not contain parameters.
+   *
+   * @see execute_simple().
+   */
+  DMITIGR_PGFE_API void execute_simple_nio(const std::string& queries);
+
+  /**
+   * @brief Requests the server to execute the `queries` by using the simple
+   * query protocol and waits for the responses.
+   *
+   * @param callback Same as for process_responses(). It's called for the
+   * rows of all the commands.
+   * @param queries Same as for execute_simple_nio().
+   *
+   * @returns The completions of the executed commands.
+   *
+   * @par Requires
+   * `is_ready_for_request()`.
+   *
+   * @par Exception safety guarantee
+   * Basic.
+   *
+   * @see execute_simple_nio(), process_responses().
+   */
+  template<Row_processing on_exception = Row_processing::complete, typename F>
+  std::enable_if_t<detail::Response_callback_traits<F>::is_valid,
+    std::vector<Completion>>
+  execute_simple(F&& callback, const std::string& queries)
+  {
+    if (!is_ready_for_request())
+      throw Client_exception{"cannot execute simple query: "
+        "not ready for request"};
+    execute_simple_nio(queries);
+    std::vector<Completion> result;
+    try {
+      while (has_uncompleted_request()) {
+        if (auto comp = process_responses<on_exception>(callback))
+          result.push_back(std::move(comp));
+      }
+    } catch (...) {
+      if constexpr (on_exception == Row_processing::complete) {
+        // Complete the remaining commands.
+        while (has_uncompleted_request())
+          process_responses([](Row&&, Error&&){});
+      }
+      throw;
+    }
+    return result;
+  }
+
+  /// @overload
+  template<Row_processing on_exception = Row_processing::complete>
+  std::vector<Completion> execute_simple(const std::string& queries)
+  {
+    return execute_simple<on_exception>(ignore_row, queries);
+  }
+
   /**
    * @brief Requests the server to invoke the specified function and waits for
    * a response.
@@ -1073,6 +1157,21 @@ public:
   /// @returns The default data format of a statement execution result.
   DMITIGR_PGFE_API Data_format result_format() const noexcept;
 
+  /**
+   * @brief Enables or disables the use of the simple query protocol for the
+   * execution of the simple statements without parameters.
+   *
+   * @details The simple query protocol requires a single Query message
+   * instead of Parse, Bind, Describe, Execute and Sync. The results are always
+   * in the text format in this case. Disabled by default.
+   *
+   * @see execute_nio().
+   */
+  DMITIGR_PGFE_API void set_simple_query_protocol_enabled(bool value) noexcept;
+
+  /// @returns `true` if the simple query protocol is enabled.
+  DMITIGR_PGFE_API bool is_simple_query_protocol_enabled() const noexcept;
+
   ///@}
 
   // ---------------------------------------------------------------------------
@@ -1234,7 +1333,9 @@ public:
 private:
   friend Copier;
   friend Large_object;
+  friend Pipeline_executor;
   friend Prepared_statement;
+  friend Uv_connection;
 
   // ---------------------------------------------------------------------------
   // Persistent data
@@ -1248,6 +1349,7 @@ private:
   Notice_handler notice_handler_{&default_notice_handler};
   Notification_handler notification_handler_;
   Data_format default_result_format_{Data_format::text};
+  bool is_simple_query_protocol_enabled_{};
 
   // Persistent data / private-modifiable data
   std::shared_ptr<Prepared_statement::State> execute_ps_state_;
@@ -1286,6 +1388,10 @@ private:
     Id id_{};
     Prepared_statement prepared_statement_;
     std::optional<std::string> prepared_statement_name_;
+    bool is_simple_query_{}; // see execute_simple_nio()
+#ifdef DMITIGR_PGFE_USDT
+    bool is_row_received_{}; // see handle_input()
+#endif
   };
 
   std::optional<std::chrono::system_clock::time_point> session_start_time_;
@@ -1358,6 +1464,13 @@ private:
   void prepare_nio__(const char* const query, const char* const name,
     const Statement* const preparsed);
 
+  /*
+   * Requests the server to execute the unnamed statement binding each of the
+   * `arguments` which the statement has the parameter for.
+   */
+  void execute_nio__(const Statement& statement,
+    const std::vector<const Named_argument*>& arguments);
+
   template<typename M, typename T>
   Prepared_statement prepare__(M&& prepare, T&& statement, const std::string& name)
   {
@@ -16,6 +16,7 @@
 
 #include "../base/assert.hpp"
 #include "connection_pool.hpp"
+#include "probe.hpp"
 
 #include <algorithm>
 #include <cassert>
@@ -205,9 +206,14 @@ DMITIGR_PGFE_INLINE auto Connection_pool::connection() -> Handle
     auto& self = i->second;
     conn->connect();
     DMITIGR_ASSERT(conn->is_ready_for_request());
-    return {self, std::move(conn), static_cast<std::size_t>(i - b)};
-  } else
+    const auto index = static_cast<std::size_t>(i - b);
+    DMITIGR_PGFE_PROBE(pool__acquire, this, index,
+      static_cast<int>(conn->server_pid()));
+    return {self, std::move(conn), index};
+  } else {
+    DMITIGR_PGFE_PROBE(pool__acquire, this, static_cast<std::size_t>(-1), 0);
     return {};
+  }
 }
 
 DMITIGR_PGFE_INLINE void Connection_pool::release(Handle& handle) noexcept
@@ -221,6 +227,8 @@ DMITIGR_PGFE_INLINE void Connection_pool::release(Handle& handle) noexcept
   auto& conn = *handle.connection_;
   const auto index = handle.state_index_;
   DMITIGR_ASSERT(index < states_.size());
+  DMITIGR_PGFE_PROBE(pool__release, this, index,
+    static_cast<int>(conn.server_pid()));
 
   if (!conn.is_ready_for_request()) {
     // Disconnect and don't call the release handler.
@@ -0,0 +1,304 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "copier.hpp"
+#include "copy_exporter.hpp"
+#include "exceptions.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <ostream>
+#include <system_error>
+#include <thread>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace dmitigr::pgfe {
+
+DMITIGR_PGFE_INLINE Copy_exporter::Copy_exporter(Copier& copier,
+  const std::size_t batch_size)
+  : copier_{copier}
+  , batch_size_{batch_size}
+{
+  if (!copier_)
+    throw Client_exception{"cannot create COPY exporter: invalid copier"};
+  else if (copier_.data_direction() != Data_direction::from_server)
+    throw Client_exception{"cannot create COPY exporter: "
+      "wrong data direction"};
+  else if (!batch_size_)
+    throw Client_exception{"cannot create COPY exporter: invalid batch size"};
+}
+
+DMITIGR_PGFE_INLINE const Copier& Copy_exporter::copier() const noexcept
+{
+  return copier_;
+}
+
+DMITIGR_PGFE_INLINE std::size_t Copy_exporter::batch_size() const noexcept
+{
+  return batch_size_;
+}
+
+DMITIGR_PGFE_INLINE Copy_exporter&
+Copy_exporter::set_writer_thread_enabled(const bool value) noexcept
+{
+  is_writer_thread_enabled_ = value;
+  return *this;
+}
+
+DMITIGR_PGFE_INLINE bool
+Copy_exporter::is_writer_thread_enabled() const noexcept
+{
+  return is_writer_thread_enabled_;
+}
+
+DMITIGR_PGFE_INLINE Copy_exporter&
+Copy_exporter::set_queue_capacity(const std::size_t value)
+{
+  if (!value)
+    throw Client_exception{"cannot set COPY exporter queue capacity: "
+      "invalid value"};
+  queue_capacity_ = value;
+  return *this;
+}
+
+DMITIGR_PGFE_INLINE std::size_t Copy_exporter::queue_capacity() const noexcept
+{
+  return queue_capacity_;
+}
+
+DMITIGR_PGFE_INLINE void Copy_exporter::copy_to(const Sink& sink)
+{
+  if (!sink)
+    throw Client_exception{"cannot export COPY data: invalid sink"};
+
+  export__([&sink](const std::vector<std::string>& batches)
+  {
+    for (const auto& batch : batches)
+      sink(batch);
+  });
+}
+
+DMITIGR_PGFE_INLINE void Copy_exporter::copy_to(std::ostream& stream)
+{
+  export__([&stream](const std::vector<std::string>& batches)
+  {
+    for (const auto& batch : batches) {
+      if (!stream.write(batch.data(), batch.size()))
+        throw Client_exception{"cannot export COPY data: "
+          "cannot write to stream"};
+    }
+  });
+}
+
+DMITIGR_PGFE_INLINE void Copy_exporter::copy_to(const int fd)
+{
+  export__([fd](const std::vector<std::string>& batches)
+  {
+#ifdef _WIN32
+    for (const auto& batch : batches) {
+      const char* data{batch.data()};
+      std::size_t size{batch.size()};
+      while (size) {
+        const int count{_write(fd, data,
+          static_cast<unsigned>(std::min<std::size_t>(size, INT_MAX)))};
+        if (count < 0)
+          throw std::system_error{errno, std::system_category(),
+            "cannot export COPY data"};
+        data += count;
+        size -= count;
+      }
+    }
+#else
+    std::vector<::iovec> iov(batches.size());
+    std::transform(batches.cbegin(), batches.cend(), iov.begin(),
+      [](const auto& batch)
+      {
+        return ::iovec{const_cast<char*>(batch.data()), batch.size()};
+      });
+    for (std::size_t i{}; i < iov.size();) {
+      const auto count = ::writev(fd, &iov[i],
+        static_cast<int>(std::min<std::size_t>(iov.size() - i, IOV_MAX)));
+      if (count < 0) {
+        if (errno == EINTR)
+          continue;
+        throw std::system_error{errno, std::system_category(),
+          "cannot export COPY data"};
+      }
+
+      // Skip the written data.
+      auto size = static_cast<std::size_t>(count);
+      for (; i < iov.size() && size >= iov[i].iov_len; ++i)
+        size -= iov[i].iov_len;
+      if (size) {
+        iov[i].iov_base = static_cast<char*>(iov[i].iov_base) + size;
+        iov[i].iov_len -= size;
+      }
+    }
+#endif
+  });
+}
+
+DMITIGR_PGFE_INLINE std::size_t Copy_exporter::row_count() const noexcept
+{
+  return row_count_;
+}
+
+DMITIGR_PGFE_INLINE std::size_t Copy_exporter::byte_count() const noexcept
+{
+  return byte_count_;
+}
+
+DMITIGR_PGFE_INLINE void Copy_exporter::export__(const Batch_writer& write)
+{
+  if (is_writer_thread_enabled_)
+    return export_threaded__(write);
+
+  std::vector<std::string> batches(1);
+  auto& batch = batches.front();
+  batch.reserve(batch_size_);
+  while (const auto data = copier_.receive()) {
+    batch.append(static_cast<const char*>(data.bytes()), data.size());
+    ++row_count_;
+    byte_count_ += data.size();
+    if (batch.size() >= batch_size_) {
+      try {
+        write(batches);
+      } catch (...) {
+        drain();
+        throw;
+      }
+      batch.clear(); // the capacity is preserved
+    }
+  }
+  if (!batch.empty())
+    write(batches);
+}
+
+DMITIGR_PGFE_INLINE void
+Copy_exporter::export_threaded__(const Batch_writer& write)
+{
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::vector<std::string> ready; // the batches to write
+  std::vector<std::string> spare; // the written batches to reuse
+  bool is_done{};
+  std::exception_ptr error;
+
+  std::thread writer{[&]
+  {
+    std::vector<std::string> batches;
+    while (true) {
+      {
+        std::unique_lock lk{mutex};
+        cv.wait(lk, [&]{ return !ready.empty() || is_done; });
+        if (ready.empty())
+          return;
+        batches.swap(ready);
+      }
+      cv.notify_all();
+
+      try {
+        write(batches);
+      } catch (...) {
+        const std::lock_guard lg{mutex};
+        error = std::current_exception();
+        cv.notify_all();
+        return;
+      }
+
+      {
+        const std::lock_guard lg{mutex};
+        for (auto& batch : batches) {
+          batch.clear(); // the capacity is preserved
+          spare.push_back(std::move(batch));
+        }
+      }
+      batches.clear();
+    }
+  }};
+
+  const auto finish = [&]
+  {
+    {
+      const std::lock_guard lg{mutex};
+      is_done = true;
+    }
+    cv.notify_all();
+    writer.join();
+  };
+
+  // Returns `false` if the writer failed.
+  const auto push = [&](std::string& batch)
+  {
+    {
+      std::unique_lock lk{mutex};
+      cv.wait(lk, [&]{ return ready.size() < queue_capacity_ || error; });
+      if (error)
+        return false;
+      ready.push_back(std::move(batch));
+      if (!spare.empty()) {
+        batch = std::move(spare.back());
+        spare.pop_back();
+      } else
+        batch = {};
+    }
+    cv.notify_all();
+    batch.reserve(batch_size_);
+    return true;
+  };
+
+  try {
+    std::string batch;
+    batch.reserve(batch_size_);
+    while (const auto data = copier_.receive()) {
+      batch.append(static_cast<const char*>(data.bytes()), data.size());
+      ++row_count_;
+      byte_count_ += data.size();
+      if (batch.size() >= batch_size_ && !push(batch)) {
+        drain();
+        break;
+      }
+    }
+    if (!batch.empty())
+      push(batch);
+  } catch (...) {
+    finish();
+    throw;
+  }
+
+  finish();
+  if (error)
+    std::rethrow_exception(error);
+}
+
+DMITIGR_PGFE_INLINE void Copy_exporter::drain() noexcept
+{
+  try {
+    while (copier_.receive());
+  } catch (...) {}
+}
+
+} // namespace dmitigr::pgfe
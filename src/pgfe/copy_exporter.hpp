@@ -0,0 +1,153 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DMITIGR_PGFE_COPY_EXPORTER_HPP
+#define DMITIGR_PGFE_COPY_EXPORTER_HPP
+
+#include "dll.hpp"
+#include "types_fwd.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dmitigr::pgfe {
+
+/**
+ * @ingroup utilities
+ *
+ * @brief An exporter of the data of `COPY ... TO STDOUT` to a sink.
+ *
+ * @details The rows received by Copier::receive() are coalesced into batches
+ * of (at least) the specified size, so each write to the sink handles many
+ * rows at once. Optionally, the batches can be written by a separate writer
+ * thread, so the socket of the connection is drained while the previous
+ * batches are being written. In this case, the writer thread takes all of the
+ * batches ready at the moment and writes them at once (by using `writev()` if
+ * the sink is a file descriptor).
+ *
+ * @remarks If the sink fails, the rest of the data is received and discarded
+ * in order to leave the connection in a consistent state, and then the error
+ * is rethrown.
+ */
+class Copy_exporter final {
+public:
+  /**
+   * @brief The alias of the sink.
+   *
+   * @details The sink is called with each batch of data in order. If the writer
+   * thread is enabled, the sink is called on that thread.
+   */
+  using Sink = std::function<void(std::string_view)>;
+
+  /**
+   * @brief The constructor.
+   *
+   * @param copier The copier to receive the data through.
+   * @param batch_size The size of the data accumulated before writing to
+   * the sink.
+   *
+   * @par Requires
+   * `copier.data_direction() == Data_direction::from_server && batch_size > 0`.
+   *
+   * @remarks The `copier` must outlive the instance.
+   */
+  explicit DMITIGR_PGFE_API Copy_exporter(Copier& copier,
+    std::size_t batch_size = 1048576);
+
+  /// Not copy-constructible.
+  Copy_exporter(const Copy_exporter&) = delete;
+
+  /// Not copy-assignable.
+  Copy_exporter& operator=(const Copy_exporter&) = delete;
+
+  /// @returns The underlying copier.
+  DMITIGR_PGFE_API const Copier& copier() const noexcept;
+
+  /// @returns The size of the data accumulated before writing to the sink.
+  DMITIGR_PGFE_API std::size_t batch_size() const noexcept;
+
+  /// Enables or disables the writing by the separate thread.
+  DMITIGR_PGFE_API Copy_exporter& set_writer_thread_enabled(bool value) noexcept;
+
+  /// @returns `true` if the writing by the separate thread is enabled.
+  DMITIGR_PGFE_API bool is_writer_thread_enabled() const noexcept;
+
+  /**
+   * @brief Sets the maximum number of batches queued for the writer thread.
+   *
+   * @par Requires
+   * `value > 0`.
+   */
+  DMITIGR_PGFE_API Copy_exporter& set_queue_capacity(std::size_t value);
+
+  /// @returns The maximum number of batches queued for the writer thread.
+  DMITIGR_PGFE_API std::size_t queue_capacity() const noexcept;
+
+  /**
+   * @brief Receives all of the data and writes it to the `sink`.
+   *
+   * @par Requires
+   * `sink`.
+   *
+   * @remarks After this method returns the response to the `COPY` command
+   * should be awaited (e.g. by using Connection::wait_response_throw()).
+   */
+  DMITIGR_PGFE_API void copy_to(const Sink& sink);
+
+  /// @overload
+  DMITIGR_PGFE_API void copy_to(std::ostream& stream);
+
+  /**
+   * @overload
+   *
+   * @param fd The file descriptor to write the data to.
+   *
+   * @throws `std::system_error` on write failure.
+   */
+  DMITIGR_PGFE_API void copy_to(int fd);
+
+  /// @returns The number of rows received.
+  DMITIGR_PGFE_API std::size_t row_count() const noexcept;
+
+  /// @returns The number of bytes received.
+  DMITIGR_PGFE_API std::size_t byte_count() const noexcept;
+
+private:
+  using Batch_writer = std::function<void(const std::vector<std::string>&)>;
+
+  Copier& copier_;
+  std::size_t batch_size_{};
+  std::size_t queue_capacity_{4};
+  std::size_t row_count_{};
+  std::size_t byte_count_{};
+  bool is_writer_thread_enabled_{};
+
+  void export__(const Batch_writer& write);
+  void export_threaded__(const Batch_writer& write);
+  void drain() noexcept;
+};
+
+} // namespace dmitigr::pgfe
+
+#ifndef DMITIGR_PGFE_NOT_HEADER_ONLY
+#include "copy_exporter.cpp"
+#endif
+
+#endif  // DMITIGR_PGFE_COPY_EXPORTER_HPP
@@ -0,0 +1,234 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "exceptions.hpp"
+#include "large_object.hpp"
+#include "large_object_streambuf.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace dmitigr::pgfe {
+
+DMITIGR_PGFE_INLINE
+Large_object_streambuf::Large_object_streambuf(Large_object& lob,
+  const std::size_t buffer_size)
+  : lob_{lob}
+  , buffer_size_{buffer_size}
+{
+  if (!lob_.is_valid())
+    throw Client_exception{"cannot create large object stream buffer: "
+      "invalid large object"};
+  else if (!buffer_size_ ||
+    buffer_size_ > static_cast<std::size_t>(std::numeric_limits<int>::max()))
+    throw Client_exception{"cannot create large object stream buffer: "
+      "invalid buffer size"};
+
+  buffer_.reset(new char[buffer_size_]);
+  position_ = lob_.tell();
+}
+
+DMITIGR_PGFE_INLINE Large_object_streambuf::~Large_object_streambuf()
+{
+  try {
+    write_output();
+  } catch (...) {}
+}
+
+DMITIGR_PGFE_INLINE Large_object& Large_object_streambuf::large_object() noexcept
+{
+  return lob_;
+}
+
+DMITIGR_PGFE_INLINE std::size_t
+Large_object_streambuf::buffer_size() const noexcept
+{
+  return buffer_size_;
+}
+
+DMITIGR_PGFE_INLINE auto Large_object_streambuf::underflow() -> int_type
+{
+  if (gptr() && gptr() < egptr())
+    return traits_type::to_int_type(*gptr());
+
+  begin_reading();
+  const auto size = lob_.read(buffer_.get(), buffer_size_);
+  position_ += static_cast<std::int_fast64_t>(size);
+  setg(buffer_.get(), buffer_.get(), buffer_.get() + size);
+  return size ? traits_type::to_int_type(*gptr()) : traits_type::eof();
+}
+
+DMITIGR_PGFE_INLINE std::streamsize
+Large_object_streambuf::xsgetn(char* s, std::streamsize count)
+{
+  std::streamsize result{};
+  while (count > 0) {
+    if (const auto available = egptr() - gptr(); available > 0) {
+      const auto size = std::min<std::streamsize>(available, count);
+      std::memcpy(s, gptr(), static_cast<std::size_t>(size));
+      gbump(static_cast<int>(size));
+      s += size;
+      count -= size;
+      result += size;
+    } else if (static_cast<std::size_t>(count) >= buffer_size_) {
+      // Read directly, without copying to the buffer.
+      begin_reading();
+      setg(buffer_.get(), buffer_.get(), buffer_.get());
+      const auto size = lob_.read(s, std::min<std::size_t>(
+          static_cast<std::size_t>(count), std::numeric_limits<int>::max()));
+      if (!size)
+        break;
+      position_ += static_cast<std::int_fast64_t>(size);
+      s += size;
+      count -= static_cast<std::streamsize>(size);
+      result += static_cast<std::streamsize>(size);
+    } else if (traits_type::eq_int_type(underflow(), traits_type::eof()))
+      break;
+  }
+  return result;
+}
+
+DMITIGR_PGFE_INLINE auto Large_object_streambuf::overflow(const int_type ch)
+  -> int_type
+{
+  begin_writing();
+  if (pptr() == epptr())
+    write_output();
+  if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+    *pptr() = traits_type::to_char_type(ch);
+    pbump(1);
+  }
+  return traits_type::not_eof(ch);
+}
+
+DMITIGR_PGFE_INLINE std::streamsize
+Large_object_streambuf::xsputn(const char* const s, const std::streamsize count)
+{
+  if (static_cast<std::size_t>(count) < buffer_size_)
+    return std::streambuf::xsputn(s, count);
+
+  // Write directly, without copying to the buffer.
+  begin_writing();
+  write_output();
+  write_directly(s, static_cast<std::size_t>(count));
+  return count;
+}
+
+DMITIGR_PGFE_INLINE int Large_object_streambuf::sync()
+{
+  write_output();
+  return 0;
+}
+
+DMITIGR_PGFE_INLINE auto
+Large_object_streambuf::seekoff(const off_type offset,
+  const std::ios_base::seekdir dir, const std::ios_base::openmode)
+  -> pos_type
+{
+  std::int_fast64_t target{};
+  if (dir == std::ios_base::beg)
+    target = offset;
+  else if (dir == std::ios_base::cur) {
+    target = position() + offset;
+    if (!offset)
+      return target;
+  } else {
+    write_output();
+    setg(nullptr, nullptr, nullptr);
+    setp(nullptr, nullptr);
+    return position_ = lob_.seek(offset, Large_object::Seek_whence::end);
+  }
+
+  if (target < 0)
+    return pos_type(off_type(-1));
+
+  // Seek within the get area without a round trip.
+  if (eback()) {
+    const auto begin = position_ - (egptr() - eback());
+    if (begin <= target && target <= position_) {
+      setg(eback(), eback() + (target - begin), egptr());
+      return target;
+    }
+  }
+
+  write_output();
+  setg(nullptr, nullptr, nullptr);
+  setp(nullptr, nullptr);
+  return position_ = lob_.seek(target, Large_object::Seek_whence::begin);
+}
+
+DMITIGR_PGFE_INLINE auto
+Large_object_streambuf::seekpos(const pos_type position,
+  const std::ios_base::openmode which) -> pos_type
+{
+  return seekoff(off_type(position), std::ios_base::beg, which);
+}
+
+DMITIGR_PGFE_INLINE std::int_fast64_t
+Large_object_streambuf::position() const noexcept
+{
+  if (pbase())
+    return position_ + (pptr() - pbase());
+  else if (eback())
+    return position_ - (egptr() - gptr());
+  else
+    return position_;
+}
+
+DMITIGR_PGFE_INLINE void Large_object_streambuf::begin_reading()
+{
+  if (pbase()) {
+    write_output();
+    setp(nullptr, nullptr);
+  }
+}
+
+DMITIGR_PGFE_INLINE void Large_object_streambuf::begin_writing()
+{
+  if (eback()) {
+    // Move the descriptor back to the logical position.
+    if (gptr() != egptr())
+      position_ = lob_.seek(position(), Large_object::Seek_whence::begin);
+    setg(nullptr, nullptr, nullptr);
+  }
+  if (!pbase())
+    setp(buffer_.get(), buffer_.get() + buffer_size_);
+}
+
+DMITIGR_PGFE_INLINE void Large_object_streambuf::write_output()
+{
+  if (pbase() && pptr() != pbase()) {
+    write_directly(pbase(), static_cast<std::size_t>(pptr() - pbase()));
+    setp(pbase(), epptr());
+  }
+}
+
+DMITIGR_PGFE_INLINE void
+Large_object_streambuf::write_directly(const char* data, std::size_t size)
+{
+  while (size) {
+    const auto written = lob_.write(data, std::min<std::size_t>(size,
+        std::numeric_limits<int>::max()));
+    if (!written)
+      throw Client_exception{"cannot write large object"};
+    position_ += static_cast<std::int_fast64_t>(written);
+    data += written;
+    size -= written;
+  }
+}
+
+} // namespace dmitigr::pgfe
@@ -0,0 +1,131 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DMITIGR_PGFE_LARGE_OBJECT_STREAMBUF_HPP
+#define DMITIGR_PGFE_LARGE_OBJECT_STREAMBUF_HPP
+
+#include "dll.hpp"
+#include "types_fwd.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <ios>
+#include <memory>
+#include <streambuf>
+
+namespace dmitigr::pgfe {
+
+/**
+ * @ingroup utilities
+ *
+ * @brief A stream buffer of Large_object.
+ *
+ * @details Allows to read and write the large object by using the standard
+ * streams, e.g. `std::istream`. The single buffer is used either as the get
+ * area (the data is read ahead by the whole buffer in a single round trip)
+ * or as the put area (the data is written behind by the whole buffer in a
+ * single round trip). Reads and writes which are not less than the size of the
+ * buffer are performed directly, without copying to the buffer.
+ *
+ * Seeking within the get area doesn't require a round trip. Otherwise, the
+ * pending output is written and the buffer is discarded.
+ *
+ * @remarks The errors of the underlying large object are reported by throwing
+ * Client_exception (which the standard streams translate to `badbit`).
+ *
+ * @remarks The pending output is written upon `pubsync()` or destruction.
+ */
+class Large_object_streambuf final : public std::streambuf {
+public:
+  /**
+   * @brief The constructor.
+   *
+   * @param lob The large object to read or write.
+   * @param buffer_size The size of the buffer.
+   *
+   * @par Requires
+   * `lob.is_valid() && buffer_size > 0 &&
+   * buffer_size <= std::numeric_limits<int>::max()`.
+   *
+   * @remarks The `lob` must outlive the instance.
+   */
+  explicit DMITIGR_PGFE_API Large_object_streambuf(Large_object& lob,
+    std::size_t buffer_size = 1048576);
+
+  /**
+   * @brief The destructor.
+   *
+   * @details Attempts to write the pending output. (The errors are ignored.)
+   */
+  DMITIGR_PGFE_API ~Large_object_streambuf() override;
+
+  /// Not copy-constructible.
+  Large_object_streambuf(const Large_object_streambuf&) = delete;
+
+  /// Not copy-assignable.
+  Large_object_streambuf& operator=(const Large_object_streambuf&) = delete;
+
+  /// @returns The underlying large object.
+  DMITIGR_PGFE_API Large_object& large_object() noexcept;
+
+  /// @returns The size of the buffer.
+  DMITIGR_PGFE_API std::size_t buffer_size() const noexcept;
+
+protected:
+  /// @see std::streambuf::underflow().
+  DMITIGR_PGFE_API int_type underflow() override;
+
+  /// @see std::streambuf::xsgetn().
+  DMITIGR_PGFE_API std::streamsize xsgetn(char* s, std::streamsize count) override;
+
+  /// @see std::streambuf::overflow().
+  DMITIGR_PGFE_API int_type overflow(int_type ch) override;
+
+  /// @see std::streambuf::xsputn().
+  DMITIGR_PGFE_API std::streamsize xsputn(const char* s,
+    std::streamsize count) override;
+
+  /// @see std::streambuf::sync().
+  DMITIGR_PGFE_API int sync() override;
+
+  /// @see std::streambuf::seekoff().
+  DMITIGR_PGFE_API pos_type seekoff(off_type offset, std::ios_base::seekdir dir,
+    std::ios_base::openmode which) override;
+
+  /// @see std::streambuf::seekpos().
+  DMITIGR_PGFE_API pos_type seekpos(pos_type position,
+    std::ios_base::openmode which) override;
+
+private:
+  Large_object& lob_;
+  std::size_t buffer_size_{};
+  std::unique_ptr<char[]> buffer_;
+  std::int_fast64_t position_{}; // the position of the large object descriptor
+
+  std::int_fast64_t position() const noexcept;
+  void begin_reading();
+  void begin_writing();
+  void write_output();
+  void write_directly(const char* data, std::size_t size);
+};
+
+} // namespace dmitigr::pgfe
+
+#ifndef DMITIGR_PGFE_NOT_HEADER_ONLY
+#include "large_object_streambuf.cpp"
+#endif
+
+#endif  // DMITIGR_PGFE_LARGE_OBJECT_STREAMBUF_HPP
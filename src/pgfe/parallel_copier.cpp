@@ -0,0 +1,336 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "buffered_copier.hpp"
+#include "connection.hpp"
+#include "connection_pool.hpp"
+#include "exceptions.hpp"
+#include "parallel_copier.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace dmitigr::pgfe {
+
+namespace detail {
+
+/// The queue of batches of rows of a stream of Parallel_copier.
+struct Parallel_copier_channel final {
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<std::string> batches;
+  bool is_closed{};
+};
+
+} // namespace detail
+
+DMITIGR_PGFE_INLINE Parallel_copier::Parallel_copier(Connection_pool& pool,
+  std::string statement, const std::size_t stream_count)
+  : pool_{pool}
+  , statement_{std::move(statement)}
+  , stream_count_{stream_count}
+{
+  if (!stream_count_)
+    throw Client_exception{"cannot create parallel copier: "
+      "invalid stream count"};
+  else if (stream_count_ > pool_.size())
+    throw Client_exception{"cannot create parallel copier: "
+      "stream count is greater than the size of connection pool"};
+}
+
+DMITIGR_PGFE_INLINE std::size_t Parallel_copier::stream_count() const noexcept
+{
+  return stream_count_;
+}
+
+DMITIGR_PGFE_INLINE Parallel_copier&
+Parallel_copier::set_batch_size(const std::size_t value)
+{
+  if (!value)
+    throw Client_exception{"cannot set parallel copier batch size: "
+      "invalid value"};
+  batch_size_ = value;
+  return *this;
+}
+
+DMITIGR_PGFE_INLINE std::size_t Parallel_copier::batch_size() const noexcept
+{
+  return batch_size_;
+}
+
+DMITIGR_PGFE_INLINE Parallel_copier&
+Parallel_copier::set_queue_capacity(const std::size_t value)
+{
+  if (!value)
+    throw Client_exception{"cannot set parallel copier queue capacity: "
+      "invalid value"};
+  queue_capacity_ = value;
+  return *this;
+}
+
+DMITIGR_PGFE_INLINE std::size_t Parallel_copier::queue_capacity() const noexcept
+{
+  return queue_capacity_;
+}
+
+DMITIGR_PGFE_INLINE Parallel_copier&
+Parallel_copier::set_two_phase_commit_enabled(const bool value)
+{
+  is_two_phase_commit_enabled_ = value;
+  return *this;
+}
+
+DMITIGR_PGFE_INLINE bool
+Parallel_copier::is_two_phase_commit_enabled() const noexcept
+{
+  return is_two_phase_commit_enabled_;
+}
+
+DMITIGR_PGFE_INLINE auto Parallel_copier::last_stream_stats() const noexcept
+  -> const std::vector<Stream_stats>&
+{
+  return last_stream_stats_;
+}
+
+DMITIGR_PGFE_INLINE auto
+Parallel_copier::load(const Producer& producer, const Partitioner& partitioner)
+  -> std::vector<Stream_stats>
+{
+  using Clock = std::chrono::steady_clock;
+  using detail::Parallel_copier_channel;
+
+  if (!producer)
+    throw Client_exception{"cannot load via parallel copier: "
+      "invalid producer"};
+  else if (!partitioner)
+    throw Client_exception{"cannot load via parallel copier: "
+      "invalid partitioner"};
+
+  const std::size_t n{stream_count_};
+  const bool is_two_phase{is_two_phase_commit_enabled_};
+  last_stream_stats_.clear();
+  std::vector<Connection_pool::Handle> handles;
+  handles.reserve(n);
+  for (std::size_t i{}; i < n; ++i) {
+    if (auto handle = pool_.connection())
+      handles.push_back(std::move(handle));
+    else
+      throw Client_exception{"cannot load via parallel copier: "
+        "not enough free connections in the pool"};
+  }
+
+  std::vector<Stream_stats> stats(n);
+  std::vector<Parallel_copier_channel> channels(n);
+
+  // Failure state.
+  std::atomic_bool is_failed{};
+  std::mutex error_mutex;
+  std::exception_ptr error;
+  const auto fail = [&](std::exception_ptr e)
+  {
+    {
+      const std::lock_guard lg{error_mutex};
+      if (!error)
+        error = std::move(e);
+    }
+    is_failed = true;
+    for (auto& channel : channels) {
+      { const std::lock_guard lg{channel.mutex}; }
+      channel.cv.notify_all();
+    }
+  };
+
+  // Commit barriers.
+  std::mutex done_mutex;
+  std::condition_variable done_cv;
+  std::size_t done_count{};
+  std::size_t prepared_count{};
+  const auto wait_others = [&](std::size_t& count)
+  {
+    std::unique_lock lk{done_mutex};
+    ++count;
+    done_cv.notify_all();
+    done_cv.wait(lk, [&]{ return count == n; });
+  };
+
+  const auto stream = [&](const std::size_t index)
+  {
+    auto& conn = *handles[index];
+    auto& channel = channels[index];
+    auto& stat = stats[index];
+    bool is_transaction{};
+    Copier copier;
+    try {
+      conn.execute("begin");
+      is_transaction = true;
+      const auto started = Clock::now();
+      conn.execute(statement_);
+      copier = conn.copier();
+      if (!copier)
+        throw Client_exception{"cannot load via parallel copier: "
+          "statement is not COPY FROM STDIN"};
+
+      Buffered_copier out{copier, batch_size_};
+      while (true) {
+        std::string batch;
+        {
+          std::unique_lock lk{channel.mutex};
+          channel.cv.wait(lk, [&]
+          {
+            return !channel.batches.empty() || channel.is_closed || is_failed;
+          });
+          if (is_failed || channel.batches.empty())
+            break;
+          batch = std::move(channel.batches.front());
+          channel.batches.pop_front();
+        }
+        channel.cv.notify_all();
+        out.append(batch);
+        stat.byte_count += batch.size();
+      }
+
+      if (is_failed)
+        throw Client_exception{"parallel COPY aborted"};
+
+      out.finish();
+      conn.wait_response_throw();
+      stat.duration = Clock::now() - started;
+    } catch (...) {
+      if (copier) {
+        try {
+          copier.end("parallel COPY aborted");
+        } catch (...) {}
+      }
+      fail(std::current_exception());
+    }
+
+    wait_others(done_count);
+
+    // Phase one of the two-phase commit.
+    std::string gid;
+    if (is_transaction) {
+      try {
+        // Dismiss the response to the aborted COPY if any.
+        conn.process_responses([](Row&&, Error&&){});
+        if (is_two_phase && !is_failed) {
+          gid.assign("dmitigr_pgfe_parallel_copier_")
+            .append(std::to_string(conn.server_pid())).append("_")
+            .append(std::to_string(Clock::now().time_since_epoch().count()));
+          // The transaction is ended by PREPARE TRANSACTION in any case.
+          is_transaction = false;
+          conn.execute("prepare transaction '" + gid + "'");
+        }
+      } catch (...) {
+        gid.clear();
+        fail(std::current_exception());
+      }
+    }
+    if (is_two_phase)
+      wait_others(prepared_count);
+
+    try {
+      if (!gid.empty()) {
+        conn.execute((is_failed ? "rollback" : "commit")
+          + std::string{" prepared '"} + gid + "'");
+        stat.is_committed = !is_failed;
+      } else if (is_transaction) {
+        const auto comp = conn.execute(is_failed ? "rollback" : "commit");
+        stat.is_committed = comp.tag() == "COMMIT";
+      }
+    } catch (...) {
+      fail(std::current_exception());
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(n);
+  try {
+    for (std::size_t i{}; i < n; ++i)
+      threads.emplace_back(stream, i);
+  } catch (...) {
+    fail(std::current_exception());
+    // Release the started streams from the commit barriers.
+    {
+      const std::lock_guard lg{done_mutex};
+      done_count += n - threads.size();
+      prepared_count += n - threads.size();
+    }
+    done_cv.notify_all();
+  }
+
+  // Produce the rows.
+  if (threads.size() == n) {
+    const auto push = [&](const std::size_t index, std::string&& batch)
+    {
+      auto& channel = channels[index];
+      {
+        std::unique_lock lk{channel.mutex};
+        channel.cv.wait(lk, [&]
+        {
+          return channel.batches.size() < queue_capacity_ || is_failed;
+        });
+        if (is_failed)
+          return;
+        channel.batches.push_back(std::move(batch));
+      }
+      channel.cv.notify_all();
+    };
+
+    try {
+      std::vector<std::string> batches(n);
+      std::string row;
+      while (!is_failed && producer(row)) {
+        const std::size_t index{partitioner(row) % n};
+        auto& batch = batches[index];
+        batch.append(row);
+        ++stats[index].row_count;
+        if (batch.size() >= batch_size_) {
+          push(index, std::move(batch));
+          batch = {};
+        }
+      }
+      for (std::size_t i{}; i < n; ++i) {
+        if (!batches[i].empty())
+          push(i, std::move(batches[i]));
+      }
+    } catch (...) {
+      fail(std::current_exception());
+    }
+  }
+
+  for (auto& channel : channels) {
+    {
+      const std::lock_guard lg{channel.mutex};
+      channel.is_closed = true;
+    }
+    channel.cv.notify_all();
+  }
+
+  for (auto& thread : threads)
+    thread.join();
+
+  last_stream_stats_ = stats;
+  if (error)
+    std::rethrow_exception(error);
+
+  return stats;
+}
+
+} // namespace dmitigr::pgfe
@@ -0,0 +1,196 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DMITIGR_PGFE_PARALLEL_COPIER_HPP
+#define DMITIGR_PGFE_PARALLEL_COPIER_HPP
+
+#include "dll.hpp"
+#include "types_fwd.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dmitigr::pgfe {
+
+/**
+ * @ingroup utilities
+ *
+ * @brief A loader of data which streams the partitions of the data through
+ * the concurrent `COPY ... FROM STDIN` commands.
+ *
+ * @details The rows are obtained from the producer on the calling thread, are
+ * dispatched to the partitions by the partitioner and are batched. Each
+ * partition is streamed by its own thread through its own connection obtained
+ * from the Connection_pool. Each stream is executed in its own transaction. If
+ * any stream fails, the `COPY` commands of the others are aborted by using
+ * Copier::end() with the error message, all the transactions are rolled back
+ * and the first error is rethrown on the calling thread.
+ *
+ * By default, the transactions are committed independently once all of the
+ * streams are succeeded. Thus, the failure of `COMMIT` of one stream (for
+ * example, because of a deferred constraint or a disconnection) doesn't undo
+ * the others, which may be already committed. Use last_stream_stats() to find
+ * out which streams are committed. With the two-phase commit enabled, each
+ * transaction is prepared by using `PREPARE TRANSACTION` and all of them are
+ * committed by using `COMMIT PREPARED` only if all of them are prepared, which
+ * makes the load atomic unless `COMMIT PREPARED` itself fails (in which case
+ * the transaction stays prepared on the server).
+ *
+ * @remarks The rows must be in either text or CSV format of `COPY` (including
+ * the trailing newline), since each stream receives an arbitrary subset of them.
+ */
+class Parallel_copier final {
+public:
+  /**
+   * @brief The alias of the producer of rows.
+   *
+   * @details The producer should assign the next row to its argument and return
+   * `true`, or return `false` if there are no more rows.
+   */
+  using Producer = std::function<bool(std::string&)>;
+
+  /**
+   * @brief The alias of the partitioner.
+   *
+   * @details The partitioner should return the index of the partition for the
+   * given row. The result is taken modulo the number of streams.
+   */
+  using Partitioner = std::function<std::size_t(std::string_view)>;
+
+  /// The statistics of a stream.
+  struct Stream_stats final {
+    /// The number of rows sent.
+    std::size_t row_count{};
+
+    /// The number of bytes sent.
+    std::size_t byte_count{};
+
+    /// The time elapsed from the start of `COPY` until its completion.
+    std::chrono::nanoseconds duration{};
+
+    /// `true` if the transaction of the stream is committed.
+    bool is_committed{};
+
+    /// @returns The throughput of the stream in bytes per second.
+    double bytes_per_second() const noexcept
+    {
+      const auto seconds = std::chrono::duration<double>{duration}.count();
+      return seconds > 0 ? byte_count / seconds : 0;
+    }
+
+    /// @returns The throughput of the stream in rows per second.
+    double rows_per_second() const noexcept
+    {
+      const auto seconds = std::chrono::duration<double>{duration}.count();
+      return seconds > 0 ? row_count / seconds : 0;
+    }
+  };
+
+  /**
+   * @brief The constructor.
+   *
+   * @param pool The pool to obtain connections from.
+   * @param statement The `COPY ... FROM STDIN` statement executed by each stream.
+   * @param stream_count The number of concurrent streams.
+   *
+   * @par Requires
+   * `stream_count > 0 && stream_count <= pool.size()`.
+   *
+   * @remarks The `pool` must outlive the instance.
+   */
+  DMITIGR_PGFE_API Parallel_copier(Connection_pool& pool,
+    std::string statement, std::size_t stream_count);
+
+  /// @returns The number of concurrent streams.
+  DMITIGR_PGFE_API std::size_t stream_count() const noexcept;
+
+  /**
+   * @brief Sets the size of batches of rows passed to the streams.
+   *
+   * @par Requires
+   * `value > 0`.
+   */
+  DMITIGR_PGFE_API Parallel_copier& set_batch_size(std::size_t value);
+
+  /// @returns The size of batches of rows passed to the streams.
+  DMITIGR_PGFE_API std::size_t batch_size() const noexcept;
+
+  /**
+   * @brief Sets the maximum number of batches queued for each stream.
+   *
+   * @par Requires
+   * `value > 0`.
+   */
+  DMITIGR_PGFE_API Parallel_copier& set_queue_capacity(std::size_t value);
+
+  /// @returns The maximum number of batches queued for each stream.
+  DMITIGR_PGFE_API std::size_t queue_capacity() const noexcept;
+
+  /**
+   * @brief Enables or disables the two-phase commit of the streams.
+   *
+   * @par Requires
+   * `max_prepared_transactions` of the server must be at least `stream_count()`
+   * if `value` is `true`.
+   */
+  DMITIGR_PGFE_API Parallel_copier& set_two_phase_commit_enabled(bool value);
+
+  /// @returns `true` if the two-phase commit of the streams is enabled.
+  DMITIGR_PGFE_API bool is_two_phase_commit_enabled() const noexcept;
+
+  /**
+   * @brief Loads the rows obtained from the `producer`.
+   *
+   * @returns The statistics of each stream.
+   *
+   * @par Requires
+   * `producer && partitioner` and the pool must have `stream_count()` free
+   * connections.
+   *
+   * @throws The first exception thrown by either producer, partitioner or any
+   * of the streams.
+   */
+  DMITIGR_PGFE_API std::vector<Stream_stats> load(const Producer& producer,
+    const Partitioner& partitioner);
+
+  /**
+   * @returns The statistics of each stream of the last call of load(), even if
+   * it's failed.
+   */
+  DMITIGR_PGFE_API const std::vector<Stream_stats>&
+  last_stream_stats() const noexcept;
+
+private:
+  Connection_pool& pool_;
+  std::string statement_;
+  std::size_t stream_count_{};
+  std::size_t batch_size_{65536};
+  std::size_t queue_capacity_{8};
+  bool is_two_phase_commit_enabled_{};
+  std::vector<Stream_stats> last_stream_stats_;
+};
+
+} // namespace dmitigr::pgfe
+
+#ifndef DMITIGR_PGFE_NOT_HEADER_ONLY
+#include "parallel_copier.cpp"
+#endif
+
+#endif  // DMITIGR_PGFE_PARALLEL_COPIER_HPP
@@ -0,0 +1,394 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "connection.hpp"
+#include "connection_pool.hpp"
+#include "conversions.hpp"
+#include "exceptions.hpp"
+#include "large_object.hpp"
+#include "parallel_large_object_transfer.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace dmitigr::pgfe {
+
+namespace detail {
+
+/// A file accessed by the positional I/O.
+class Large_object_transfer_file final {
+public:
+  Large_object_transfer_file(const std::filesystem::path& path,
+    const bool is_output)
+  {
+#ifdef _WIN32
+    fd_ = ::_wopen(path.c_str(), _O_BINARY |
+      (is_output ? _O_WRONLY | _O_CREAT | _O_TRUNC : _O_RDONLY),
+      _S_IREAD | _S_IWRITE);
+#else
+    fd_ = ::open(path.c_str(),
+      is_output ? O_WRONLY | O_CREAT | O_TRUNC : O_RDONLY, 0666);
+#endif
+    if (fd_ < 0)
+      throw std::system_error{errno, std::system_category(),
+        "cannot open file " + path.string()};
+  }
+
+  ~Large_object_transfer_file()
+  {
+#ifdef _WIN32
+    ::_close(fd_);
+#else
+    ::close(fd_);
+#endif
+  }
+
+  Large_object_transfer_file(const Large_object_transfer_file&) = delete;
+  Large_object_transfer_file& operator=(const Large_object_transfer_file&) = delete;
+
+  void resize(const std::int_fast64_t size)
+  {
+#ifdef _WIN32
+    if (const int err = ::_chsize_s(fd_, size))
+      throw std::system_error{err, std::system_category(),
+        "cannot resize file"};
+#else
+    if (::ftruncate(fd_, static_cast<::off_t>(size)))
+      throw std::system_error{errno, std::system_category(),
+        "cannot resize file"};
+#endif
+  }
+
+  void write_at(const char* data, std::size_t size, std::int_fast64_t offset)
+  {
+    while (size) {
+#ifdef _WIN32
+      const std::lock_guard lg{mutex_};
+      const int count{::_lseeki64(fd_, offset, SEEK_SET) < 0 ? -1 :
+        ::_write(fd_, data, static_cast<unsigned>(size))};
+#else
+      const auto count = ::pwrite(fd_, data, size, static_cast<::off_t>(offset));
+      if (count < 0 && errno == EINTR)
+        continue;
+#endif
+      if (count < 0)
+        throw std::system_error{errno, std::system_category(),
+          "cannot write file"};
+      data += count;
+      size -= static_cast<std::size_t>(count);
+      offset += count;
+    }
+  }
+
+  std::size_t read_at(char* const data, const std::size_t size,
+    const std::int_fast64_t offset)
+  {
+    while (true) {
+#ifdef _WIN32
+      const std::lock_guard lg{mutex_};
+      const int count{::_lseeki64(fd_, offset, SEEK_SET) < 0 ? -1 :
+        ::_read(fd_, data, static_cast<unsigned>(size))};
+#else
+      const auto count = ::pread(fd_, data, size, static_cast<::off_t>(offset));
+      if (count < 0 && errno == EINTR)
+        continue;
+#endif
+      if (count < 0)
+        throw std::system_error{errno, std::system_category(),
+          "cannot read file"};
+      return static_cast<std::size_t>(count);
+    }
+  }
+
+private:
+  int fd_{-1};
+#ifdef _WIN32
+  std::mutex mutex_;
+#endif
+};
+
+/**
+ * @brief Runs `stream(i)` for each `i` in `[0, count)` on the separate
+ * threads.
+ *
+ * @returns The first exception thrown.
+ */
+template<typename F>
+std::exception_ptr run_large_object_streams(const std::size_t count,
+  const F& stream)
+{
+  std::mutex mutex;
+  std::exception_ptr error;
+  const auto run = [&](const std::size_t index)
+  {
+    try {
+      stream(index);
+    } catch (...) {
+      const std::lock_guard lg{mutex};
+      if (!error)
+        error = std::current_exception();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(count);
+  try {
+    for (std::size_t i{}; i < count; ++i)
+      threads.emplace_back(run, i);
+  } catch (...) {
+    const std::lock_guard lg{mutex};
+    if (!error)
+      error = std::current_exception();
+  }
+  for (auto& thread : threads)
+    thread.join();
+  return error;
+}
+
+} // namespace detail
+
+DMITIGR_PGFE_INLINE
+Parallel_large_object_transfer::Parallel_large_object_transfer(
+  Connection_pool& pool, const std::size_t stream_count)
+  : pool_{pool}
+  , stream_count_{stream_count}
+{
+  if (!stream_count_)
+    throw Client_exception{"cannot create parallel large object transfer: "
+      "invalid stream count"};
+  else if (stream_count_ > pool_.size())
+    throw Client_exception{"cannot create parallel large object transfer: "
+      "stream count is greater than the size of connection pool"};
+}
+
+DMITIGR_PGFE_INLINE std::size_t
+Parallel_large_object_transfer::stream_count() const noexcept
+{
+  return stream_count_;
+}
+
+DMITIGR_PGFE_INLINE Parallel_large_object_transfer&
+Parallel_large_object_transfer::set_chunk_size(const std::size_t value)
+{
+  if (!value || value % 8192 ||
+    value > static_cast<std::size_t>(std::numeric_limits<int>::max()))
+    throw Client_exception{"cannot set parallel large object transfer chunk "
+      "size: invalid value"};
+  chunk_size_ = value;
+  return *this;
+}
+
+DMITIGR_PGFE_INLINE std::size_t
+Parallel_large_object_transfer::chunk_size() const noexcept
+{
+  return chunk_size_;
+}
+
+DMITIGR_PGFE_INLINE Oid
+Parallel_large_object_transfer::import_file(
+  const std::filesystem::path& filename, const Oid oid)
+{
+  const auto size = static_cast<std::int_fast64_t>(
+    std::filesystem::file_size(filename));
+  detail::Large_object_transfer_file file{filename, false};
+
+  auto handles = connections();
+  const std::size_t n{handles.size()};
+  auto& main = *handles.front();
+  const Oid result{main.create_large_object(oid)};
+
+  const auto range = range_size(size);
+  auto error = detail::run_large_object_streams(n, [&](const std::size_t index)
+  {
+    auto& conn = *handles[index];
+    conn.execute("begin");
+    const auto begin = std::min<std::int_fast64_t>(index * range, size);
+    const auto end = std::min<std::int_fast64_t>(begin + range, size);
+    if (begin == end)
+      return;
+
+    auto lob = conn.open_large_object(result, Large_object_open_mode::writing);
+    lob.seek(begin, Large_object_seek_whence::begin);
+    const std::unique_ptr<char[]> buffer{new char[chunk_size_]};
+    for (auto pos = begin; pos < end;) {
+      const auto count = file.read_at(buffer.get(), std::min<std::size_t>(
+          chunk_size_, static_cast<std::size_t>(end - pos)), pos);
+      if (!count)
+        throw Client_exception{"cannot import large object: "
+          "unexpected end of file"};
+      for (std::size_t offset{}; offset < count;) {
+        const auto written = lob.write(buffer.get() + offset, count - offset);
+        if (!written)
+          throw Client_exception{"cannot import large object: "
+            "cannot write large object"};
+        offset += written;
+      }
+      pos += static_cast<std::int_fast64_t>(count);
+    }
+    lob.close();
+  });
+
+  if (!error)
+    error = complete(handles, false);
+  else
+    complete(handles, true);
+
+  if (error) {
+    try {
+      main.remove_large_object(result);
+    } catch (...) {}
+    std::rethrow_exception(error);
+  }
+  return result;
+}
+
+DMITIGR_PGFE_INLINE void
+Parallel_large_object_transfer::export_file(const Oid oid,
+  const std::filesystem::path& filename)
+{
+  auto handles = connections();
+  const std::size_t n{handles.size()};
+  std::int_fast64_t size{};
+  std::unique_ptr<detail::Large_object_transfer_file> file;
+  std::exception_ptr error;
+  try {
+    // Share the snapshot of the first transaction with the others.
+    static const char* const begin_query{"begin isolation level repeatable"
+      " read, read only"};
+    auto& main = *handles.front();
+    main.execute(begin_query);
+    std::string snapshot;
+    main.execute([&snapshot](auto&& row)
+    {
+      snapshot = to<std::string>(row[0]);
+    }, "select pg_export_snapshot()");
+    {
+      auto lob = main.open_large_object(oid, Large_object_open_mode::reading);
+      size = lob.seek(0, Large_object_seek_whence::end);
+      lob.close();
+    }
+    for (std::size_t i{1}; i < n; ++i) {
+      auto& conn = *handles[i];
+      conn.execute(begin_query);
+      conn.execute("set transaction snapshot "+conn.to_quoted_literal(snapshot));
+    }
+
+    file = std::make_unique<detail::Large_object_transfer_file>(filename, true);
+    file->resize(size);
+  } catch (...) {
+    error = std::current_exception();
+  }
+
+  const auto range = range_size(size);
+  if (!error) {
+    error = detail::run_large_object_streams(n, [&](const std::size_t index)
+    {
+      const auto begin = std::min<std::int_fast64_t>(index * range, size);
+      const auto end = std::min<std::int_fast64_t>(begin + range, size);
+      if (begin == end)
+        return;
+
+      auto& conn = *handles[index];
+      auto lob = conn.open_large_object(oid, Large_object_open_mode::reading);
+      lob.seek(begin, Large_object_seek_whence::begin);
+      const std::unique_ptr<char[]> buffer{new char[chunk_size_]};
+      for (auto pos = begin; pos < end;) {
+        const auto count = lob.read(buffer.get(), std::min<std::size_t>(
+            chunk_size_, static_cast<std::size_t>(end - pos)));
+        if (!count)
+          throw Client_exception{"cannot export large object: "
+            "unexpected end of large object"};
+        file->write_at(buffer.get(), count, pos);
+        pos += static_cast<std::int_fast64_t>(count);
+      }
+      lob.close();
+    });
+  }
+
+  if (!error)
+    error = complete(handles, false);
+  else
+    complete(handles, true);
+
+  file.reset();
+  if (error) {
+    std::error_code ec;
+    std::filesystem::remove(filename, ec);
+    std::rethrow_exception(error);
+  }
+}
+
+DMITIGR_PGFE_INLINE std::vector<Connection_pool::Handle>
+Parallel_large_object_transfer::connections()
+{
+  std::vector<Connection_pool::Handle> result;
+  result.reserve(stream_count_);
+  for (std::size_t i{}; i < stream_count_; ++i) {
+    if (auto handle = pool_.connection())
+      result.push_back(std::move(handle));
+    else
+      throw Client_exception{"cannot transfer large object: "
+        "not enough free connections in the pool"};
+  }
+  return result;
+}
+
+DMITIGR_PGFE_INLINE std::int_fast64_t
+Parallel_large_object_transfer::range_size(const std::int_fast64_t size) const
+{
+  const auto chunk_size = static_cast<std::int_fast64_t>(chunk_size_);
+  const auto n = static_cast<std::int_fast64_t>(stream_count_);
+  const auto chunk_count = (size + chunk_size - 1) / chunk_size;
+  return std::max<std::int_fast64_t>(1, (chunk_count + n - 1) / n) * chunk_size;
+}
+
+DMITIGR_PGFE_INLINE std::exception_ptr
+Parallel_large_object_transfer::complete(
+  std::vector<Connection_pool::Handle>& handles, const bool is_failed) noexcept
+{
+  std::exception_ptr error;
+  for (auto& handle : handles) {
+    try {
+      const auto status = handle->transaction_status();
+      if (status && *status != Transaction_status::unstarted)
+        handle->execute(is_failed || error ? "rollback" : "commit");
+    } catch (...) {
+      if (!error)
+        error = std::current_exception();
+    }
+  }
+  return error;
+}
+
+} // namespace dmitigr::pgfe
@@ -0,0 +1,130 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DMITIGR_PGFE_PARALLEL_LARGE_OBJECT_TRANSFER_HPP
+#define DMITIGR_PGFE_PARALLEL_LARGE_OBJECT_TRANSFER_HPP
+
+#include "basics.hpp"
+#include "connection_pool.hpp"
+#include "dll.hpp"
+#include "types_fwd.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <vector>
+
+namespace dmitigr::pgfe {
+
+/**
+ * @ingroup utilities
+ *
+ * @brief A transfer of large objects between the server and files which is
+ * performed by the several connections of the Connection_pool concurrently.
+ *
+ * @details The large object (or file) is split into the ranges, and each range
+ * is transferred by its own thread through its own connection in chunks by
+ * using Large_object::seek(), Large_object::read() and Large_object::write().
+ * The file is accessed by using the positional I/O (`pread()`/`pwrite()`).
+ *
+ * The export is performed in the transactions of isolation level `REPEATABLE
+ * READ` which share the same snapshot (see `pg_export_snapshot()`), so all of
+ * the ranges are consistent. The file is preallocated to the size of the large
+ * object and is removed on failure.
+ *
+ * The import creates the large object in the separate transaction first, and
+ * then each range is written in the own transaction of each stream. These
+ * transactions are committed only if all of the streams are succeeded. On
+ * failure, the created large object is removed.
+ *
+ * @remarks The boundaries of the ranges are aligned to the chunk size, so the
+ * streams never modify the same page of the large object.
+ */
+class Parallel_large_object_transfer final {
+public:
+  /**
+   * @brief The constructor.
+   *
+   * @param pool The pool to obtain connections from.
+   * @param stream_count The number of concurrent streams.
+   *
+   * @par Requires
+   * `stream_count > 0 && stream_count <= pool.size()`.
+   *
+   * @remarks The `pool` must outlive the instance.
+   */
+  DMITIGR_PGFE_API Parallel_large_object_transfer(Connection_pool& pool,
+    std::size_t stream_count);
+
+  /// @returns The number of concurrent streams.
+  DMITIGR_PGFE_API std::size_t stream_count() const noexcept;
+
+  /**
+   * @brief Sets the size of chunks transferred by a single round trip.
+   *
+   * @par Requires
+   * `value` must be a positive multiple of `8192` (the maximum size of the page
+   * of large objects) which is not greater than `std::numeric_limits<int>::max()`.
+   */
+  DMITIGR_PGFE_API Parallel_large_object_transfer& set_chunk_size(
+    std::size_t value);
+
+  /// @returns The size of chunks transferred by a single round trip.
+  DMITIGR_PGFE_API std::size_t chunk_size() const noexcept;
+
+  /**
+   * @brief Imports the file as a large object.
+   *
+   * @returns The OID of the new large object.
+   *
+   * @par Requires
+   * The pool must have `stream_count()` free connections.
+   *
+   * @throws The first exception thrown by any of the streams.
+   */
+  DMITIGR_PGFE_API Oid import_file(const std::filesystem::path& filename,
+    Oid oid = invalid_oid);
+
+  /**
+   * @brief Exports the large object to the file.
+   *
+   * @par Requires
+   * The pool must have `stream_count()` free connections.
+   *
+   * @throws The first exception thrown by any of the streams.
+   */
+  DMITIGR_PGFE_API void export_file(Oid oid,
+    const std::filesystem::path& filename);
+
+private:
+  Connection_pool& pool_;
+  std::size_t stream_count_{};
+  std::size_t chunk_size_{4194304};
+
+  std::vector<Connection_pool::Handle> connections();
+  std::int_fast64_t range_size(std::int_fast64_t size) const;
+  static std::exception_ptr complete(
+    std::vector<Connection_pool::Handle>& handles, bool is_failed) noexcept;
+};
+
+} // namespace dmitigr::pgfe
+
+#ifndef DMITIGR_PGFE_NOT_HEADER_ONLY
+#include "parallel_large_object_transfer.cpp"
+#endif
+
+#endif  // DMITIGR_PGFE_PARALLEL_LARGE_OBJECT_TRANSFER_HPP
@@ -21,6 +21,9 @@
 #include "array_conversions.hpp"
 #include "basics.hpp"
 #include "basic_conversions.hpp"
+#include "binary_copy_reader.hpp"
+#include "binary_copy_writer.hpp"
+#include "buffered_copier.hpp"
 #include "completion.hpp"
 #include "composite.hpp"
 #include "compositional.hpp"
@@ -31,17 +34,23 @@
 #include "conversions.hpp"
 #include "conversions_api.hpp"
 #include "copier.hpp"
+#include "copy_exporter.hpp"
 #include "data.hpp"
 #include "errc.hpp"
 #include "errctg.hpp"
 #include "error.hpp"
 #include "exceptions.hpp"
 #include "large_object.hpp"
+#include "large_object_streambuf.hpp"
 #include "message.hpp"
 #include "misc.hpp"
 #include "notice.hpp"
 #include "notification.hpp"
+#include "parallel_copier.hpp"
+#include "parallel_large_object_transfer.hpp"
 #include "parameterizable.hpp"
+#include "pipeline_executor.hpp"
+#include "pipelined_large_object.hpp"
 #include "prepared_statement.hpp"
 #include "problem.hpp"
 #include "ready_for_query.hpp"
@@ -51,6 +60,7 @@
 #include "signal.hpp"
 #include "statement.hpp"
 #include "statement_vector.hpp"
+#include "text_copy_writer.hpp"
 #include "transaction_guard.hpp"
 #include "tuple.hpp"
 #include "types_fwd.hpp"
@@ -0,0 +1,405 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "../base/assert.hpp"
+#include "exceptions.hpp"
+#include "pipeline_executor.hpp"
+
+#include <cassert>
+
+namespace dmitigr::pgfe {
+
+// -----------------------------------------------------------------------------
+// Handle
+// -----------------------------------------------------------------------------
+
+DMITIGR_PGFE_INLINE
+Pipeline_executor::Handle::Handle(std::shared_ptr<State> state,
+  std::shared_ptr<Pipeline_executor*> executor) noexcept
+  : state_{std::move(state)}
+  , executor_{std::move(executor)}
+{}
+
+DMITIGR_PGFE_INLINE bool Pipeline_executor::Handle::is_valid() const noexcept
+{
+  return static_cast<bool>(state_);
+}
+
+DMITIGR_PGFE_INLINE bool Pipeline_executor::Handle::is_ready() const
+{
+  if (!is_valid())
+    throw Client_exception{"invalid pipeline executor handle"};
+  return state_->is_ready;
+}
+
+DMITIGR_PGFE_INLINE void Pipeline_executor::Handle::wait()
+{
+  if (is_ready())
+    return;
+  else if (!*executor_)
+    throw Client_exception{"cannot wait pipeline executor handle: "
+      "executor is destroyed"};
+
+  (*executor_)->wait__(*state_);
+  DMITIGR_ASSERT(state_->is_ready);
+}
+
+DMITIGR_PGFE_INLINE const Completion& Pipeline_executor::Handle::completion()
+{
+  wait();
+  if (state_->exception)
+    std::rethrow_exception(state_->exception);
+  return state_->completion;
+}
+
+DMITIGR_PGFE_INLINE std::vector<Row>& Pipeline_executor::Handle::rows()
+{
+  wait();
+  if (state_->exception)
+    std::rethrow_exception(state_->exception);
+  return state_->rows;
+}
+
+DMITIGR_PGFE_INLINE std::exception_ptr Pipeline_executor::Handle::exception()
+{
+  wait();
+  return state_->exception;
+}
+
+// -----------------------------------------------------------------------------
+// Pipeline_executor
+// -----------------------------------------------------------------------------
+
+DMITIGR_PGFE_INLINE Pipeline_executor::~Pipeline_executor() noexcept
+{
+  *self_ = nullptr;
+}
+
+DMITIGR_PGFE_INLINE Pipeline_executor::Pipeline_executor(Connection& connection)
+  : self_{std::make_shared<Pipeline_executor*>(this)}
+  , connection_{connection}
+{
+  if (!connection_.is_connected())
+    throw Client_exception{"cannot create pipeline executor: not connected"};
+
+  if (connection_.pipeline_status() == Pipeline_status::disabled)
+    connection_.set_pipeline_enabled(true);
+  connection_.set_nio_output_enabled(true);
+  assert(is_invariant_ok());
+}
+
+DMITIGR_PGFE_INLINE Connection& Pipeline_executor::connection() noexcept
+{
+  return connection_;
+}
+
+DMITIGR_PGFE_INLINE const Connection&
+Pipeline_executor::connection() const noexcept
+{
+  return connection_;
+}
+
+DMITIGR_PGFE_INLINE Pipeline_executor&
+Pipeline_executor::set_sync_count(const std::size_t value)
+{
+  if (!value)
+    throw Client_exception{"cannot set pipeline executor sync count: "
+      "invalid value"};
+  sync_count_ = value;
+  return *this;
+}
+
+DMITIGR_PGFE_INLINE std::size_t Pipeline_executor::sync_count() const noexcept
+{
+  return sync_count_;
+}
+
+DMITIGR_PGFE_INLINE Pipeline_executor&
+Pipeline_executor::set_sync_bytes(const std::size_t value)
+{
+  if (!value)
+    throw Client_exception{"cannot set pipeline executor sync bytes: "
+      "invalid value"};
+  sync_bytes_ = value;
+  return *this;
+}
+
+DMITIGR_PGFE_INLINE std::size_t Pipeline_executor::sync_bytes() const noexcept
+{
+  return sync_bytes_;
+}
+
+DMITIGR_PGFE_INLINE Pipeline_executor&
+Pipeline_executor::set_sync_interval(
+  const std::optional<std::chrono::microseconds> value)
+{
+  if (value && value->count() < 0)
+    throw Client_exception{"cannot set pipeline executor sync interval: "
+      "negative value"};
+  sync_interval_ = value;
+  return *this;
+}
+
+DMITIGR_PGFE_INLINE std::optional<std::chrono::microseconds>
+Pipeline_executor::sync_interval() const noexcept
+{
+  return sync_interval_;
+}
+
+DMITIGR_PGFE_INLINE void Pipeline_executor::sync()
+{
+  if (!unsynced_count_)
+    return;
+
+  queue_.emplace_back(); // can throw
+  try {
+    connection_.send_sync();
+  } catch (...) {
+    queue_.pop_back(); // rollback
+    throw;
+  }
+  unsynced_count_ = 0;
+  unsynced_bytes_ = 0;
+  connection_.flush_output();
+  assert(is_invariant_ok());
+}
+
+DMITIGR_PGFE_INLINE void Pipeline_executor::poll()
+{
+  if (sync_interval_ && unsynced_count_ &&
+    Clock::now() - unsynced_since_ >= *sync_interval_)
+    sync();
+  process_available__();
+}
+
+DMITIGR_PGFE_INLINE void Pipeline_executor::finish()
+{
+  sync();
+  while (!queue_.empty()) {
+    flush_output__();
+    if (!connection_.has_uncompleted_request())
+      throw Client_exception{"cannot finish pipeline executor: "
+        "no response to wait"};
+    connection_.wait_response();
+    process_response__();
+  }
+  assert(is_invariant_ok());
+}
+
+DMITIGR_PGFE_INLINE std::size_t
+Pipeline_executor::unprocessed_count() const noexcept
+{
+  std::size_t result{};
+  for (const auto& state : queue_)
+    result += static_cast<bool>(state);
+  return result;
+}
+
+DMITIGR_PGFE_INLINE bool Pipeline_executor::is_invariant_ok() const noexcept
+{
+  const bool self_ok = self_ && *self_ == this;
+  const bool unsynced_ok = unsynced_count_ || !unsynced_bytes_;
+  return self_ok && unsynced_ok;
+}
+
+DMITIGR_PGFE_INLINE auto
+Pipeline_executor::make_state__(Row_handler&& callback) -> std::shared_ptr<Handle::State>
+{
+  if (!connection_.is_connected())
+    throw Client_exception{"cannot execute statement via pipeline executor: "
+      "not connected"};
+
+  auto result = std::make_shared<Handle::State>();
+  result->row_handler = std::move(callback);
+  queue_.push_back(result); // can throw
+  return result;
+}
+
+DMITIGR_PGFE_INLINE auto
+Pipeline_executor::submitted__(std::shared_ptr<Handle::State>&& state,
+  const std::size_t size, const bool is_sync_allowed) -> Handle
+{
+  if (!unsynced_count_)
+    unsynced_since_ = Clock::now();
+  ++unsynced_count_;
+  unsynced_bytes_ += size;
+
+  Handle result{std::move(state), self_};
+  if (is_sync_allowed && (unsynced_count_ >= sync_count_ ||
+      unsynced_bytes_ >= sync_bytes_ ||
+      (sync_interval_ && Clock::now() - unsynced_since_ >= *sync_interval_)))
+    sync();
+
+  // Keep the input drained to prevent the deadlock of the full socket buffers.
+  process_available__();
+
+  assert(is_invariant_ok());
+  return result;
+}
+
+DMITIGR_PGFE_INLINE auto
+Pipeline_executor::execute__(const Statement_vector& statements,
+  const Completion_handler& handler, const Pipeline_error_policy on_error,
+  const std::vector<const Named_argument*>& arguments) -> std::vector<Handle>
+{
+  const bool is_isolated{on_error == Pipeline_error_policy::isolate};
+  std::vector<Handle> result(statements.size());
+
+  // Separate the statements from the previously submitted ones.
+  sync();
+
+  for (std::size_t i{}; i < statements.size(); ++i) {
+    const auto& statement = statements[i];
+    if (statement.is_query_empty())
+      continue;
+
+    auto state = make_state__({});
+    try {
+      connection_.execute_nio__(statement, arguments);
+    } catch (...) {
+      queue_.pop_back(); // rollback
+      throw;
+    }
+    result[i] = submitted__(std::move(state), message_size_estimate__, false);
+    if (is_isolated)
+      sync();
+  }
+  sync();
+
+  std::exception_ptr error;
+  for (std::size_t i{}; i < result.size(); ++i) {
+    auto& handle = result[i];
+    if (!handle)
+      continue;
+
+    handle.wait();
+    if (!is_isolated && error)
+      continue; // skipped by the server
+    else if (!is_isolated && handle.state_->exception)
+      error = handle.state_->exception;
+    else if (handler)
+      handler(i, handle);
+  }
+  if (error)
+    std::rethrow_exception(error);
+
+  assert(is_invariant_ok());
+  return result;
+}
+
+DMITIGR_PGFE_INLINE void Pipeline_executor::wait__(const Handle::State& state)
+{
+  /*
+   * The results of the statement are flushed by the server upon the sync
+   * message. So the sync message is sent here if the statement is not yet
+   * followed by it.
+   */
+  for (auto i = queue_.crbegin(); i != queue_.crend() && *i; ++i) {
+    if (i->get() == &state) {
+      sync();
+      break;
+    }
+  }
+
+  while (!state.is_ready) {
+    flush_output__();
+    if (!connection_.has_uncompleted_request())
+      throw Client_exception{"cannot wait pipeline executor handle: "
+        "no response to wait"};
+    connection_.wait_response();
+    process_response__();
+  }
+  assert(is_invariant_ok());
+}
+
+DMITIGR_PGFE_INLINE void Pipeline_executor::process_response__()
+{
+  DMITIGR_ASSERT(!queue_.empty());
+
+  const auto resolve = [this](std::exception_ptr exception = {})
+  {
+    auto& state = queue_.front();
+    DMITIGR_ASSERT(state);
+    if (exception && !state->exception)
+      state->exception = std::move(exception);
+    state->is_ready = true;
+    queue_.pop_front();
+  };
+
+  auto& state = queue_.front();
+  if (auto err = connection_.error()) {
+    resolve(std::make_exception_ptr(Server_exception{
+      std::make_shared<Error>(std::move(err))}));
+  } else if (auto row = connection_.row()) {
+    DMITIGR_ASSERT(state);
+    try {
+      if (state->row_handler)
+        state->row_handler(std::move(row));
+      else
+        state->rows.push_back(std::move(row));
+    } catch (...) {
+      if (!state->exception)
+        state->exception = std::current_exception();
+    }
+  } else if (!connection_.has_response()) {
+    // No response between the results of the pipelined statements.
+    return;
+  } else if (auto comp = connection_.completion()) {
+    if (comp.tag() == "invalid")
+      resolve(std::make_exception_ptr(
+          Client_exception{Client_errc::invalid_response}));
+    else {
+      state->completion = std::move(comp);
+      resolve();
+    }
+  } else if (connection_.ready_for_query()) {
+    DMITIGR_ASSERT(!state);
+    queue_.pop_front();
+  } else {
+    // The statement is skipped by the server due to the aborted pipeline.
+    resolve(std::make_exception_ptr(Client_exception{
+      Client_errc::pipeline_aborted,
+      "statement skipped: pipeline aborted by a previous error"}));
+  }
+}
+
+/*
+ * Unlike Connection::flush_output(true), doesn't wait for the input after the
+ * output is flushed, since the input may be already consumed by libpq.
+ */
+DMITIGR_PGFE_INLINE void Pipeline_executor::flush_output__()
+{
+  using Sr = Socket_readiness;
+  while (!connection_.flush_output()) {
+    const auto sr = connection_.wait_socket_readiness(
+      Sr::read_ready | Sr::write_ready);
+    if ((sr & Sr::read_ready) == Sr::read_ready)
+      connection_.read_input();
+  }
+}
+
+DMITIGR_PGFE_INLINE void Pipeline_executor::process_available__()
+{
+  connection_.flush_output();
+  using Sr = Socket_readiness;
+  if (connection_.socket_readiness(Sr::read_ready) == Sr::read_ready)
+    connection_.read_input();
+  while (!queue_.empty() && connection_.has_uncompleted_request() &&
+    connection_.handle_input() != Response_status::unready)
+    process_response__();
+}
+
+} // namespace dmitigr::pgfe
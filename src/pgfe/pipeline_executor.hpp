@@ -0,0 +1,404 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DMITIGR_PGFE_PIPELINE_EXECUTOR_HPP
+#define DMITIGR_PGFE_PIPELINE_EXECUTOR_HPP
+
+#include "completion.hpp"
+#include "connection.hpp"
+#include "data.hpp"
+#include "dll.hpp"
+#include "row.hpp"
+#include "statement.hpp"
+#include "statement_vector.hpp"
+#include "types_fwd.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace dmitigr::pgfe {
+
+/**
+ * @ingroup main
+ *
+ * @brief An executor of statements in pipeline mode.
+ *
+ * @details Each statement submitted by execute() is sent to the server without
+ * waiting for the results of the previously submitted ones, and the returned
+ * Handle is resolved when its results arrive. Sync messages are sent
+ * automatically when either the number of the submitted statements, or the
+ * estimated amount of their data, or the time elapsed since the first of them
+ * was submitted reaches the corresponding limit. If a statement fails, the
+ * handles of the subsequent statements up to the next sync are resolved with
+ * Client_exception with the code Client_errc::pipeline_aborted.
+ *
+ * @remarks Functions of this class are not thread-safe.
+ */
+class Pipeline_executor final {
+public:
+  /// The alias of the row handler.
+  using Row_handler = std::function<void(Row&&)>;
+
+  class Handle;
+
+  /**
+   * @brief The alias of the handler of completion of a statement of
+   * Statement_vector.
+   *
+   * @details The handler is called with the index of the statement in the
+   * vector and its ready handle.
+   */
+  using Completion_handler = std::function<void(std::size_t, Handle&)>;
+
+  /// The handle of the submitted statement.
+  class Handle final {
+  public:
+    /// Default-constructible. (Constructs invalid instance.)
+    Handle() = default;
+
+    /// @returns `true` if the instance is valid.
+    DMITIGR_PGFE_API bool is_valid() const noexcept;
+
+    /// @returns `is_valid()`.
+    explicit operator bool() const noexcept
+    {
+      return is_valid();
+    }
+
+    /**
+     * @returns `true` if the results of the statement are available.
+     *
+     * @par Requires
+     * `is_valid()`.
+     */
+    DMITIGR_PGFE_API bool is_ready() const;
+
+    /**
+     * @brief Waits for the results of the statement.
+     *
+     * @details Sends a sync message if the statement is not yet followed by
+     * it, and processes the responses of the preceding statements.
+     *
+     * @par Requires
+     * `is_valid()` and the executor is alive.
+     */
+    DMITIGR_PGFE_API void wait();
+
+    /**
+     * @returns The completion of the statement.
+     *
+     * @details Calls wait() if `!is_ready()`.
+     *
+     * @throws Server_exception if the statement is failed, or Client_exception
+     * with the code Client_errc::pipeline_aborted if the statement is skipped
+     * by the server.
+     */
+    DMITIGR_PGFE_API const Completion& completion();
+
+    /**
+     * @returns The rows collected for the statement submitted without the
+     * row handler.
+     *
+     * @details Calls wait() if `!is_ready()`.
+     *
+     * @throws Same as completion().
+     */
+    DMITIGR_PGFE_API std::vector<Row>& rows();
+
+    /**
+     * @returns The exception the statement is failed with, or `nullptr`.
+     *
+     * @details Calls wait() if `!is_ready()`.
+     */
+    DMITIGR_PGFE_API std::exception_ptr exception();
+
+  private:
+    friend Pipeline_executor;
+
+    struct State final {
+      Row_handler row_handler;
+      std::vector<Row> rows;
+      Completion completion;
+      std::exception_ptr exception;
+      bool is_ready{};
+    };
+
+    std::shared_ptr<State> state_;
+    std::shared_ptr<Pipeline_executor*> executor_;
+
+    Handle(std::shared_ptr<State> state,
+      std::shared_ptr<Pipeline_executor*> executor) noexcept;
+  };
+
+  /**
+   * @brief The destructor.
+   *
+   * @details Invalidates the executor of each Handle instance. The results of
+   * the statements which are not yet processed are left in the connection.
+   */
+  DMITIGR_PGFE_API ~Pipeline_executor() noexcept;
+
+  /**
+   * @brief The constructor.
+   *
+   * @details Enables the pipeline and nonblocking output on the `connection`.
+   *
+   * @par Requires
+   * `connection.is_connected()`.
+   *
+   * @remarks The `connection` must outlive the instance.
+   */
+  explicit DMITIGR_PGFE_API Pipeline_executor(Connection& connection);
+
+  /// Not copy-constructible.
+  Pipeline_executor(const Pipeline_executor&) = delete;
+
+  /// Not copy-assignable.
+  Pipeline_executor& operator=(const Pipeline_executor&) = delete;
+
+  /// Not move-constructible.
+  Pipeline_executor(Pipeline_executor&&) = delete;
+
+  /// Not move-assignable.
+  Pipeline_executor& operator=(Pipeline_executor&&) = delete;
+
+  /// @returns The connection.
+  DMITIGR_PGFE_API Connection& connection() noexcept;
+
+  /// @overload
+  DMITIGR_PGFE_API const Connection& connection() const noexcept;
+
+  /**
+   * @brief Sets the maximum number of statements submitted between syncs.
+   *
+   * @par Requires
+   * `value > 0`.
+   */
+  DMITIGR_PGFE_API Pipeline_executor& set_sync_count(std::size_t value);
+
+  /// @returns The maximum number of statements submitted between syncs.
+  DMITIGR_PGFE_API std::size_t sync_count() const noexcept;
+
+  /**
+   * @brief Sets the maximum estimated amount of data (in bytes) of statements
+   * submitted between syncs.
+   *
+   * @par Requires
+   * `value > 0`.
+   */
+  DMITIGR_PGFE_API Pipeline_executor& set_sync_bytes(std::size_t value);
+
+  /// @returns The maximum estimated amount of data submitted between syncs.
+  DMITIGR_PGFE_API std::size_t sync_bytes() const noexcept;
+
+  /**
+   * @brief Sets the maximum amount of time between submitting the first
+   * statement after the sync and sending the next sync.
+   *
+   * @details The value of `std::nullopt` means *eternity*.
+   *
+   * @remarks The time limit is checked upon execute() and poll().
+   */
+  DMITIGR_PGFE_API Pipeline_executor&
+  set_sync_interval(std::optional<std::chrono::microseconds> value);
+
+  /// @returns The maximum amount of time between syncs.
+  DMITIGR_PGFE_API std::optional<std::chrono::microseconds>
+  sync_interval() const noexcept;
+
+  /**
+   * @brief Submits the `statement` for execution.
+   *
+   * @param callback The handler of rows. If `nullptr` the rows are collected
+   * by the returned handle.
+   *
+   * @returns The handle of the submitted statement.
+   *
+   * @par Requires
+   * `!statement.has_missing_parameters()`.
+   *
+   * @par Exception safety guarantee
+   * Basic. (Strong if the statement is not submitted.)
+   */
+  template<typename ... Types>
+  Handle execute(Row_handler callback, const Statement& statement,
+    Types&& ... parameters)
+  {
+    const std::size_t size = message_size_estimate__ +
+      (std::size_t{} + ... + size_estimate__(parameters));
+    auto state = make_state__(std::move(callback));
+    try {
+      connection_.execute_nio(statement, std::forward<Types>(parameters)...);
+    } catch (...) {
+      queue_.pop_back(); // rollback
+      throw;
+    }
+    return submitted__(std::move(state), size);
+  }
+
+  /// @overload
+  template<typename ... Types>
+  Handle execute(const Statement& statement, Types&& ... parameters)
+  {
+    return execute(Row_handler{}, statement, std::forward<Types>(parameters)...);
+  }
+
+  /**
+   * @brief Executes the `statements` without waiting for the results of each
+   * of them.
+   *
+   * @details All the statements are sent behind a single sync message (unless
+   * `on_error == Pipeline_error_policy::isolate`) which separates them from the
+   * previously submitted ones. The automatic syncs are not sent meanwhile.
+   * Each of `arguments` is bound to each statement which has the parameter
+   * with the same name. The rows of each statement are collected by its
+   * handle. The `handler`, if any, is called for each statement in order as
+   * soon as its results are available. Empty statements (consisting only of
+   * comments) are not sent, and their handles are invalid.
+   *
+   * If `on_error == Pipeline_error_policy::abort`, the statements which follow
+   * the failed one are skipped by the server, the `handler` is called neither
+   * for the failed statement nor for the skipped ones, and the exception of
+   * the failed statement is rethrown once the results of all the statements
+   * are processed.
+   *
+   * @returns The handles of the statements.
+   *
+   * @par Requires
+   * Each of `arguments` must be of type Named_argument, and each of the
+   * `statements` must not have missing parameters.
+   *
+   * @remarks If the `handler` throws, the results of the remaining statements
+   * are processed upon finish() or the waiting of their handles.
+   */
+  template<Pipeline_error_policy on_error = Pipeline_error_policy::abort,
+    typename ... Types>
+  std::vector<Handle> execute(const Statement_vector& statements,
+    const Completion_handler& handler, const Types& ... arguments)
+  {
+    static_assert((std::is_same_v<Types, Named_argument> && ...),
+      "only named arguments can be shared by the statements");
+    return execute__(statements, handler, on_error, {&arguments...});
+  }
+
+  /**
+   * @overload
+   *
+   * @details Allows the number of shared arguments to be known at runtime only.
+   */
+  template<Pipeline_error_policy on_error = Pipeline_error_policy::abort>
+  std::vector<Handle> execute(const Statement_vector& statements,
+    const Completion_handler& handler,
+    const std::vector<Named_argument>& arguments)
+  {
+    std::vector<const Named_argument*> args;
+    args.reserve(arguments.size());
+    for (const auto& argument : arguments)
+      args.push_back(&argument);
+    return execute__(statements, handler, on_error, args);
+  }
+
+  /**
+   * @brief Sends a sync message if there are statements submitted after the
+   * previous one.
+   */
+  DMITIGR_PGFE_API void sync();
+
+  /**
+   * @brief Sends the queued output and processes the responses which are
+   * available without blocking.
+   *
+   * @details Sends a sync message if the time limit is reached.
+   */
+  DMITIGR_PGFE_API void poll();
+
+  /**
+   * @brief Sends a sync message and processes the responses of all the
+   * submitted statements.
+   */
+  DMITIGR_PGFE_API void finish();
+
+  /// @returns The number of statements which results are not yet processed.
+  DMITIGR_PGFE_API std::size_t unprocessed_count() const noexcept;
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  /// The estimated size of the Parse, Bind, Describe and Execute messages.
+  static constexpr std::size_t message_size_estimate__{64};
+
+  std::shared_ptr<Pipeline_executor*> self_;
+  Connection& connection_;
+  std::size_t sync_count_{1024};
+  std::size_t sync_bytes_{std::size_t{1} << 20};
+  std::optional<std::chrono::microseconds> sync_interval_;
+
+  /*
+   * The queue of the pending results. Each null element denotes the sync
+   * message.
+   */
+  std::deque<std::shared_ptr<Handle::State>> queue_;
+  std::size_t unsynced_count_{};
+  std::size_t unsynced_bytes_{};
+  Clock::time_point unsynced_since_;
+
+  bool is_invariant_ok() const noexcept;
+
+  template<typename T>
+  static std::size_t size_estimate__(const T& value) noexcept
+  {
+    using U = std::decay_t<T>;
+    if constexpr (std::is_same_v<U, std::string> ||
+      std::is_same_v<U, std::string_view>)
+      return value.size();
+    else if constexpr (std::is_same_v<U, const char*> ||
+      std::is_same_v<U, char*>)
+      return value ? std::char_traits<char>::length(value) : 0;
+    else if constexpr (std::is_base_of_v<Data, U>)
+      return value.size();
+    else
+      return sizeof(U);
+  }
+
+  std::shared_ptr<Handle::State> make_state__(Row_handler&& callback);
+  Handle submitted__(std::shared_ptr<Handle::State>&& state, std::size_t size,
+    bool is_sync_allowed = true);
+  std::vector<Handle> execute__(const Statement_vector& statements,
+    const Completion_handler& handler, Pipeline_error_policy on_error,
+    const std::vector<const Named_argument*>& arguments);
+  void wait__(const Handle::State& state);
+  void process_response__();
+  void flush_output__();
+  void process_available__();
+};
+
+} // namespace dmitigr::pgfe
+
+#ifndef DMITIGR_PGFE_NOT_HEADER_ONLY
+#include "pipeline_executor.cpp"
+#endif
+
+#endif  // DMITIGR_PGFE_PIPELINE_EXECUTOR_HPP
@@ -0,0 +1,230 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "connection.hpp"
+#include "conversions.hpp"
+#include "exceptions.hpp"
+#include "pipelined_large_object.hpp"
+#include "statement.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <string>
+#include <utility>
+
+namespace dmitigr::pgfe {
+
+namespace detail {
+
+/// Sets the result format of the connection to binary until destruction.
+class Binary_result_format_guard final {
+public:
+  explicit Binary_result_format_guard(Connection& conn)
+    : conn_{conn}
+    , format_{conn.result_format()}
+  {
+    conn_.set_result_format(Data_format::binary);
+  }
+
+  ~Binary_result_format_guard()
+  {
+    conn_.set_result_format(format_);
+  }
+
+  Binary_result_format_guard(const Binary_result_format_guard&) = delete;
+  Binary_result_format_guard& operator=(const Binary_result_format_guard&) = delete;
+
+private:
+  Connection& conn_;
+  Data_format format_{};
+};
+
+/// @returns The first field of the single row of the result of `handle`.
+inline Data_view pipelined_large_object_result(
+  Pipelined_large_object::Handle& handle, const char* const what)
+{
+  auto& rows = handle.rows();
+  if (rows.size() != 1)
+    throw Client_exception{std::string{"cannot get result of "}.append(what)
+      .append(": unexpected number of rows")};
+  return rows.front().data(0);
+}
+
+} // namespace detail
+
+DMITIGR_PGFE_INLINE
+Pipelined_large_object::Pipelined_large_object(Pipeline_executor& executor,
+  const Oid oid, const Large_object_open_mode mode)
+  : executor_{executor}
+{
+  if (executor_.connection().pipeline_status() != Pipeline_status::enabled)
+    throw Client_exception{"cannot open pipelined large object: "
+      "pipeline is not enabled"};
+
+  static const Statement statement{"select pg_catalog.lo_open($1, $2)"};
+  Handle handle;
+  {
+    detail::Binary_result_format_guard guard{executor_.connection()};
+    handle = executor_.execute(statement, static_cast<long long>(oid),
+      static_cast<int>(mode));
+  }
+  descriptor_ = to<std::int32_t>(detail::pipelined_large_object_result(handle,
+      "large object opening"));
+}
+
+DMITIGR_PGFE_INLINE Pipeline_executor&
+Pipelined_large_object::executor() noexcept
+{
+  return executor_;
+}
+
+DMITIGR_PGFE_INLINE std::int32_t
+Pipelined_large_object::descriptor() const noexcept
+{
+  return descriptor_;
+}
+
+DMITIGR_PGFE_INLINE auto Pipelined_large_object::read(const std::size_t size)
+  -> Handle
+{
+  check_descriptor("cannot read pipelined large object");
+  if (size > static_cast<std::size_t>(std::numeric_limits<std::int32_t>::max()))
+    throw Client_exception{"cannot read pipelined large object: "
+      "invalid size"};
+
+  static const Statement statement{"select pg_catalog.loread($1, $2)"};
+  detail::Binary_result_format_guard guard{executor_.connection()};
+  return executor_.execute(statement, descriptor_,
+    static_cast<std::int32_t>(size));
+}
+
+DMITIGR_PGFE_INLINE auto
+Pipelined_large_object::write(const std::string_view data) -> Handle
+{
+  check_descriptor("cannot write pipelined large object");
+  static const Statement statement{"select pg_catalog.lowrite($1, $2)"};
+  detail::Binary_result_format_guard guard{executor_.connection()};
+  return executor_.execute(statement, descriptor_,
+    Data_view{data.data(), data.size(), Data_format::binary});
+}
+
+DMITIGR_PGFE_INLINE auto
+Pipelined_large_object::seek(const std::int64_t offset,
+  const Large_object_seek_whence whence) -> Handle
+{
+  check_descriptor("cannot seek pipelined large object");
+  static const Statement statement{"select pg_catalog.lo_lseek64($1, $2, $3)"};
+  detail::Binary_result_format_guard guard{executor_.connection()};
+  return executor_.execute(statement, descriptor_,
+    static_cast<long long>(offset), static_cast<int>(whence));
+}
+
+DMITIGR_PGFE_INLINE auto Pipelined_large_object::close() -> Handle
+{
+  check_descriptor("cannot close pipelined large object");
+  static const Statement statement{"select pg_catalog.lo_close($1)"};
+  auto result = executor_.execute(statement, descriptor_);
+  descriptor_ = -1;
+  return result;
+}
+
+DMITIGR_PGFE_INLINE Data_view Pipelined_large_object::data(Handle& handle)
+{
+  return detail::pipelined_large_object_result(handle,
+    "large object reading");
+}
+
+DMITIGR_PGFE_INLINE std::size_t
+Pipelined_large_object::written_size(Handle& handle)
+{
+  return static_cast<std::size_t>(to<std::int32_t>(
+      detail::pipelined_large_object_result(handle, "large object writing")));
+}
+
+DMITIGR_PGFE_INLINE std::int64_t Pipelined_large_object::position(Handle& handle)
+{
+  return to<std::int64_t>(
+    detail::pipelined_large_object_result(handle, "large object seeking"));
+}
+
+DMITIGR_PGFE_INLINE std::size_t
+Pipelined_large_object::read_all(const std::function<void(Data_view)>& sink,
+  const std::size_t chunk_size, const std::size_t depth)
+{
+  if (!sink || !chunk_size || !depth)
+    throw Client_exception{"cannot read pipelined large object: "
+      "invalid arguments"};
+
+  std::size_t result{};
+  std::deque<Handle> handles;
+  bool is_end{};
+  while (!is_end) {
+    while (handles.size() < depth)
+      handles.push_back(read(chunk_size));
+    executor_.sync();
+
+    const auto data = Pipelined_large_object::data(handles.front());
+    if (data.size())
+      sink(data);
+    result += data.size();
+    is_end = data.size() < chunk_size;
+    handles.pop_front();
+  }
+
+  // Dismiss the reads submitted past the end.
+  for (auto& handle : handles)
+    handle.wait();
+  return result;
+}
+
+DMITIGR_PGFE_INLINE void
+Pipelined_large_object::write_all(const std::string_view data,
+  const std::size_t chunk_size)
+{
+  if (!chunk_size)
+    throw Client_exception{"cannot write pipelined large object: "
+      "invalid chunk size"};
+
+  std::deque<std::pair<Handle, std::size_t>> handles;
+  for (std::size_t offset{}; offset < data.size(); offset += chunk_size) {
+    const auto chunk = data.substr(offset, chunk_size);
+    handles.emplace_back(write(chunk), chunk.size());
+
+    // Collect the results which are available without blocking.
+    while (!handles.empty() && handles.front().first.is_ready()) {
+      auto& [handle, size] = handles.front();
+      if (written_size(handle) != size)
+        throw Client_exception{"cannot write pipelined large object: "
+          "chunk is not written entirely"};
+      handles.pop_front();
+    }
+  }
+  for (auto& [handle, size] : handles) {
+    if (written_size(handle) != size)
+      throw Client_exception{"cannot write pipelined large object: "
+        "chunk is not written entirely"};
+  }
+}
+
+DMITIGR_PGFE_INLINE void
+Pipelined_large_object::check_descriptor(const char* const what) const
+{
+  if (descriptor_ < 0)
+    throw Client_exception{std::string{what}.append(": large object is closed")};
+}
+
+} // namespace dmitigr::pgfe
@@ -0,0 +1,181 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DMITIGR_PGFE_PIPELINED_LARGE_OBJECT_HPP
+#define DMITIGR_PGFE_PIPELINED_LARGE_OBJECT_HPP
+
+#include "basics.hpp"
+#include "data.hpp"
+#include "dll.hpp"
+#include "large_object.hpp"
+#include "pipeline_executor.hpp"
+#include "types_fwd.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+
+namespace dmitigr::pgfe {
+
+/**
+ * @ingroup main
+ *
+ * @brief A large object operated in pipeline mode.
+ *
+ * @details Unlike Large_object, which is based on the libpq's large object
+ * API and thus is unusable in pipeline mode, the operations of this class are
+ * the calls of the server functions `lo_open()`, `loread()`, `lowrite()`,
+ * `lo_lseek64()` and `lo_close()` submitted through the Pipeline_executor.
+ * Therefore, many operations can be submitted without waiting for the results
+ * of the preceding ones, which are delivered in order. The results are
+ * requested in the binary format, so the data read is not decoded.
+ *
+ * @remarks Large object descriptors are only valid within the transaction, so
+ * the transaction should be started (e.g. by submitting `begin` through the
+ * executor) before the construction.
+ */
+class Pipelined_large_object final {
+public:
+  /// The alias of Pipeline_executor::Handle.
+  using Handle = Pipeline_executor::Handle;
+
+  /**
+   * @brief Submits the request to open the large object and waits for its
+   * descriptor.
+   *
+   * @par Requires
+   * `executor.connection().pipeline_status() == Pipeline_status::enabled`.
+   *
+   * @throws Server_exception if the large object cannot be opened.
+   *
+   * @remarks The `executor` must outlive the instance.
+   */
+  DMITIGR_PGFE_API Pipelined_large_object(Pipeline_executor& executor,
+    Oid oid, Large_object_open_mode mode);
+
+  /// Not copy-constructible.
+  Pipelined_large_object(const Pipelined_large_object&) = delete;
+
+  /// Not copy-assignable.
+  Pipelined_large_object& operator=(const Pipelined_large_object&) = delete;
+
+  /// @returns The underlying executor.
+  DMITIGR_PGFE_API Pipeline_executor& executor() noexcept;
+
+  /// @returns The descriptor of the large object.
+  DMITIGR_PGFE_API std::int32_t descriptor() const noexcept;
+
+  /**
+   * @brief Submits the request to read up to `size` bytes from the current
+   * position.
+   *
+   * @returns The handle which should be passed to data().
+   *
+   * @par Requires
+   * `size <= std::numeric_limits<std::int32_t>::max()`.
+   */
+  DMITIGR_PGFE_API Handle read(std::size_t size);
+
+  /**
+   * @brief Submits the request to write the `data` to the current position.
+   *
+   * @returns The handle which should be passed to written_size().
+   *
+   * @remarks The `data` is copied to the output buffer of the connection.
+   */
+  DMITIGR_PGFE_API Handle write(std::string_view data);
+
+  /**
+   * @brief Submits the request to change the current position.
+   *
+   * @returns The handle which should be passed to position().
+   */
+  DMITIGR_PGFE_API Handle seek(std::int64_t offset,
+    Large_object_seek_whence whence);
+
+  /**
+   * @brief Submits the request to close the large object.
+   *
+   * @par Effects
+   * `descriptor() == -1`.
+   */
+  DMITIGR_PGFE_API Handle close();
+
+  /**
+   * @returns The data read by the request submitted by read().
+   *
+   * @details Waits for the result if necessary. The returned view is valid
+   * until the `handle` is alive.
+   */
+  DMITIGR_PGFE_API static Data_view data(Handle& handle);
+
+  /**
+   * @returns The number of bytes written by the request submitted by write().
+   *
+   * @details Waits for the result if necessary.
+   */
+  DMITIGR_PGFE_API static std::size_t written_size(Handle& handle);
+
+  /**
+   * @returns The position resulting from the request submitted by seek().
+   *
+   * @details Waits for the result if necessary.
+   */
+  DMITIGR_PGFE_API static std::int64_t position(Handle& handle);
+
+  /**
+   * @brief Reads the large object from the current position until the end by
+   * keeping up to `depth` read requests of `chunk_size` bytes in flight.
+   *
+   * @param sink The function to be called with each chunk read, in order.
+   *
+   * @returns The number of bytes read.
+   *
+   * @par Requires
+   * `sink && chunk_size > 0 && depth > 0`.
+   */
+  DMITIGR_PGFE_API std::size_t read_all(
+    const std::function<void(Data_view)>& sink,
+    std::size_t chunk_size = 262144, std::size_t depth = 8);
+
+  /**
+   * @brief Writes the `data` to the current position by chunks of
+   * `chunk_size` bytes which are submitted without waiting for the results of
+   * the preceding ones.
+   *
+   * @par Requires
+   * `chunk_size > 0`.
+   *
+   * @throws Client_exception if any chunk is not written entirely.
+   */
+  DMITIGR_PGFE_API void write_all(std::string_view data,
+    std::size_t chunk_size = 262144);
+
+private:
+  Pipeline_executor& executor_;
+  std::int32_t descriptor_{-1};
+
+  void check_descriptor(const char* what) const;
+};
+
+} // namespace dmitigr::pgfe
+
+#ifndef DMITIGR_PGFE_NOT_HEADER_ONLY
+#include "pipelined_large_object.cpp"
+#endif
+
+#endif  // DMITIGR_PGFE_PIPELINED_LARGE_OBJECT_HPP
@@ -17,9 +17,11 @@
 #include "connection.hpp"
 #include "exceptions.hpp"
 #include "prepared_statement.hpp"
+#include "probe.hpp"
 #include "statement.hpp"
 
 #include <algorithm>
+#include <numeric>
 
 namespace dmitigr::pgfe {
 
@@ -258,9 +260,21 @@ Prepared_statement::execute_nio__(const Statement* const statement)
     }
     const int result_format = detail::pq::to_int(result_format_);
 
-    const int send_ok = statement
-      ? PQsendQueryParams(conn.conn(),
-        statement->to_query_string(conn).c_str(),
+    /*
+     * The simple query protocol is used if enabled and possible, since it
+     * requires just a single Query message instead of Parse, Bind, Describe,
+     * Execute and Sync. (The rows are always in the text format in this case.)
+     */
+    const auto compiled = statement ? statement->compiled(conn) : nullptr;
+    const bool is_simple = conn.is_simple_query_protocol_enabled() &&
+      compiled && compiled->is_simple && !param_count &&
+      result_format_ == Data_format::text &&
+      conn.pipeline_status() == Pipeline_status::disabled;
+
+    const int send_ok = is_simple
+      ? PQsendQuery(conn.conn(), compiled->query.c_str())
+      : compiled
+      ? PQsendQueryParams(conn.conn(), compiled->query.c_str(),
         param_count, nullptr, values.data(), lengths.data(),
         formats.data(), result_format)
       : PQsendQueryPrepared(conn.conn(),
@@ -271,6 +285,10 @@ Prepared_statement::execute_nio__(const Statement* const statement)
     if (!send_ok)
       throw Client_exception{conn.error_message()};
 
+    DMITIGR_PGFE_PROBE(execute__submit, static_cast<int>(conn.server_pid()),
+      name().c_str(), compiled ? compiled->query.c_str() : nullptr,
+      std::accumulate(lengths.cbegin(), lengths.cend(), std::size_t{}));
+
     if (conn.pipeline_status() == Pipeline_status::disabled)
       conn.set_single_row_mode_enabled();
   } catch (...) {
@@ -357,17 +375,12 @@ DMITIGR_PGFE_INLINE Prepared_statement::Prepared_statement(
   init_connection__(std::move(state));
   state_->preparsed_ = static_cast<bool>(preparsed);
   if (state_->preparsed_) {
-    std::size_t bound_params_count{};
-    const std::size_t pc = preparsed->parameter_count();
-    parameters_.resize(pc);
-    for (std::size_t i = preparsed->positional_parameter_count(); i < pc; ++i) {
-      const auto name = preparsed->parameter_name(i);
-      if (preparsed->bound(name))
-        ++bound_params_count;
-      else
-        parameters_[i - bound_params_count].name = name;
-    }
-    parameters_.resize(pc - bound_params_count);
+    const auto compiled = preparsed->compiled(connection());
+    const auto& named = compiled->named_parameters;
+    const std::size_t ppc = preparsed->positional_parameter_count();
+    parameters_.resize(ppc + named.size());
+    for (std::size_t i{}; i < named.size(); ++i)
+      parameters_[ppc + i].name = preparsed->parameter_name(ppc + named[i]);
   } else
     parameters_.reserve(8);
 
@@ -0,0 +1,57 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef DMITIGR_PGFE_PROBE_HPP
+#define DMITIGR_PGFE_PROBE_HPP
+
+/*
+ * The static tracepoints (USDT) of the request lifecycle. The probes are
+ * compiled in only if DMITIGR_PGFE_USDT is defined (see the CMake option of
+ * the same name), otherwise the probe arguments are not even evaluated. The
+ * provider name is `dmitigr_pgfe`. For example:
+ *
+ *   bpftrace -e 'usdt:./app:dmitigr_pgfe:execute__submit { printf("%d %s\n", arg0, str(arg2)); }'
+ *
+ * The probes and their arguments:
+ *   - connect__start(const Connection*);
+ *   - connect__poll(const Connection*, int polling_status);
+ *   - connect__done(const Connection*, int server_pid, int is_connected);
+ *   - execute__submit(int server_pid, const char* statement_name,
+ *     const char* query, std::size_t parameter_bytes);
+ *   - flush__output(int server_pid, int is_flushed);
+ *   - input__result(int server_pid, int result_status);
+ *   - input__first_row(int server_pid, std::size_t row_bytes);
+ *   - input__complete(int server_pid, int result_status, const char* tag);
+ *   - pool__acquire(const Connection_pool*, std::size_t index, int server_pid);
+ *   - pool__release(const Connection_pool*, std::size_t index, int server_pid).
+ *
+ * The `query` of execute__submit is `nullptr` if the statement is executed by
+ * name. The `index` of pool__acquire is `-1` if there is no free connection.
+ */
+
+#ifdef DMITIGR_PGFE_USDT
+#include <sys/sdt.h>
+
+#define DMITIGR_PGFE_PROBE_SELECT(_1, _2, _3, _4, macro, ...) macro
+#define DMITIGR_PGFE_PROBE(name, ...)                                   \
+  DMITIGR_PGFE_PROBE_SELECT(__VA_ARGS__, DTRACE_PROBE4, DTRACE_PROBE3,  \
+    DTRACE_PROBE2, DTRACE_PROBE1, )(dmitigr_pgfe, name, __VA_ARGS__)
+#else
+#define DMITIGR_PGFE_PROBE(name, ...) static_cast<void>(0)
+#endif
+
+#endif  // DMITIGR_PGFE_PROBE_HPP
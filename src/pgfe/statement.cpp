@@ -29,12 +29,6 @@
 
 namespace dmitigr::pgfe {
 
-DMITIGR_PGFE_INLINE
-Statement::Fragment::Fragment(const Type tp, const std::string& s)
-  : type(tp)
-  , str(s)
-{}
-
 DMITIGR_PGFE_INLINE bool
 Statement::Fragment::is_named_parameter() const noexcept
 {
@@ -44,12 +38,6 @@ Statement::Fragment::is_named_parameter() const noexcept
     type == Ft::named_parameter_identifier;
 }
 
-DMITIGR_PGFE_INLINE bool
-Statement::Fragment::is_named_parameter(const std::string_view name) const noexcept
-{
-  return is_named_parameter() && str == name;
-}
-
 // =============================================================================
 
 DMITIGR_PGFE_INLINE Statement::Statement(const std::string_view text)
@@ -70,11 +58,17 @@ DMITIGR_PGFE_INLINE Statement::Statement(const char* const text)
 DMITIGR_PGFE_INLINE Statement::Statement(const Statement& rhs)
   : fragments_{rhs.fragments_}
   , positional_parameters_{rhs.positional_parameters_}
+  , named_parameters_{rhs.named_parameters_}
   , is_extra_data_should_be_extracted_from_comments_{
       rhs.is_extra_data_should_be_extracted_from_comments_}
   , extra_{rhs.extra_}
+  , compiled_{std::atomic_load(&rhs.compiled_)}
 {
-  named_parameters_ = named_parameters();
+  // Don't copy the text which is no longer referenced by the fragments.
+  if (rhs.live_text_size() < rhs.text_.size())
+    compact_text(rhs.text_);
+  else
+    text_ = rhs.text_;
 }
 
 DMITIGR_PGFE_INLINE Statement& Statement::operator=(const Statement& rhs)
@@ -87,14 +81,15 @@ DMITIGR_PGFE_INLINE Statement& Statement::operator=(const Statement& rhs)
 }
 
 DMITIGR_PGFE_INLINE Statement::Statement(Statement&& rhs) noexcept
-  : fragments_{std::move(rhs.fragments_)}
+  : text_{std::move(rhs.text_)}
+  , fragments_{std::move(rhs.fragments_)}
   , positional_parameters_{std::move(rhs.positional_parameters_)}
+  , named_parameters_{std::move(rhs.named_parameters_)}
   , is_extra_data_should_be_extracted_from_comments_{
       std::move(rhs.is_extra_data_should_be_extracted_from_comments_)}
   , extra_{std::move(rhs.extra_)}
-{
-  named_parameters_ = named_parameters();
-}
+  , compiled_{std::move(rhs.compiled_)}
+{}
 
 DMITIGR_PGFE_INLINE Statement& Statement::operator=(Statement&& rhs) noexcept
 {
@@ -108,12 +103,14 @@ DMITIGR_PGFE_INLINE Statement& Statement::operator=(Statement&& rhs) noexcept
 DMITIGR_PGFE_INLINE void Statement::swap(Statement& rhs) noexcept
 {
   using std::swap;
+  swap(text_, rhs.text_);
   swap(fragments_, rhs.fragments_);
   swap(positional_parameters_, rhs.positional_parameters_);
   swap(named_parameters_, rhs.named_parameters_);
   swap(is_extra_data_should_be_extracted_from_comments_,
     rhs.is_extra_data_should_be_extracted_from_comments_);
   swap(extra_, rhs.extra_);
+  swap(compiled_, rhs.compiled_);
 }
 
 DMITIGR_PGFE_INLINE std::size_t
@@ -152,7 +149,7 @@ Statement::parameter_name(const std::size_t index) const
 {
   if (!((positional_parameter_count() <= index) && (index < parameter_count())))
     throw Client_exception{"cannot get Statement parameter name"};
-  return named_parameters_[index - positional_parameter_count()]->str;
+  return str(named_parameters_[index - positional_parameter_count()]);
 }
 
 DMITIGR_PGFE_INLINE std::size_t
@@ -171,7 +168,7 @@ DMITIGR_PGFE_INLINE bool Statement::is_query_empty() const noexcept
   return all_of(cbegin(fragments_), cend(fragments_),
     [this](const Fragment& f)
     {
-      return is_comment(f) || (is_text(f) && str::is_blank(f.str));
+      return is_comment(f) || (is_text(f) && str::is_blank(str(f)));
     });
 }
 
@@ -219,12 +216,40 @@ DMITIGR_PGFE_INLINE bool Statement::has_missing_parameters() const noexcept
 
 DMITIGR_PGFE_INLINE void Statement::append(const Statement& appendix)
 {
+  // Don't inherit the text which is no longer referenced by the appendix.
+  if (appendix.live_text_size() < appendix.text_.size())
+    return append(Statement{appendix});
+
   const bool was_query_empty{is_query_empty()};
 
-  // Update fragments.
-  fragments_.insert(cend(fragments_), cbegin(appendix.fragments_),
-    cend(appendix.fragments_));
-  update_cache(appendix); // can throw
+  // Map the named parameters of the appendix to the named parameters of this.
+  const auto pos_count = positional_parameter_count();
+  std::vector<std::uint32_t> parameters(appendix.named_parameters_.size());
+  std::size_t named_count{named_parameter_count()};
+  for (std::size_t i{}; i < parameters.size(); ++i) {
+    const auto idx = named_parameter_index(appendix.str(appendix.named_parameters_[i]));
+    parameters[i] = static_cast<std::uint32_t>(idx < parameter_count() ?
+      idx - pos_count : named_count++);
+  }
+  check_parameter_count(std::max(pos_count,
+      appendix.positional_parameter_count()), named_count); // can throw
+
+  // Update the text and fragments. (Can throw.)
+  const auto offset = text_.size();
+  text_.append(appendix.text_);
+  for (auto fragment : appendix.fragments_) {
+    fragment.offset += offset;
+    if (fragment.is_named_parameter()) {
+      const auto& param = appendix.named_parameters_[fragment.parameter];
+      fragment.parameter = parameters[fragment.parameter];
+      if (fragment.parameter == named_parameters_.size())
+        named_parameters_.push_back({param.offset + offset, param.size,
+          param.type, param.value});
+    }
+    fragments_.push_back(fragment);
+  }
+  merge_positional_parameters(appendix.positional_parameters_);
+  compiled_.reset();
 
   if (was_query_empty)
     is_extra_data_should_be_extracted_from_comments_ = true;
@@ -238,10 +263,9 @@ Statement::bind(const std::string_view name,
 {
   if (!has_parameter(name))
     throw Client_exception{"cannot bind Statement parameter"};
-  for (auto& fragment : fragments_) {
-    if (fragment.is_named_parameter(name))
-      fragment.value = value;
-  }
+  named_parameters_[parameter_index(name) - positional_parameter_count()].value =
+    value;
+  compiled_.reset();
   assert(is_invariant_ok());
   return *this;
 }
@@ -251,39 +275,22 @@ Statement::bound(const std::string_view name) const
 {
   if (!has_parameter(name))
     throw Client_exception{"cannot get bound Statement parameter"};
-  for (auto& fragment : fragments_) {
-    if (fragment.is_named_parameter(name))
-      return fragment.value;
-  }
-  DMITIGR_ASSERT(false);
+  return named_parameters_[parameter_index(name) -
+    positional_parameter_count()].value;
 }
 
 DMITIGR_PGFE_INLINE std::size_t
 Statement::bound_parameter_count() const noexcept
 {
-  return count_if(cbegin(fragments_), cend(fragments_),
-    [counted = std::vector<std::string>{}](const auto& fragment)mutable -> bool
-    {
-      if (fragment.is_named_parameter()) {
-        const bool is_uncounted{none_of(cbegin(counted), cend(counted),
-          [&fragment](const auto& name){return name == fragment.str;})};
-        if (is_uncounted) {
-          counted.push_back(fragment.str);
-          return static_cast<bool>(fragment.value);
-        }
-      }
-      return false;
-    });
+  return count_if(cbegin(named_parameters_), cend(named_parameters_),
+    [](const auto& param){return static_cast<bool>(param.value);});
 }
 
 DMITIGR_PGFE_INLINE bool
 Statement::has_bound_parameters() const noexcept
 {
-  const auto e = cend(fragments_);
-  return find_if(cbegin(fragments_), e, [](const auto& fragment)
-  {
-    return fragment.is_named_parameter() && fragment.value;
-  }) != e;
+  return any_of(cbegin(named_parameters_), cend(named_parameters_),
+    [](const auto& param){return static_cast<bool>(param.value);});
 }
 
 DMITIGR_PGFE_INLINE void
@@ -293,19 +300,146 @@ Statement::replace_parameter(const std::string_view name,
   if (!(has_parameter(name) && (this != &replacement)))
     throw Client_exception{"cannot replace Statement parameter"};
 
-  // Update fragments.
-  for (auto fi = begin(fragments_); fi != end(fragments_);) {
-    if (fi->is_named_parameter(name)) {
-      // Insert the `replacement` just before `fi`.
-      fragments_.insert(fi, cbegin(replacement.fragments_),
-        cend(replacement.fragments_));
-      // Erase named parameter pointed by `fi` and got the next iterator.
-      fi = fragments_.erase(fi);
-    } else
-      ++fi;
+  /*
+   * Since the named parameters are ordered by first occurrence, neither the
+   * named parameters preceding the replaced one nor the fragments preceding
+   * its first occurrence are affected. The named parameters of the replacement
+   * which are not among the preceding ones take the place of the replaced one,
+   * and the named parameters following it are shifted accordingly.
+   */
+  constexpr auto npos = static_cast<std::uint32_t>(-1);
+  const auto pos_count = positional_parameter_count();
+  const auto named_count = named_parameter_count();
+  const auto replaced = static_cast<std::uint32_t>(parameter_index(name) -
+    pos_count);
+  const auto& rparams = replacement.named_parameters_;
+  std::vector<std::uint32_t> rmap(rparams.size());
+  std::vector<std::uint32_t> map(named_count - replaced, npos);
+  std::uint32_t next{replaced};
+  for (std::size_t i{}; i < rparams.size(); ++i) {
+    const auto idx = named_parameter_index(replacement.str(rparams[i])) - pos_count;
+    if (idx < replaced)
+      rmap[i] = static_cast<std::uint32_t>(idx);
+    else {
+      rmap[i] = next++;
+      if (replaced < idx && idx < named_count)
+        map[idx - replaced] = rmap[i];
+    }
+  }
+  const std::uint32_t first_shifted{next};
+  for (std::size_t i{replaced + 1u}; i < named_count; ++i) {
+    if (map[i - replaced] == npos)
+      map[i - replaced] = next++;
+  }
+  check_parameter_count(std::max(pos_count,
+      replacement.positional_parameter_count()), next); // can throw
+
+  const auto b = cbegin(fragments_);
+  const auto e = cend(fragments_);
+  const auto is_replaced = [replaced](const Fragment& f) noexcept
+  {
+    return f.is_named_parameter() && f.parameter == replaced;
+  };
+  const auto first = static_cast<std::size_t>(find_if(b, e, is_replaced) - b);
+  const auto occurrence_count = static_cast<std::size_t>(
+    count_if(b + first, e, is_replaced));
+  const auto old_size = fragments_.size();
+  // The empty text fragments of the replacement are not spliced.
+  const auto& rfragments = replacement.fragments_;
+  const auto is_spliced = [](const Fragment& f) noexcept
+  {
+    return f.size || !is_text(f);
+  };
+  const auto rsize = static_cast<std::size_t>(
+    count_if(cbegin(rfragments), cend(rfragments), is_spliced));
+  const auto new_size = old_size - occurrence_count + occurrence_count * rsize;
+
+  // Allocate everything before modifying.
+  const auto offset = text_.size();
+  text_.append(replacement.text_); // can throw
+  std::vector<Named_parameter> tail;
+  try {
+    tail.resize(next - replaced);
+    for (std::size_t i{}; i < rparams.size(); ++i) {
+      if (rmap[i] >= replaced) {
+        const auto& param = rparams[i];
+        tail[rmap[i] - replaced] = {param.offset + offset, param.size,
+          param.type, param.value};
+      }
+    }
+    if (named_parameters_.capacity() < next)
+      named_parameters_.reserve(std::max<std::size_t>(next,
+          2 * named_parameters_.capacity()));
+    positional_parameters_.reserve(std::max(pos_count,
+        replacement.positional_parameter_count()));
+    if (new_size > old_size)
+      fragments_.resize(new_size);
+  } catch (...) {
+    text_.resize(offset);
+    throw;
+  }
+
+  // Update the named parameters. (Cannot throw.)
+  for (std::size_t i{replaced + 1u}; i < named_count; ++i) {
+    if (map[i - replaced] >= first_shifted)
+      tail[map[i - replaced] - replaced] = std::move(named_parameters_[i]);
+  }
+  named_parameters_.resize(replaced);
+  for (auto& param : tail)
+    named_parameters_.push_back(std::move(param));
+
+  // Update the affected fragments. (Cannot throw.)
+  const auto updated = [&](Fragment f) noexcept
+  {
+    if (f.is_named_parameter() && f.parameter > replaced)
+      f.parameter = map[f.parameter - replaced];
+    return f;
+  };
+  const auto updated_replacement = [&](Fragment f) noexcept
+  {
+    f.offset += offset;
+    if (f.is_named_parameter())
+      f.parameter = rmap[f.parameter];
+    return f;
+  };
+  if (rsize > 0) {
+    // Fill backward, since the fragments are moved towards the end.
+    auto w = new_size;
+    for (auto r = old_size; r-- > first;) {
+      const auto fragment = fragments_[r];
+      if (is_replaced(fragment)) {
+        for (auto ri = rfragments.size(); ri-- > 0;) {
+          if (is_spliced(rfragments[ri]))
+            fragments_[--w] = updated_replacement(rfragments[ri]);
+        }
+      } else
+        fragments_[--w] = updated(fragment);
+    }
+    DMITIGR_ASSERT(w == first);
+  } else {
+    // Fill forward, since the fragments are moved towards the beginning.
+    auto w = first;
+    for (auto r = first; r < old_size; ++r) {
+      if (!is_replaced(fragments_[r]))
+        fragments_[w++] = updated(fragments_[r]);
+    }
+    DMITIGR_ASSERT(w == new_size);
+    fragments_.resize(new_size);
   }
 
-  update_cache(replacement);  // can throw
+  merge_positional_parameters(replacement.positional_parameters_);
+  compiled_.reset();
+
+  /*
+   * The text of the replaced occurrences is left in text_. Compact it once
+   * it's no longer referenced for the most part, so that the repeated
+   * replacements don't grow it unboundedly.
+   */
+  if (2 * live_text_size() < text_.size()) {
+    try {
+      compact_text(text_);
+    } catch (...) {} // the statement is valid anyway
+  }
 
   assert(is_invariant_ok());
 }
@@ -313,49 +447,72 @@ Statement::replace_parameter(const std::string_view name,
 DMITIGR_PGFE_INLINE std::string Statement::to_string() const
 {
   using Ft = Fragment::Type;
+  const auto marker_size = [](const Ft type) noexcept -> std::size_t
+  {
+    switch (type) {
+    case Ft::text: return 0;
+    case Ft::one_line_comment: return 3;
+    case Ft::multi_line_comment: return 4;
+    case Ft::named_parameter: return 1;
+    case Ft::named_parameter_literal: return 3;
+    case Ft::named_parameter_identifier: return 3;
+    case Ft::positional_parameter: return 1;
+    }
+    return 0;
+  };
+  std::string::size_type size{};
+  for (const auto& fragment : fragments_)
+    size += fragment.size + marker_size(fragment.type);
+
   std::string result;
-  result.reserve(512);
+  result.reserve(size);
   for (const auto& fragment : fragments_) {
+    const auto fstr = str(fragment);
     switch (fragment.type) {
     case Ft::text:
-      result += fragment.str;
+      result += fstr;
       break;
     case Ft::one_line_comment:
       result += "--";
-      result += fragment.str;
+      result += fstr;
       result += '\n';
       break;
     case Ft::multi_line_comment:
       result += "/*";
-      result += fragment.str;
+      result += fstr;
       result += "*/";
       break;
     case Ft::named_parameter:
       result += ':';
-      result += fragment.str;
+      result += fstr;
       break;
     case Ft::named_parameter_literal:
       result += ":'";
-      result += fragment.str;
+      result += fstr;
       result += '\'';
       break;
     case Ft::named_parameter_identifier:
       result += ":\"";
-      result += fragment.str;
+      result += fstr;
       result += '"';
       break;
     case Ft::positional_parameter:
       result += '$';
-      result += fragment.str;
+      result += fstr;
       break;
     }
   }
-  result.shrink_to_fit();
   return result;
 }
 
 DMITIGR_PGFE_INLINE std::string
 Statement::to_query_string(const Connection& conn) const
+{
+  return compiled(conn)->query;
+}
+
+DMITIGR_PGFE_INLINE auto Statement::compiled(const Connection& conn) const
+  -> std::shared_ptr<const Compiled>
 {
   using Ft = Fragment::Type;
 
@@ -366,12 +523,17 @@ Statement::to_query_string(const Connection& conn) const
     throw Client_exception{"cannot convert Statement to query string: "
       "not connected"};
 
-  static const auto check_value_bound = [](const auto& fragment)
+  if (auto result = std::atomic_load(&compiled_))
+    return result;
+
+  const auto check_value_bound = [this](const Fragment& fragment)
+    -> const std::string&
   {
     DMITIGR_ASSERT(fragment.is_named_parameter());
-    if (!fragment.value) {
+    const auto& value = named_parameters_[fragment.parameter].value;
+    if (!value) {
       std::string what{"named parameter "};
-      what.append(fragment.str);
+      what.append(str(fragment));
       const char* const type_str =
         fragment.type == Ft::named_parameter_literal ? "literal" :
         fragment.type == Ft::named_parameter_identifier ? "identifier" : nullptr;
@@ -380,43 +542,73 @@ Statement::to_query_string(const Connection& conn) const
       what.append(" has no value bound");
       throw Client_exception{what};
     }
+    return *value;
   };
 
-  std::string result;
-  result.reserve(512);
+  Compiled result;
+
+  // Number the unbound named parameters.
+  std::vector<std::uint32_t> positions(named_parameters_.size());
+  for (std::size_t i{}; i < named_parameters_.size(); ++i) {
+    if (!named_parameters_[i].value) {
+      result.named_parameters.push_back(static_cast<std::uint32_t>(i));
+      positions[i] = static_cast<std::uint32_t>(positional_parameter_count() +
+        result.named_parameters.size());
+    }
+  }
+
+  bool is_connection_dependent{};
+  bool has_values_substituted_as_is{};
+  auto& query = result.query;
+  query.reserve(text_.size() + 8 * named_parameters_.size());
   for (const auto& fragment : fragments_) {
     switch (fragment.type) {
     case Ft::text:
-      result += fragment.str;
+      query += str(fragment);
       break;
     case Ft::one_line_comment:
       [[fallthrough]];
     case Ft::multi_line_comment:
       break;
     case Ft::named_parameter:
-      if (!fragment.value) {
-        const auto idx = named_parameter_index(fragment.str);
-        DMITIGR_ASSERT(idx < parameter_count());
-        result += '$';
-        result += std::to_string(idx + 1);
-      } else
-        result += *fragment.value;
+      if (const auto& value = named_parameters_[fragment.parameter].value) {
+        query += *value;
+        has_values_substituted_as_is = true;
+      } else {
+        query += '$';
+        query += std::to_string(positions[fragment.parameter]);
+      }
       break;
     case Ft::named_parameter_literal:
-      check_value_bound(fragment);
-      result += conn.to_quoted_literal(*fragment.value);
+      query += conn.to_quoted_literal(check_value_bound(fragment));
+      is_connection_dependent = true;
       break;
     case Ft::named_parameter_identifier:
-      check_value_bound(fragment);
-      result += conn.to_quoted_identifier(*fragment.value);
+      query += conn.to_quoted_identifier(check_value_bound(fragment));
+      is_connection_dependent = true;
       break;
     case Ft::positional_parameter:
-      result += '$';
-      result += fragment.str;
+      query += '$';
+      query += str(fragment);
       break;
     }
   }
-  return result;
+
+  result.is_simple = !positional_parameter_count() &&
+    result.named_parameters.empty() && !has_values_substituted_as_is;
+
+  // Calculate the 64-bit FNV-1a hash.
+  result.hash = 14695981039346656037ULL;
+  for (const unsigned char c : query) {
+    result.hash ^= c;
+    result.hash *= 1099511628211ULL;
+  }
+
+  // The connection dependent result is not cached.
+  auto ptr = std::make_shared<const Compiled>(std::move(result));
+  if (!is_connection_dependent)
+    std::atomic_store(&compiled_, ptr);
+  return ptr;
 }
 
 // ---------------------------------------------------------------------------
@@ -435,17 +627,17 @@ public:
   /// Denotes the fragment type.
   using Fragment = Statement::Fragment;
 
-  /// Denotes the fragment list type.
-  using Fragment_list = Statement::Fragment_list;
+  /// Denotes the fragment vector type.
+  using Fragment_vector = Statement::Fragment_vector;
 
   /// @returns The vector of associated extra data.
   static std::vector<std::pair<Key, Value>>
-  extract(const Fragment_list& fragments)
+  extract(const Statement& statement)
   {
     std::vector<std::pair<Key, Value>> result;
-    const auto iters = first_related_comments(fragments);
-    if (iters.first != cend(fragments)) {
-      const auto comments = joined_comments(iters.first, iters.second);
+    const auto iters = first_related_comments(statement);
+    if (iters.first != cend(statement.fragments_)) {
+      const auto comments = joined_comments(statement, iters.first, iters.second);
       for (const auto& comment : comments) {
         auto associations = extract(comment.first, comment.second);
         result.reserve(result.capacity() + associations.size());
@@ -696,10 +888,11 @@ private:
    *
    * @returns The pair of iterators that specifies the range of relevant comments.
    */
-  std::pair<Fragment_list::const_iterator, Fragment_list::const_iterator>
-  static first_related_comments(const Fragment_list& fragments)
+  std::pair<Fragment_vector::const_iterator, Fragment_vector::const_iterator>
+  static first_related_comments(const Statement& statement)
   {
     using Ft = Fragment::Type;
+    const auto& fragments = statement.fragments_;
     const auto b = cbegin(fragments);
     const auto e = cend(fragments);
     auto result = std::make_pair(e, e);
@@ -722,10 +915,11 @@ private:
      * Stops lookup when either named parameter or positional parameter are found.
      * (Only fragments of type `text` can have related comments.)
      */
-    auto i = find_if(b, e, [&is_nearby_string](const Fragment& f)
+    auto i = find_if(b, e, [&statement, &is_nearby_string](const Fragment& f)
     {
       return (f.type == Ft::text &&
-        is_nearby_string(f.str) && !str::is_blank(f.str)) ||
+        is_nearby_string(statement.str(f)) &&
+        !str::is_blank(statement.str(f))) ||
         f.type == Ft::named_parameter ||
         f.type == Ft::positional_parameter;
     });
@@ -734,9 +928,9 @@ private:
       do {
         --i;
         DMITIGR_ASSERT(is_comment(*i) ||
-          (is_text(*i) && str::is_blank(i->str)));
+          (is_text(*i) && str::is_blank(statement.str(*i))));
         if (i->type == Ft::text) {
-          if (!is_nearby_string(i->str))
+          if (!is_nearby_string(statement.str(*i)))
             break;
         }
         result.first = i;
@@ -755,16 +949,16 @@ private:
    *     appended to the result.
    */
   std::pair<std::pair<std::string, Extra::Comment_type>,
-    Fragment_list::const_iterator>
-  static joined_comments_of_same_type(Fragment_list::const_iterator i,
-    const Fragment_list::const_iterator e)
+    Fragment_vector::const_iterator>
+  static joined_comments_of_same_type(const Statement& statement,
+    Fragment_vector::const_iterator i, const Fragment_vector::const_iterator e)
   {
     using Ft = Fragment::Type;
     DMITIGR_ASSERT(is_comment(*i));
     std::string result;
     const auto fragment_type = i->type;
-    for (; i->type == fragment_type && i != e; ++i) {
-      result.append(i->str);
+    for (; i != e && i->type == fragment_type; ++i) {
+      result.append(statement.str(*i));
       if (fragment_type == Ft::one_line_comment)
         result.append("\n");
     }
@@ -790,13 +984,13 @@ private:
    *   - the type of the joined comments as second element.
    */
   std::vector<std::pair<std::string, Extra::Comment_type>>
-  static joined_comments(Fragment_list::const_iterator i,
-    const Fragment_list::const_iterator e)
+  static joined_comments(const Statement& statement,
+    Fragment_vector::const_iterator i, const Fragment_vector::const_iterator e)
   {
     std::vector<std::pair<std::string, Extra::Comment_type>> result;
     while (i != e) {
       if (is_comment(*i)) {
-        auto comments = joined_comments_of_same_type(i, e);
+        auto comments = joined_comments_of_same_type(statement, i, e);
         result.push_back(std::move(comments.first));
         i = comments.second;
       } else
@@ -809,9 +1003,9 @@ private:
 DMITIGR_PGFE_INLINE const Tuple& Statement::extra() const noexcept
 {
   if (!extra_)
-    extra_.emplace(Extra::extract(fragments_));
+    extra_.emplace(Extra::extract(*this));
   else if (is_extra_data_should_be_extracted_from_comments_)
-    extra_->append(Tuple{Extra::extract(fragments_)});
+    extra_->append(Tuple{Extra::extract(*this)});
   is_extra_data_should_be_extracted_from_comments_ = false;
   assert(is_invariant_ok());
   return *extra_;
@@ -850,40 +1044,53 @@ DMITIGR_PGFE_INLINE bool Statement::is_invariant_ok() const noexcept
 // Initializers
 // ---------------------------------------------------------------------------
 
+DMITIGR_PGFE_INLINE void Statement::clear() noexcept
+{
+  text_.clear();
+  fragments_.clear();
+  positional_parameters_.clear();
+  named_parameters_.clear();
+  is_extra_data_should_be_extracted_from_comments_ = true;
+  extra_.reset();
+  compiled_.reset();
+}
+
 DMITIGR_PGFE_INLINE void
-Statement::push_back_fragment(const Fragment::Type type, const std::string& str)
+Statement::push_back_fragment(const Fragment::Type type, const std::size_t offset)
 {
-  fragments_.emplace_back(type, str);
+  DMITIGR_ASSERT(offset <= text_.size());
+  fragments_.push_back({type, 0, offset, text_.size() - offset});
   assert(is_invariant_ok());
 }
 
 DMITIGR_PGFE_INLINE void
-Statement::push_text(const std::string& str)
+Statement::push_text(const std::size_t offset)
 {
-  push_back_fragment(Fragment::Type::text, str);
+  push_back_fragment(Fragment::Type::text, offset);
 }
 
 DMITIGR_PGFE_INLINE void
-Statement::push_one_line_comment(const std::string& str)
+Statement::push_one_line_comment(const std::size_t offset)
 {
-  push_back_fragment(Fragment::Type::one_line_comment, str);
+  push_back_fragment(Fragment::Type::one_line_comment, offset);
 }
 
 DMITIGR_PGFE_INLINE void
-Statement::push_multi_line_comment(const std::string& str)
+Statement::push_multi_line_comment(const std::size_t offset)
 {
-  push_back_fragment(Fragment::Type::multi_line_comment, str);
+  push_back_fragment(Fragment::Type::multi_line_comment, offset);
 }
 
 DMITIGR_PGFE_INLINE void
-Statement::push_positional_parameter(const std::string& str)
+Statement::push_positional_parameter(const std::size_t offset)
 {
-  push_back_fragment(Fragment::Type::positional_parameter, str);
+  push_back_fragment(Fragment::Type::positional_parameter, offset);
 
   using Size = std::vector<bool>::size_type;
-  const int position = stoi(str);
+  const std::string digits{str(fragments_.back())};
+  const int position = stoi(digits);
   if (position < 1 || static_cast<Size>(position) > max_parameter_count())
-    throw Client_exception{"invalid parameter position \"" + str + "\""};
+    throw Client_exception{"invalid parameter position \"" + digits + "\""};
   else if (static_cast<Size>(position) > positional_parameters_.size())
     positional_parameters_.resize(static_cast<Size>(position), false);
 
@@ -894,7 +1101,7 @@ Statement::push_positional_parameter(const std::string& str)
 }
 
 DMITIGR_PGFE_INLINE void
-Statement::push_named_parameter(const std::string& str, const char quote_char)
+Statement::push_named_parameter(const std::size_t offset, const char quote_char)
 {
   DMITIGR_ASSERT(!quote_char || is_quote_char(quote_char));
   if (parameter_count() < max_parameter_count()) {
@@ -902,13 +1109,14 @@ Statement::push_named_parameter(const std::string& str, const char quote_char)
     const auto type =
       quote_char == '\'' ? Ft::named_parameter_literal :
       quote_char == '\"' ? Ft::named_parameter_identifier : Ft::named_parameter;
-    push_back_fragment(type, str);
-    if (none_of(cbegin(named_parameters_), cend(named_parameters_),
-        [&str](const auto& i){return (i->str == str);})) {
-      auto e = cend(fragments_);
-      --e;
-      named_parameters_.push_back(e);
-    }
+    const std::string_view name{text_.data() + offset, text_.size() - offset};
+    const auto b = cbegin(named_parameters_);
+    const auto e = cend(named_parameters_);
+    const auto i = find_if(b, e, [this, name](const auto& p){return str(p) == name;});
+    if (i == e)
+      named_parameters_.push_back({offset, name.size(), type, std::nullopt});
+    fragments_.push_back({type, static_cast<std::uint32_t>(i - b),
+      offset, name.size()});
   } else
     throw Client_exception{"maximum parameters count (" +
       std::to_string(max_parameter_count()) + ") exceeded"};
@@ -920,32 +1128,87 @@ Statement::push_named_parameter(const std::string& str, const char quote_char)
 // Updaters
 // ---------------------------------------------------------------------------
 
-// Exception safety guarantee: basic.
-DMITIGR_PGFE_INLINE void Statement::update_cache(const Statement& rhs)
+DMITIGR_PGFE_INLINE void
+Statement::check_parameter_count(const std::size_t positional_count,
+  const std::size_t named_count) const
 {
-  // Prepare positional parameters for merge.
-  const auto old_pos_params_size = positional_parameters_.size();
-  const auto rhs_pos_params_size = rhs.positional_parameters_.size();
-  const auto new_pos_params_size = std::max(old_pos_params_size, rhs_pos_params_size);
-  positional_parameters_.resize(new_pos_params_size); // can throw
-
-  // Recreate the cache for named parameters. (Can throw.)
-  named_parameters_ = named_parameters();
-
-  // Check the new parameter count.
-  const auto new_parameter_count = new_pos_params_size + named_parameters_.size();
-  if (new_parameter_count > max_parameter_count())
+  const auto count = positional_count + named_count;
+  if (count > max_parameter_count())
     throw Client_exception{"parameter count (" +
-      std::to_string(new_parameter_count) + ") "
+      std::to_string(count) + ") "
       "exceeds the maximum (" + std::to_string(max_parameter_count()) + ")"};
+}
+
+// Exception safety guarantee: strong.
+DMITIGR_PGFE_INLINE void
+Statement::merge_positional_parameters(const std::vector<bool>& rhs)
+{
+  if (rhs.size() > positional_parameters_.size())
+    positional_parameters_.resize(rhs.size()); // can throw
 
-  // Merge positional parameters (cannot throw).
-  for (std::size_t i{}; i < rhs_pos_params_size; ++i) {
-    if (!positional_parameters_[i] && rhs.positional_parameters_[i])
+  // Cannot throw.
+  for (std::size_t i{}; i < rhs.size(); ++i) {
+    if (!positional_parameters_[i] && rhs[i])
       positional_parameters_[i] = true;
   }
+}
 
-  assert(is_invariant_ok());
+DMITIGR_PGFE_INLINE std::size_t Statement::live_text_size() const noexcept
+{
+  std::size_t result{};
+  for (const auto& param : named_parameters_)
+    result += param.size;
+  for (const auto& fragment : fragments_) {
+    if (!fragment.is_named_parameter())
+      result += fragment.size;
+  }
+  return result;
+}
+
+DMITIGR_PGFE_INLINE void Statement::compact_text(const std::string& source)
+{
+  // Copy the referenced text. (Can throw.)
+  std::string text;
+  text.reserve(live_text_size());
+  for (const auto& param : named_parameters_)
+    text.append(source, param.offset, param.size);
+  for (const auto& fragment : fragments_) {
+    if (!fragment.is_named_parameter())
+      text.append(source, fragment.offset, fragment.size);
+  }
+
+  // Update the offsets in the same order. (Cannot throw.)
+  std::size_t offset{};
+  for (auto& param : named_parameters_) {
+    param.offset = offset;
+    offset += param.size;
+  }
+  for (auto& fragment : fragments_) {
+    if (fragment.is_named_parameter())
+      fragment.offset = named_parameters_[fragment.parameter].offset;
+    else {
+      fragment.offset = offset;
+      offset += fragment.size;
+    }
+  }
+  DMITIGR_ASSERT(offset == text.size());
+  text_.swap(text);
+}
+
+// ---------------------------------------------------------------------------
+// Accessors
+// ---------------------------------------------------------------------------
+
+DMITIGR_PGFE_INLINE std::string_view
+Statement::str(const Fragment& f) const noexcept
+{
+  return {text_.data() + f.offset, f.size};
+}
+
+DMITIGR_PGFE_INLINE std::string_view
+Statement::str(const Named_parameter& p) const noexcept
+{
+  return {text_.data() + p.offset, p.size};
 }
 
 // ---------------------------------------------------------------------------
@@ -958,7 +1221,7 @@ Statement::named_parameter_type(const std::size_t index) const noexcept
 {
   DMITIGR_ASSERT(positional_parameter_count() <= index && index < parameter_count());
   const auto relative_index = index - positional_parameter_count();
-  return named_parameters_[relative_index]->type;
+  return named_parameters_[relative_index].type;
 }
 
 DMITIGR_PGFE_INLINE std::size_t
@@ -968,28 +1231,12 @@ Statement::named_parameter_index(const std::string_view name) const noexcept
   {
     const auto b = cbegin(named_parameters_);
     const auto e = cend(named_parameters_);
-    const auto i = find_if(b, e, [name](const auto& pi){return pi->str == name;});
+    const auto i = find_if(b, e, [this, name](const auto& p){return str(p) == name;});
     return static_cast<std::size_t>(i - b);
   }();
   return positional_parameter_count() + relative_index;
 }
 
-DMITIGR_PGFE_INLINE auto Statement::named_parameters() const
-  -> std::vector<Fragment_list::const_iterator>
-{
-  std::vector<Fragment_list::const_iterator> result;
-  result.reserve(8);
-  const auto e = cend(fragments_);
-  for (auto i = cbegin(fragments_); i != e; ++i) {
-    if (i->is_named_parameter()) {
-      if (none_of(cbegin(result), cend(result),
-          [i](const auto& result_i){return i->str == result_i->str;}))
-        result.push_back(i);
-    }
-  }
-  return result;
-}
-
 // ---------------------------------------------------------------------------
 // Predicates
 // ---------------------------------------------------------------------------
@@ -1092,6 +1339,39 @@ Statement::is_quote_char(const unsigned char c) noexcept
  */
 DMITIGR_PGFE_INLINE std::pair<Statement, std::string_view::size_type>
 Statement::parse_sql_input(const std::string_view text)
+{
+  /*
+   * The input is parsed into the thread-local instance in order to reuse its
+   * buffers. Thus, the resulting copy is allocated at once.
+   */
+  thread_local Statement result;
+  result.clear();
+  const auto size = lex_sql_input<true>(text, &result);
+  return std::make_pair(result, size);
+}
+
+/**
+ * @returns The same position as `parse_sql_input(text).second` without
+ * preparsing, or `text.size()` if the input is invalid.
+ */
+DMITIGR_PGFE_INLINE std::string_view::size_type
+Statement::sql_input_size(const std::string_view text) noexcept
+{
+  return lex_sql_input<false>(text, nullptr);
+}
+
+/**
+ * @brief Scans `text` up to the end of the first SQL string.
+ *
+ * @tparam IsPreparsing Denotes whether to preparse the SQL string into
+ * `result`. Otherwise, only the boundary of the SQL string is determined,
+ * `result` is not used and invalid input is not reported.
+ *
+ * @returns The position of a character that follows the SQL string.
+ */
+template<bool IsPreparsing>
+std::string_view::size_type
+Statement::lex_sql_input(const std::string_view text, Statement* const result)
 {
   enum {
     top,
@@ -1118,44 +1398,63 @@ Statement::parse_sql_input(const std::string_view text)
     multi_line_comment_star
   } state = top;
 
-  Statement result;
+  std::size_t start{};
+  const auto put = [result](const char c)
+  {
+    if constexpr (IsPreparsing)
+      result->text_ += c;
+  };
+  const auto push = [result, &start](void(Statement::* const push_fragment)(std::size_t))
+  {
+    if constexpr (IsPreparsing) {
+      (result->*push_fragment)(start);
+      start = result->text_.size();
+    }
+  };
+  const auto fail = [result, &text](const char* const message,
+    const bool is_context_needed) -> std::string_view::size_type
+  {
+    if constexpr (IsPreparsing) {
+      std::string what{message};
+      if (is_context_needed && !result->fragments_.empty())
+        what.append(" after: ").append(result->str(result->fragments_.back()));
+      throw Client_exception{what};
+    } else
+      return text.size();
+  };
+
   int depth{};
   char current_char{};
   char previous_char{};
   char quote_char{};
-  std::string fragment;
-  std::string dollar_quote_leading_tag_name;
-  std::string dollar_quote_trailing_tag_name;
-  const auto b = cbegin(text);
-  auto i = b;
-  for (const auto e = cend(text); i != e; previous_char = current_char, ++i) {
-    current_char = *i;
+  std::string_view dollar_quote_leading_tag_name;
+  std::size_t dollar_quote_trailing_tag_offset{};
+  const auto size = text.size();
+  std::size_t i{};
+  for (; i < size; previous_char = current_char, ++i) {
+    current_char = text[i];
     switch (state) {
     case top:
       switch (current_char) {
       case '\'':
-        state = quote;
-        quote_char = current_char;
-        fragment += current_char;
-        continue;
-
+        [[fallthrough]];
       case '"':
         state = quote;
         quote_char = current_char;
-        fragment += current_char;
+        put(current_char);
         continue;
 
       case '[':
         state = bracket;
         depth = 1;
-        fragment += current_char;
+        put(current_char);
         continue;
 
       case '$':
         if (!is_ident_char(previous_char))
           state = dollar;
         else
-          fragment += current_char;
+          put(current_char);
 
         continue;
 
@@ -1163,7 +1462,7 @@ Statement::parse_sql_input(const std::string_view text)
         if (previous_char != ':')
           state = colon;
         else
-          fragment += current_char;
+          put(current_char);
 
         continue;
 
@@ -1179,7 +1478,7 @@ Statement::parse_sql_input(const std::string_view text)
         goto finish;
 
       default:
-        fragment += current_char;
+        put(current_char);
         continue;
       } // switch (current_char)
 
@@ -1194,42 +1493,41 @@ Statement::parse_sql_input(const std::string_view text)
         state = top;
       }
 
-      fragment += current_char;
+      put(current_char);
       continue;
 
     case dollar:
       DMITIGR_ASSERT(previous_char == '$');
       if (isdigit(static_cast<unsigned char>(current_char))) {
         state = positional_parameter;
-        result.push_text(fragment);
-        fragment.clear();
+        push(&Statement::push_text);
         // The 1st digit of positional parameter (current_char) will be stored below.
       } else if (is_ident_char(current_char)) {
         if (current_char == '$') {
           state = dollar_quote;
+          dollar_quote_leading_tag_name = {};
         } else {
           state = dollar_quote_leading_tag;
-          dollar_quote_leading_tag_name += current_char;
+          dollar_quote_leading_tag_name = text.substr(i, 1);
         }
-        fragment += previous_char;
+        put(previous_char);
       } else {
         state = top;
-        fragment += previous_char;
+        put(previous_char);
       }
 
-      fragment += current_char;
+      put(current_char);
       continue;
 
     case positional_parameter:
       DMITIGR_ASSERT(isdigit(static_cast<unsigned char>(previous_char)));
       if (!isdigit(static_cast<unsigned char>(current_char))) {
         state = top;
-        result.push_positional_parameter(fragment);
-        fragment.clear();
+        push(&Statement::push_positional_parameter);
       }
 
       if (current_char != ';') {
-        fragment += current_char;
+        put(current_char);
         continue;
       } else
         goto finish;
@@ -1237,55 +1535,54 @@ Statement::parse_sql_input(const std::string_view text)
     case dollar_quote_leading_tag:
       DMITIGR_ASSERT(previous_char != '$' && is_ident_char(previous_char));
       if (current_char == '$') {
-        fragment += current_char;
+        put(current_char);
         state = dollar_quote;
       } else if (is_ident_char(current_char)) {
-        dollar_quote_leading_tag_name += current_char;
-        fragment += current_char;
+        dollar_quote_leading_tag_name = {dollar_quote_leading_tag_name.data(),
+          dollar_quote_leading_tag_name.size() + 1};
+        put(current_char);
       } else
-        throw Client_exception{"invalid dollar quote tag"};
+        return fail("invalid dollar quote tag", false);
 
       continue;
 
     case dollar_quote:
-      if (current_char == '$')
+      if (current_char == '$') {
         state = dollar_quote_dollar;
+        dollar_quote_trailing_tag_offset = i + 1;
+      }
 
-      fragment += current_char;
+      put(current_char);
       continue;
 
     case dollar_quote_dollar:
       if (current_char == '$') {
-        if (dollar_quote_leading_tag_name == dollar_quote_trailing_tag_name) {
-          state = top;
-          dollar_quote_leading_tag_name.clear();
-        } else
-          state = dollar_quote;
-
-        dollar_quote_trailing_tag_name.clear();
-      } else
-        dollar_quote_trailing_tag_name += current_char;
+        const auto trailing_tag_name = text.substr(
+          dollar_quote_trailing_tag_offset,
+          i - dollar_quote_trailing_tag_offset);
+        state = (dollar_quote_leading_tag_name == trailing_tag_name) ?
+          top : dollar_quote;
+      }
 
-      fragment += current_char;
+      put(current_char);
       continue;
 
     case colon:
       DMITIGR_ASSERT(previous_char == ':');
       if (is_ident_char(current_char) || is_quote_char(current_char)) {
         state = named_parameter;
-        result.push_text(fragment);
-        fragment.clear();
+        push(&Statement::push_text);
         // The 1st character of the named parameter (current_char) will be stored below.
       } else {
         state = top;
-        fragment += previous_char;
+        put(previous_char);
       }
 
       if (state == named_parameter && is_quote_char(current_char)) {
         quote_char = current_char;
         continue;
       } else if (current_char != ';') {
-        fragment += current_char;
+        put(current_char);
         continue;
       } else
         goto finish;
@@ -1296,15 +1593,17 @@ Statement::parse_sql_input(const std::string_view text)
 
       if (!is_ident_char(current_char)) {
         state = top;
-        result.push_named_parameter(fragment, quote_char);
-        fragment.clear();
+        if constexpr (IsPreparsing) {
+          result->push_named_parameter(start, quote_char);
+          start = result->text_.size();
+        }
       }
 
       if (current_char == quote_char) {
         quote_char = 0;
         continue;
       } if (current_char != ';') {
-        fragment += current_char;
+        put(current_char);
         continue;
       } else
         goto finish;
@@ -1313,7 +1612,7 @@ Statement::parse_sql_input(const std::string_view text)
       if (current_char == quote_char)
         state = quote_quote;
       else
-        fragment += current_char;
+        put(current_char);
 
       continue;
 
@@ -1325,11 +1624,11 @@ Statement::parse_sql_input(const std::string_view text)
       } else {
         state = top;
         quote_char = 0;
-        fragment += previous_char; // store previous quote
+        put(previous_char); // store previous quote
       }
 
       if (current_char != ';') {
-        fragment += current_char;
+        put(current_char);
         continue;
       } else
         goto finish;
@@ -1338,15 +1637,14 @@ Statement::parse_sql_input(const std::string_view text)
       DMITIGR_ASSERT(previous_char == '-');
       if (current_char == '-') {
         state = one_line_comment;
-        result.push_text(fragment);
-        fragment.clear();
+        push(&Statement::push_text);
         // The comment marker ("--") will not be included in the next fragment.
       } else {
         state = top;
-        fragment += previous_char;
+        put(previous_char);
 
         if (current_char != ';') {
-          fragment += current_char;
+          put(current_char);
           continue;
         } else
           goto finish;
@@ -1357,12 +1655,14 @@ Statement::parse_sql_input(const std::string_view text)
     case one_line_comment:
       if (current_char == '\n') {
         state = top;
-        if (!fragment.empty() && fragment.back() == '\r')
-          fragment.pop_back();
-        result.push_one_line_comment(fragment);
-        fragment.clear();
+        if constexpr (IsPreparsing) {
+          auto& text_buf = result->text_;
+          if (text_buf.size() > start && text_buf.back() == '\r')
+            text_buf.pop_back();
+        }
+        push(&Statement::push_one_line_comment);
       } else
-        fragment += current_char;
+        put(current_char);
 
       continue;
 
@@ -1371,18 +1671,17 @@ Statement::parse_sql_input(const std::string_view text)
       if (current_char == '*') {
         state = multi_line_comment;
         if (depth > 0) {
-          fragment += previous_char;
-          fragment += current_char;
+          put(previous_char);
+          put(current_char);
         } else {
-          result.push_text(fragment);
-          fragment.clear();
+          push(&Statement::push_text);
           // The comment marker ("/*") will not be included in the next fragment.
         }
         ++depth;
       } else {
         state = (depth == 0) ? top : multi_line_comment;
-        fragment += previous_char;
-        fragment += current_char;
+        put(previous_char);
+        put(current_char);
       }
 
       continue;
@@ -1393,7 +1692,7 @@ Statement::parse_sql_input(const std::string_view text)
       } else if (current_char == '*') {
         state = multi_line_comment_star;
       } else
-        fragment += current_char;
+        put(current_char);
 
       continue;
 
@@ -1403,17 +1702,16 @@ Statement::parse_sql_input(const std::string_view text)
         --depth;
         if (depth == 0) {
           state = top;
-          result.push_multi_line_comment(fragment); // without trailing "*/"
-          fragment.clear();
+          push(&Statement::push_multi_line_comment); // without trailing "*/"
         } else {
           state = multi_line_comment;
-          fragment += previous_char; // '*'
-          fragment += current_char;  // '/'
+          put(previous_char); // '*'
+          put(current_char);  // '/'
         }
       } else {
         state = multi_line_comment;
-        fragment += previous_char;
-        fragment += current_char;
+        put(previous_char);
+        put(current_char);
       }
 
       continue;
@@ -1423,36 +1721,35 @@ Statement::parse_sql_input(const std::string_view text)
  finish:
   switch (state) {
   case top:
-    if (current_char == ';')
+    if (i != size) // the loop was interrupted at ';'
       ++i;
-    if (!fragment.empty())
-      result.push_text(fragment);
+    if constexpr (IsPreparsing) {
+      if (result->text_.size() > start)
+        result->push_text(start);
+    }
     break;
   case quote_quote:
-    fragment += previous_char;
-    result.push_text(fragment);
+    put(previous_char);
+    push(&Statement::push_text);
     break;
   case one_line_comment:
-    result.push_one_line_comment(fragment);
+    push(&Statement::push_one_line_comment);
     break;
   case positional_parameter:
-    result.push_positional_parameter(fragment);
+    push(&Statement::push_positional_parameter);
     break;
   case named_parameter:
     if (!quote_char) {
-      result.push_named_parameter(fragment, quote_char);
+      if constexpr (IsPreparsing)
+        result->push_named_parameter(start, quote_char);
       break;
     }
     [[fallthrough]];
-  default: {
-    std::string message{"invalid SQL input"};
-    if (!result.fragments_.empty())
-      message.append(" after: ").append(result.fragments_.back().str);
-    throw Client_exception{message};
-  }
+  default:
+    return fail("invalid SQL input", true);
   }
 
-  return std::make_pair(result, i - b);
+  return i;
 }
 
 } // namespace dmitigr::pgfe
@@ -25,7 +25,7 @@
 
 #include <cctype>
 #include <cstdint>
-#include <list>
+#include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
@@ -290,9 +290,52 @@ public:
    *
    * @par Requires
    * `!has_missing_parameters() && conn.is_connected()`.
+   *
+   * @see compiled().
    */
   DMITIGR_PGFE_API std::string to_query_string(const Connection& conn) const;
 
+  /// A compiled form of statement.
+  struct Compiled final {
+    /// The query string that's actually passed to a PostgreSQL server.
+    std::string query;
+
+    /**
+     * The indexes of the unbound named parameters, relative to
+     * positional_parameter_count(). The `i`-th of them is denoted in `query`
+     * as `$n`, where `n` is `positional_parameter_count() + i + 1`.
+     */
+    std::vector<std::uint32_t> named_parameters;
+
+    /// The hash of `query` (64-bit FNV-1a), which is stable across processes.
+    std::uint64_t hash{};
+
+    /**
+     * `true` if `query` has no parameters and is guaranteed to consist of a
+     * single command, i.e. if no value bound to a named parameter which is
+     * neither literal nor identifier is substituted as is. Such a query can
+     * be executed by using the simple query protocol.
+     */
+    bool is_simple{};
+  };
+
+  /**
+   * @returns The compiled form of this instance.
+   *
+   * @par Requires
+   * `!has_missing_parameters() && conn.is_connected()`.
+   *
+   * @remarks The result is cached until either bind(), replace_parameter() or
+   * append() is called. The cache is not used if this instance contains named
+   * parameters declared as literals or identifiers, since their quoting depends
+   * on the connection.
+   *
+   * @par Thread safety
+   * This function can be called concurrently on the same instance.
+   */
+  DMITIGR_PGFE_API std::shared_ptr<const Compiled>
+  compiled(const Connection& conn) const;
+
   /// @returns The extra data associated with this instance.
   ///
   /// @details An any data can be associated with an object of type Statement.
@@ -395,7 +438,7 @@ private:
 
   /// A fragment.
   struct Fragment final {
-    enum class Type {
+    enum class Type : std::uint8_t {
       text,
       one_line_comment,
       multi_line_comment,
@@ -405,24 +448,38 @@ private:
       positional_parameter
     };
 
-    Fragment(const Type tp, const std::string& s);
     bool is_named_parameter() const noexcept;
-    bool is_named_parameter(const std::string_view name) const noexcept;
 
-    Type type;
-    std::string str;
+    Type type{};
+    std::uint32_t parameter{}; // index in named_parameters_ (named parameters only)
+    std::size_t offset{}; // of the content in text_
+    std::size_t size{}; // of the content in text_
+  };
+  using Fragment_vector = std::vector<Fragment>;
+
+  /// A named parameter.
+  struct Named_parameter final {
+    std::size_t offset{}; // of the name in text_
+    std::size_t size{}; // of the name in text_
+    Fragment::Type type{}; // of the first occurrence
     std::optional<std::string> value;
   };
-  using Fragment_list = std::list<Fragment>;
 
-  Fragment_list fragments_;
-  std::vector<bool> positional_parameters_; // cache
-  std::vector<Fragment_list::const_iterator> named_parameters_; // cache
+  std::string text_; // contents of all the fragments
+  Fragment_vector fragments_;
+  std::vector<bool> positional_parameters_;
+  std::vector<Named_parameter> named_parameters_; // in order of first occurrence
   mutable bool is_extra_data_should_be_extracted_from_comments_{true};
   mutable std::optional<Tuple> extra_; // cache
+  mutable std::shared_ptr<const Compiled> compiled_; // atomic cache
 
   static std::pair<Statement, std::string_view::size_type>
   parse_sql_input(std::string_view);
+  static std::string_view::size_type
+  sql_input_size(std::string_view) noexcept;
+  template<bool IsPreparsing>
+  static std::string_view::size_type
+  lex_sql_input(std::string_view, Statement*);
 
   bool is_invariant_ok() const noexcept override;
 
@@ -430,19 +487,30 @@ private:
   // Initializers
   // ---------------------------------------------------------------------------
 
-  void push_back_fragment(const Fragment::Type type, const std::string& str);
-  void push_text(const std::string& str);
-  void push_one_line_comment(const std::string& str);
-  void push_multi_line_comment(const std::string& str);
-  void push_positional_parameter(const std::string& str);
-  void push_named_parameter(const std::string& str, char quote_char);
+  void clear() noexcept;
+  void push_back_fragment(const Fragment::Type type, const std::size_t offset);
+  void push_text(const std::size_t offset);
+  void push_one_line_comment(const std::size_t offset);
+  void push_multi_line_comment(const std::size_t offset);
+  void push_positional_parameter(const std::size_t offset);
+  void push_named_parameter(const std::size_t offset, char quote_char);
 
   // ---------------------------------------------------------------------------
   // Updaters
   // ---------------------------------------------------------------------------
 
-  // Exception safety guarantee: strong.
-  void update_cache(const Statement& rhs);
+  void check_parameter_count(std::size_t positional_count,
+    std::size_t named_count) const;
+  void merge_positional_parameters(const std::vector<bool>& rhs);
+  std::size_t live_text_size() const noexcept;
+  void compact_text(const std::string& source);
+
+  // ---------------------------------------------------------------------------
+  // Accessors
+  // ---------------------------------------------------------------------------
+
+  std::string_view str(const Fragment& f) const noexcept;
+  std::string_view str(const Named_parameter& p) const noexcept;
 
   // ---------------------------------------------------------------------------
   // Named parameters helpers
@@ -450,7 +518,6 @@ private:
 
   Fragment::Type named_parameter_type(const std::size_t index) const noexcept;
   std::size_t named_parameter_index(const std::string_view name) const noexcept;
-  std::vector<Fragment_list::const_iterator> named_parameters() const;
 
   // ---------------------------------------------------------------------------
   // Predicates
@@ -17,20 +17,94 @@
 #include "../base/assert.hpp"
 #include "conversions.hpp"
 #include "exceptions.hpp"
+#include "../fsx/mapped_file.hpp"
 #include "statement_vector.hpp"
 
 #include <algorithm>
+#include <exception>
+#include <thread>
 
 namespace dmitigr::pgfe {
 
 DMITIGR_PGFE_INLINE Statement_vector::Statement_vector(std::string_view input)
 {
-  while (!input.empty()) {
-    auto [st, pos] = Statement::parse_sql_input(input);
-    statements_.emplace_back(std::move(st));
-    DMITIGR_ASSERT(pos <= input.size());
-    input = input.substr(pos);
+  parse(input, statements_);
+}
+
+DMITIGR_PGFE_INLINE Statement_vector::Statement_vector(
+  const std::string_view input, std::size_t thread_count)
+{
+  constexpr std::size_t min_chunk_size{65536};
+  if (!thread_count)
+    thread_count = std::max(std::thread::hardware_concurrency(), 1U);
+  thread_count = std::min(thread_count,
+    std::max(input.size() / min_chunk_size, std::size_t{1}));
+
+  /*
+   * Since the parsing of each statement starts from scratch, the input can be
+   * split right after any of the statements. Only the input preceding the
+   * last split is scanned serially.
+   */
+  std::vector<std::string_view> chunks;
+  chunks.reserve(thread_count);
+  {
+    const std::size_t chunk_size{input.size() / thread_count};
+    std::size_t start{};
+    std::size_t pos{};
+    while (chunks.size() + 1 < thread_count && pos < input.size()) {
+      pos += Statement::sql_input_size(input.substr(pos));
+      if (pos - start >= chunk_size) {
+        chunks.push_back(input.substr(start, pos - start));
+        start = pos;
+      }
+    }
+    if (start < input.size())
+      chunks.push_back(input.substr(start));
   }
+
+  if (chunks.size() <= 1) {
+    parse(input, statements_);
+    return;
+  }
+
+  const auto n = chunks.size();
+  std::vector<std::vector<Statement>> parts(n);
+  std::vector<std::exception_ptr> errors(n);
+  const auto parse_chunk = [&](const std::size_t index) noexcept
+  {
+    try {
+      parse(chunks[index], parts[index]);
+    } catch (...) {
+      errors[index] = std::current_exception();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(n - 1);
+  try {
+    for (std::size_t i{1}; i < n; ++i)
+      threads.emplace_back(parse_chunk, i);
+  } catch (...) {
+    for (auto& thread : threads)
+      thread.join();
+    throw;
+  }
+  parse_chunk(0);
+  for (auto& thread : threads)
+    thread.join();
+
+  // The error of the first invalid statement is the same as of serial parsing.
+  for (const auto& error : errors) {
+    if (error)
+      std::rethrow_exception(error);
+  }
+
+  std::size_t size{};
+  for (const auto& part : parts)
+    size += part.size();
+  statements_.reserve(size);
+  for (auto& part : parts)
+    std::move(begin(part), end(part), back_inserter(statements_));
 }
 
 DMITIGR_PGFE_INLINE
@@ -38,10 +112,20 @@ Statement_vector::Statement_vector(std::vector<Statement> statements)
   : statements_{std::move(statements)}
 {}
 
+DMITIGR_PGFE_INLINE Statement_vector
+Statement_vector::load(const std::filesystem::path& path,
+  const std::size_t thread_count)
+{
+  const fsx::Mapped_file file{path};
+  return Statement_vector{file.view(), thread_count};
+}
+
 DMITIGR_PGFE_INLINE void Statement_vector::swap(Statement_vector& rhs) noexcept
 {
   using std::swap;
   swap(statements_, rhs.statements_);
+  swap(indexed_extra_name_, rhs.indexed_extra_name_);
+  swap(index_, rhs.index_);
 }
 
 DMITIGR_PGFE_INLINE std::size_t Statement_vector::size() const noexcept
@@ -71,6 +155,16 @@ DMITIGR_PGFE_INLINE std::size_t Statement_vector::statement_index(
   const std::size_t offset, const std::size_t extra_offset) const noexcept
 {
   const auto sz = size();
+  if (!offset && !extra_offset && !indexed_extra_name_.empty() &&
+    extra_name == indexed_extra_name_) {
+    try {
+      const auto i = find_indexed(extra_value);
+      return i != cend(index_) ? i->second : sz;
+    } catch (...) {
+      // Fall back to the lookup without index.
+    }
+  }
+
   const auto b = cbegin(statements_);
   const auto e = cend(statements_);
   using Diff = decltype(b)::difference_type;
@@ -89,6 +183,47 @@ DMITIGR_PGFE_INLINE std::size_t Statement_vector::statement_index(
   return static_cast<std::size_t>(i - b);
 }
 
+DMITIGR_PGFE_INLINE void Statement_vector::index_by(std::string extra_name)
+{
+  if (extra_name.empty())
+    throw Client_exception{"cannot index Statement_vector: empty extra name"};
+
+  drop_index();
+  indexed_extra_name_ = std::move(extra_name);
+  try {
+    index_.reserve(statements_.size());
+    for (std::size_t i{}; i < statements_.size(); ++i)
+      index_statement(i);
+  } catch (...) {
+    drop_index();
+    throw;
+  }
+}
+
+DMITIGR_PGFE_INLINE const std::string&
+Statement_vector::indexed_extra_name() const noexcept
+{
+  return indexed_extra_name_;
+}
+
+DMITIGR_PGFE_INLINE void Statement_vector::drop_index() noexcept
+{
+  indexed_extra_name_.clear();
+  index_.clear();
+}
+
+DMITIGR_PGFE_INLINE const Statement&
+Statement_vector::statement(const std::string_view extra_value) const
+{
+  if (indexed_extra_name_.empty())
+    throw Client_exception{"cannot get from Statement_vector: no index"};
+  const auto i = find_indexed(extra_value);
+  if (i == cend(index_))
+    throw Client_exception{"cannot get from Statement_vector: "
+      "no statement with " + indexed_extra_name_ + " " + std::string{extra_value}};
+  return statements_[i->second];
+}
+
 DMITIGR_PGFE_INLINE const Statement&
 Statement_vector::operator[](const std::size_t index) const
 {
@@ -125,6 +260,13 @@ Statement_vector::query_absolute_position(const std::size_t index,
 DMITIGR_PGFE_INLINE void Statement_vector::append(Statement statement) noexcept
 {
   statements_.push_back(std::move(statement));
+  if (!indexed_extra_name_.empty()) {
+    try {
+      index_statement(statements_.size() - 1);
+    } catch (...) {
+      drop_index();
+    }
+  }
 }
 
 DMITIGR_PGFE_INLINE void Statement_vector::insert(const std::size_t index,
@@ -135,15 +277,62 @@ DMITIGR_PGFE_INLINE void Statement_vector::insert(const std::size_t index,
   const auto b = begin(statements_);
   using Diff = decltype(b)::difference_type;
   statements_.insert(b + static_cast<Diff>(index), std::move(statement));
+
+  if (!indexed_extra_name_.empty()) {
+    for (auto& [value, idx] : index_) {
+      if (idx >= index)
+        ++idx;
+    }
+    try {
+      index_statement(index);
+    } catch (...) {
+      drop_index();
+    }
+  }
 }
 
 DMITIGR_PGFE_INLINE void Statement_vector::remove(const std::size_t index)
 {
   if (!(index < size()))
     throw Client_exception{"cannot remove from Statement_vector"};
+
+  std::optional<std::string> value;
+  if (!indexed_extra_name_.empty()) {
+    try {
+      if (const auto v = indexed_value(statements_[index]))
+        value.emplace(*v);
+    } catch (...) {
+      drop_index();
+    }
+  }
+
   const auto b = begin(statements_);
   using Diff = decltype(b)::difference_type;
   statements_.erase(b + static_cast<Diff>(index));
+
+  if (!indexed_extra_name_.empty()) {
+    if (value) {
+      // Find the next statement with the same value, if any.
+      if (const auto i = index_.find(*value);
+        i != end(index_) && i->second == index) {
+        index_.erase(i);
+        try {
+          for (auto j = index; j < statements_.size(); ++j) {
+            if (indexed_value(statements_[j]) == *value) {
+              index_.emplace(std::move(*value), j + 1);
+              break;
+            }
+          }
+        } catch (...) {
+          drop_index();
+        }
+      }
+    }
+    for (auto& [val, idx] : index_) {
+      if (idx > index)
+        --idx;
+    }
+  }
 }
 
 DMITIGR_PGFE_INLINE std::string Statement_vector::to_string() const
@@ -170,4 +359,54 @@ Statement_vector::vector() noexcept
     static_cast<const Statement_vector*>(this)->vector());
 }
 
+DMITIGR_PGFE_INLINE std::optional<std::string_view>
+Statement_vector::indexed_value(const Statement& statement) const
+{
+  const auto& extra = statement.extra();
+  const auto idx = extra.field_index(indexed_extra_name_);
+  if (idx < extra.field_count()) {
+    if (const auto data = extra.data(idx))
+      return to<std::string_view>(data);
+  }
+  return std::nullopt;
+}
+
+DMITIGR_PGFE_INLINE void Statement_vector::index_statement(const std::size_t index)
+{
+  DMITIGR_ASSERT(index < size());
+  if (const auto value = indexed_value(statements_[index])) {
+    const auto [i, is_inserted] = index_.emplace(*value, index);
+    if (!is_inserted && index < i->second)
+      i->second = index;
+  }
+}
+
+DMITIGR_PGFE_INLINE auto
+Statement_vector::find_indexed(const std::string_view value) const
+  -> Index::const_iterator
+{
+#ifdef __cpp_lib_generic_unordered_lookup
+  return index_.find(value);
+#else
+  /*
+   * The heterogeneous lookup in unordered containers is available since
+   * C++20. Until then, the key is copied to the reused buffer.
+   */
+  thread_local std::string key;
+  key.assign(value);
+  return index_.find(key);
+#endif
+}
+
+DMITIGR_PGFE_INLINE void
+Statement_vector::parse(std::string_view input, std::vector<Statement>& result)
+{
+  while (!input.empty()) {
+    auto [st, pos] = Statement::parse_sql_input(input);
+    result.emplace_back(std::move(st));
+    DMITIGR_ASSERT(pos <= input.size());
+    input = input.substr(pos);
+  }
+}
+
 } // namespace dmitigr::pgfe
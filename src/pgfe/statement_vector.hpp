@@ -17,12 +17,16 @@
 #ifndef DMITIGR_PGFE_STATEMENT_VECTOR_HPP
 #define DMITIGR_PGFE_STATEMENT_VECTOR_HPP
 
+#include "../fsx/filesystem.hpp"
 #include "dll.hpp"
 #include "statement.hpp"
 #include "types_fwd.hpp"
 
+#include <functional>
+#include <optional>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <vector>
 
 namespace dmitigr::pgfe {
@@ -64,9 +68,39 @@ public:
    */
   explicit DMITIGR_PGFE_API Statement_vector(std::string_view input);
 
+  /**
+   * @brief Parses the input by using up to `thread_count` threads.
+   *
+   * @details The input is split at the boundaries of top-level statements into
+   * the chunks which are parsed concurrently. The result is identical to the
+   * result of the serial parsing.
+   *
+   * @param thread_count The maximum number of threads to use. The value of
+   * `0` denotes the number of concurrent threads supported by the system.
+   *
+   * @remarks Inputs less than 64 KiB are always parsed serially.
+   *
+   * @see Statement_vector(std::string_view).
+   */
+  DMITIGR_PGFE_API Statement_vector(std::string_view input,
+    std::size_t thread_count);
+
   /// @overload
   explicit DMITIGR_PGFE_API Statement_vector(std::vector<Statement> statements);
 
+  /**
+   * @returns The instance made from the content of the file at `path`.
+   *
+   * @details The file is memory-mapped rather than read and is parsed by using
+   * up to `thread_count` threads.
+   *
+   * @throws `std::system_error` if the file cannot be mapped.
+   *
+   * @see Statement_vector(std::string_view, std::size_t).
+   */
+  static DMITIGR_PGFE_API Statement_vector
+  load(const std::filesystem::path& path, std::size_t thread_count = 0);
+
   /// Swaps the instances.
   DMITIGR_PGFE_API void swap(Statement_vector& rhs) noexcept;
 
@@ -96,6 +130,46 @@ public:
     std::size_t offset = 0,
     std::size_t extra_offset = 0) const noexcept;
 
+  /**
+   * @brief Builds the hashed index of statements by the value of the extra
+   * data field named by `extra_name`.
+   *
+   * @details The index is maintained by append(), insert() and remove(). Once
+   * it's built, the lookups by statement() and statement_index() with the
+   * default offsets and `extra_name` do not scan this vector. If several
+   * statements share the same value, the one with the least index is found.
+   *
+   * @par Requires
+   * `!extra_name.empty()`.
+   *
+   * @remarks The index must be rebuilt by calling this method after modifying
+   * the extra data of statements via non-constant operator[]() or vector().
+   * If append(), insert() or remove() cannot maintain the index (i.e. upon
+   * the memory allocation failure), the index is dropped rather than an
+   * exception is thrown, and the vector itself is modified as requested.
+   * Thus, indexed_extra_name() should be checked to detect this.
+   *
+   * @see Statement::extra().
+   */
+  DMITIGR_PGFE_API void index_by(std::string extra_name);
+
+  /// @returns The name of the indexed extra data field, or empty string.
+  DMITIGR_PGFE_API const std::string& indexed_extra_name() const noexcept;
+
+  /// Drops the index.
+  DMITIGR_PGFE_API void drop_index() noexcept;
+
+  /**
+   * @returns The statement with the value of the indexed extra data field
+   * equals to `extra_value`.
+   *
+   * @par Requires
+   * `!indexed_extra_name().empty()` and the statement must exist.
+   *
+   * @see index_by().
+   */
+  DMITIGR_PGFE_API const Statement& statement(std::string_view extra_value) const;
+
   /**
    * @returns The statement that owns by this vector.
    *
@@ -121,7 +195,13 @@ public:
   DMITIGR_PGFE_API std::string::size_type
   query_absolute_position(std::size_t index, const Connection& conn) const;
 
-  /// Appends the `statement` to this vector.
+  /**
+   * @brief Appends the `statement` to this vector.
+   *
+   * @remarks The index is dropped if it cannot be maintained.
+   *
+   * @see index_by().
+   */
   DMITIGR_PGFE_API void append(Statement statement) noexcept;
 
   /**
@@ -129,6 +209,10 @@ public:
    *
    * @par Requires
    * `index < size()`.
+   *
+   * @remarks The index is dropped if it cannot be maintained.
+   *
+   * @see index_by().
    */
   DMITIGR_PGFE_API void insert(std::size_t index, Statement statement);
 
@@ -137,6 +221,10 @@ public:
    *
    * @par Requires
    * `index < size()`.
+   *
+   * @remarks The index is dropped if it cannot be maintained.
+   *
+   * @see index_by().
    */
   DMITIGR_PGFE_API void remove(std::size_t index);
 
@@ -153,7 +241,27 @@ public:
   DMITIGR_PGFE_API std::vector<Statement>& vector() noexcept;
 
 private:
+  /// The hash of both the keys and the string views to look up.
+  struct Index_hash final {
+    using is_transparent = void;
+
+    std::size_t operator()(const std::string_view value) const noexcept
+    {
+      return std::hash<std::string_view>{}(value);
+    }
+  };
+  using Index = std::unordered_map<std::string, std::size_t, Index_hash,
+    std::equal_to<>>;
+
   std::vector<Statement> statements_;
+  std::string indexed_extra_name_;
+  Index index_;
+
+  std::optional<std::string_view> indexed_value(const Statement& statement) const;
+  void index_statement(std::size_t index);
+  Index::const_iterator find_indexed(std::string_view value) const;
+
+  static void parse(std::string_view input, std::vector<Statement>& result);
 };
 
 /**
@@ -0,0 +1,257 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "connection.hpp"
+#include "exceptions.hpp"
+#include "text_copy_writer.hpp"
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64) || \
+  (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DMITIGR_PGFE_COPY_SIMD
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+namespace dmitigr::pgfe {
+
+namespace detail {
+
+#ifdef DMITIGR_PGFE_COPY_SIMD
+/// @returns The index of the least significant bit set in the non-zero `mask`.
+inline unsigned count_trailing_zeros(const unsigned mask) noexcept
+{
+#ifdef _MSC_VER
+  unsigned long result;
+  _BitScanForward(&result, mask);
+  return static_cast<unsigned>(result);
+#else
+  return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+#endif
+
+DMITIGR_PGFE_INLINE const char* find_any_of(const char* begin,
+  const char* const end, const char c0, const char c1, const char c2,
+  const char c3) noexcept
+{
+#ifdef __AVX2__
+  {
+    const auto v0 = _mm256_set1_epi8(c0);
+    const auto v1 = _mm256_set1_epi8(c1);
+    const auto v2 = _mm256_set1_epi8(c2);
+    const auto v3 = _mm256_set1_epi8(c3);
+    for (; end - begin >= 32; begin += 32) {
+      const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+      const auto m = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, v0), _mm256_cmpeq_epi8(v, v1)),
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, v2), _mm256_cmpeq_epi8(v, v3)));
+      if (const auto mask = static_cast<unsigned>(_mm256_movemask_epi8(m)))
+        return begin + count_trailing_zeros(mask);
+    }
+  }
+#endif
+#ifdef DMITIGR_PGFE_COPY_SIMD
+  {
+    const auto v0 = _mm_set1_epi8(c0);
+    const auto v1 = _mm_set1_epi8(c1);
+    const auto v2 = _mm_set1_epi8(c2);
+    const auto v3 = _mm_set1_epi8(c3);
+    for (; end - begin >= 16; begin += 16) {
+      const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+      const auto m = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(v, v0), _mm_cmpeq_epi8(v, v1)),
+        _mm_or_si128(_mm_cmpeq_epi8(v, v2), _mm_cmpeq_epi8(v, v3)));
+      if (const auto mask = static_cast<unsigned>(_mm_movemask_epi8(m)))
+        return begin + count_trailing_zeros(mask);
+    }
+  }
+#endif
+  for (; begin != end; ++begin) {
+    const char c{*begin};
+    if (c == c0 || c == c1 || c == c2 || c == c3)
+      break;
+  }
+  return begin;
+}
+
+DMITIGR_PGFE_INLINE void append_copy_text_field(std::string& buffer,
+  const std::string_view value, const char delimiter)
+{
+  const char* begin{value.data()};
+  const char* const end{begin + value.size()};
+  while (true) {
+    const char* const special{find_any_of(begin, end,
+      '\\', '\n', '\r', delimiter)};
+    buffer.append(begin, special);
+    if (special == end)
+      break;
+
+    buffer.push_back('\\');
+    switch (*special) {
+    case '\n': buffer.push_back('n'); break;
+    case '\r': buffer.push_back('r'); break;
+    case '\t': buffer.push_back('t'); break;
+    default: buffer.push_back(*special);
+    }
+    begin = special + 1;
+  }
+}
+
+DMITIGR_PGFE_INLINE void append_copy_csv_field(std::string& buffer,
+  const std::string_view value, const char delimiter, const char quote,
+  const bool force_quote)
+{
+  const char* begin{value.data()};
+  const char* const end{begin + value.size()};
+  if (!force_quote && !value.empty() && value != "\\." &&
+    find_any_of(begin, end, delimiter, quote, '\n', '\r') == end) {
+    buffer.append(value);
+    return;
+  }
+
+  buffer.push_back(quote);
+  while (true) {
+    const char* const special{find_any_of(begin, end,
+      quote, quote, quote, quote)};
+    buffer.append(begin, special);
+    if (special == end)
+      break;
+
+    buffer.push_back(quote);
+    buffer.push_back(quote);
+    begin = special + 1;
+  }
+  buffer.push_back(quote);
+}
+
+} // namespace detail
+
+DMITIGR_PGFE_INLINE Text_copy_writer::Text_copy_writer(Copier& copier,
+  const Copy_text_format format, const std::size_t buffer_size)
+  : stream_{copier, buffer_size}
+  , format_{format}
+  , delimiter_{format == Copy_text_format::text ? '\t' : ','}
+  , null_string_{format == Copy_text_format::text ? "\\N" : ""}
+{
+  for (std::size_t i{}; i < copier.field_count(); ++i) {
+    if (copier.data_format(i) != Data_format::text)
+      throw Client_exception{"cannot create text COPY writer: "
+        "COPY is not in text format"};
+  }
+}
+
+DMITIGR_PGFE_INLINE Copy_text_format Text_copy_writer::format() const noexcept
+{
+  return format_;
+}
+
+DMITIGR_PGFE_INLINE Text_copy_writer&
+Text_copy_writer::set_delimiter(const char value)
+{
+  if (value == '\\' || value == '\n' || value == '\r')
+    throw Client_exception{"cannot set text COPY writer delimiter: "
+      "invalid value"};
+  else if (format_ == Copy_text_format::text &&
+    (value == '.' || (value >= 'a' && value <= 'z') ||
+      (value >= '0' && value <= '9')))
+    throw Client_exception{"cannot set text COPY writer delimiter: "
+      "invalid value for text format"};
+  else if (format_ == Copy_text_format::csv && value == quote_)
+    throw Client_exception{"cannot set text COPY writer delimiter: "
+      "delimiter must not be equal to quote"};
+  delimiter_ = value;
+  return *this;
+}
+
+DMITIGR_PGFE_INLINE char Text_copy_writer::delimiter() const noexcept
+{
+  return delimiter_;
+}
+
+DMITIGR_PGFE_INLINE Text_copy_writer&
+Text_copy_writer::set_null_string(std::string value)
+{
+  null_string_ = std::move(value);
+  return *this;
+}
+
+DMITIGR_PGFE_INLINE const std::string&
+Text_copy_writer::null_string() const noexcept
+{
+  return null_string_;
+}
+
+DMITIGR_PGFE_INLINE Text_copy_writer& Text_copy_writer::set_quote(const char value)
+{
+  if (value == delimiter_)
+    throw Client_exception{"cannot set text COPY writer quote: "
+      "quote must not be equal to delimiter"};
+  quote_ = value;
+  return *this;
+}
+
+DMITIGR_PGFE_INLINE char Text_copy_writer::quote() const noexcept
+{
+  return quote_;
+}
+
+DMITIGR_PGFE_INLINE void Text_copy_writer::flush()
+{
+  stream_.flush();
+}
+
+DMITIGR_PGFE_INLINE void Text_copy_writer::finish()
+{
+  stream_.finish();
+}
+
+DMITIGR_PGFE_INLINE void
+Text_copy_writer::abort(const std::string& error_message)
+{
+  stream_.abort(error_message);
+}
+
+DMITIGR_PGFE_INLINE std::size_t Text_copy_writer::buffered_size() const noexcept
+{
+  return stream_.buffered_size();
+}
+
+DMITIGR_PGFE_INLINE void
+Text_copy_writer::check_field_count(const std::size_t count) const
+{
+  if (count != stream_.copier().field_count())
+    throw Client_exception{"cannot write COPY tuple: "
+      "field count mismatch"};
+}
+
+DMITIGR_PGFE_INLINE void
+Text_copy_writer::append_string(const std::string_view value)
+{
+  if (format_ == Copy_text_format::text)
+    detail::append_copy_text_field(stream_.buffer(), value, delimiter_);
+  else
+    detail::append_copy_csv_field(stream_.buffer(), value, delimiter_, quote_,
+      value == null_string_);
+}
+
+DMITIGR_PGFE_INLINE void Text_copy_writer::append_null()
+{
+  stream_.buffer().append(null_string_);
+}
+
+} // namespace dmitigr::pgfe
@@ -0,0 +1,352 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DMITIGR_PGFE_TEXT_COPY_WRITER_HPP
+#define DMITIGR_PGFE_TEXT_COPY_WRITER_HPP
+
+#include "basics.hpp"
+#include "binary_copy_writer.hpp"
+#include "buffered_copier.hpp"
+#include "conversions_api.hpp"
+#include "copier.hpp"
+#include "data.hpp"
+#include "dll.hpp"
+#include "types_fwd.hpp"
+
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <locale>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace dmitigr::pgfe {
+
+/// The implementation details.
+namespace detail {
+
+/**
+ * @returns The pointer to the first character in range `[begin, end)` which is
+ * equal to any of `c0`, `c1`, `c2` or `c3`, or `end` if there is no such
+ * a character.
+ *
+ * @details The range is scanned by 32 (AVX2) or 16 (SSE2) bytes at once if
+ * the target supports it.
+ */
+DMITIGR_PGFE_API const char* find_any_of(const char* begin, const char* end,
+  char c0, char c1, char c2, char c3) noexcept;
+
+/**
+ * @brief Appends the `value` escaped according to the text format of `COPY`
+ * to the `buffer`.
+ */
+DMITIGR_PGFE_API void append_copy_text_field(std::string& buffer,
+  std::string_view value, char delimiter);
+
+/**
+ * @brief Appends the `value` quoted (if necessary) according to the CSV format
+ * of `COPY` to the `buffer`.
+ *
+ * @param force_quote Indicates whether to quote the `value` unconditionally.
+ */
+DMITIGR_PGFE_API void append_copy_csv_field(std::string& buffer,
+  std::string_view value, char delimiter, char quote, bool force_quote);
+
+} // namespace detail
+
+/**
+ * @ingroup utilities
+ *
+ * @brief A writer of the data in either text or CSV format of
+ * `COPY ... FROM STDIN`.
+ *
+ * @details The writer encodes each tuple passed to write() into a line of the
+ * specified format and sends it through Buffered_copier. The special characters
+ * of the fields are escaped (text format) or the fields are quoted (CSV
+ * format). The spans of the fields which doesn't require escaping are copied
+ * to the buffer in bulk. The following field types are supported:
+ *   - `std::string`, `std::string_view`, `const char*`, Data, Data_view;
+ *   - `bool` (encoded as `t` or `f`);
+ *   - arithmetic types (formatted regardless of the locale);
+ *   - `std::optional<T>`, `std::nullopt`, `nullptr` (`NULL`);
+ *   - any other type `T` for which Conversions<T> is specialized (the result
+ *   of to_data() is used).
+ *
+ * @remarks The options of the writer (delimiter, null string and quote) must
+ * match the options of the `COPY` command.
+ */
+class Text_copy_writer final {
+public:
+  /**
+   * @brief The constructor.
+   *
+   * @param copier The copier to send the data through.
+   * @param format The format of the data.
+   * @param buffer_size The size of data accumulated before sending.
+   *
+   * @par Requires
+   * `copier.data_direction() == Data_direction::to_server` and each field of
+   * the copier must be of Data_format::text format.
+   *
+   * @par Effects
+   * The delimiter, null string and quote are set to the defaults of `COPY`
+   * for the `format`.
+   *
+   * @remarks The `copier` must outlive the instance.
+   */
+  explicit DMITIGR_PGFE_API Text_copy_writer(Copier& copier,
+    Copy_text_format format = Copy_text_format::text,
+    std::size_t buffer_size = 65536);
+
+  /// Not copy-constructible.
+  Text_copy_writer(const Text_copy_writer&) = delete;
+
+  /// Not copy-assignable.
+  Text_copy_writer& operator=(const Text_copy_writer&) = delete;
+
+  /// Move-constructible.
+  Text_copy_writer(Text_copy_writer&&) = default;
+
+  /// Not move-assignable.
+  Text_copy_writer& operator=(Text_copy_writer&&) = delete;
+
+  /// @returns The format of the data.
+  DMITIGR_PGFE_API Copy_text_format format() const noexcept;
+
+  /**
+   * @brief Sets the delimiter of fields.
+   *
+   * @par Requires
+   * `value` must not be either `\\`, `\n` or `\r`. For the text format
+   * `value` must not be either `.`, lowercase ASCII letter or digit.
+   */
+  DMITIGR_PGFE_API Text_copy_writer& set_delimiter(char value);
+
+  /// @returns The delimiter of fields.
+  DMITIGR_PGFE_API char delimiter() const noexcept;
+
+  /**
+   * @brief Sets the string which represents `NULL`.
+   *
+   * @remarks In the text format, the values which are equal to the `value` are
+   * indistinguishable from `NULL`.
+   */
+  DMITIGR_PGFE_API Text_copy_writer& set_null_string(std::string value);
+
+  /// @returns The string which represents `NULL`.
+  DMITIGR_PGFE_API const std::string& null_string() const noexcept;
+
+  /**
+   * @brief Sets the quote character of the CSV format.
+   *
+   * @par Requires
+   * `value != delimiter()`.
+   */
+  DMITIGR_PGFE_API Text_copy_writer& set_quote(char value);
+
+  /// @returns The quote character of the CSV format.
+  DMITIGR_PGFE_API char quote() const noexcept;
+
+  /**
+   * @brief Writes the tuple of `fields`.
+   *
+   * @details The arguments of type either `std::tuple` or `std::pair` are
+   * expanded, i.e. their elements are written as the fields of the tuple.
+   *
+   * @par Requires
+   * The number of fields (after expansion) must be equal to
+   * `copier.field_count()`.
+   *
+   * @remarks If a field cannot be converted, nothing is written.
+   */
+  template<typename ... Types>
+  void write(const Types& ... fields)
+  {
+    constexpr std::size_t count{(std::size_t{} + ... +
+      detail::Binary_copy_field_count<std::decay_t<Types>>::value)};
+    check_field_count(count);
+    write_tuple([this, &fields...]
+    {
+      std::size_t index{};
+      (append_field(index, fields), ...);
+    });
+  }
+
+  /**
+   * @brief Writes the tuple which fields are the elements of the `range`.
+   *
+   * @par Requires
+   * The size of `range` must be equal to `copier.field_count()`.
+   *
+   * @remarks If a field cannot be converted, nothing is written.
+   */
+  template<class Range>
+  void write_range(const Range& range)
+  {
+    check_field_count(static_cast<std::size_t>(
+      std::distance(std::cbegin(range), std::cend(range))));
+    write_tuple([this, &range]
+    {
+      std::size_t index{};
+      for (const auto& field : range)
+        append_field(index, field);
+    });
+  }
+
+  /// Sends the accumulated data to the server.
+  DMITIGR_PGFE_API void flush();
+
+  /**
+   * @brief Sends the accumulated data and the end-of-data indication to the
+   * server.
+   *
+   * @par Effects
+   * `!copier`.
+   *
+   * @see Copier::end().
+   */
+  DMITIGR_PGFE_API void finish();
+
+  /**
+   * @brief Discards the accumulated data and forces the `COPY` to fail.
+   *
+   * @par Effects
+   * `!copier`.
+   */
+  DMITIGR_PGFE_API void abort(const std::string& error_message);
+
+  /// @returns The size of the data accumulated but not yet sent.
+  DMITIGR_PGFE_API std::size_t buffered_size() const noexcept;
+
+private:
+  Buffered_copier stream_;
+  Copy_text_format format_{};
+  char delimiter_{};
+  char quote_{'"'};
+  std::string null_string_;
+
+  void check_field_count(std::size_t count) const;
+  void append_string(std::string_view value);
+  void append_null();
+
+  /**
+   * @brief Appends the fields appended by `append_fields` followed by the end
+   * of the tuple.
+   *
+   * @details If `append_fields` throws, the partially appended tuple is
+   * discarded, so the buffer never contains an incomplete line.
+   */
+  template<typename F>
+  void write_tuple(const F& append_fields)
+  {
+    auto& buffer = stream_.buffer();
+    const auto tuple_offset = buffer.size();
+    try {
+      append_fields();
+      buffer.push_back('\n');
+    } catch (...) {
+      buffer.resize(tuple_offset);
+      throw;
+    }
+    stream_.flush_if_full();
+  }
+
+  template<typename T>
+  void append_field(std::size_t& index, const T& value)
+  {
+    if constexpr (detail::Is_tuple<std::decay_t<T>>::value) {
+      std::apply([this, &index](const auto& ... elements)
+      {
+        (append_field(index, elements), ...);
+      }, value);
+    } else {
+      if (index++)
+        stream_.buffer().push_back(delimiter_);
+      append_value(value);
+    }
+  }
+
+  template<typename T>
+  void append_value(const T& value)
+  {
+    using U = std::decay_t<T>;
+    auto& buffer = stream_.buffer();
+    if constexpr (std::is_same_v<U, std::nullopt_t> ||
+      std::is_same_v<U, std::nullptr_t>) {
+      append_null();
+    } else if constexpr (detail::Is_optional<U>::value) {
+      if (value)
+        append_value(*value);
+      else
+        append_null();
+    } else if constexpr (std::is_same_v<U, bool>) {
+      buffer.push_back(value ? 't' : 'f');
+    } else if constexpr (std::is_same_v<U, char>) {
+      append_string({&value, 1});
+    } else if constexpr (std::is_integral_v<U>) {
+      char bytes[std::numeric_limits<U>::digits10 + 3];
+      const auto result = std::to_chars(bytes, bytes + sizeof(bytes), value);
+      buffer.append(bytes, result.ptr);
+    } else if constexpr (std::is_floating_point_v<U>) {
+      // The representation must not depend on LC_NUMERIC.
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+      char bytes[64];
+      const auto result = std::to_chars(bytes, bytes + sizeof(bytes), value);
+      buffer.append(bytes, result.ptr);
+#else
+      std::ostringstream stream;
+      stream.imbue(std::locale::classic());
+      stream.precision(std::numeric_limits<U>::max_digits10);
+      stream << value;
+      buffer.append(stream.str());
+#endif
+    } else if constexpr (std::is_same_v<U, std::string> ||
+      std::is_same_v<U, std::string_view>) {
+      append_string(value);
+    } else if constexpr (std::is_same_v<U, const char*> ||
+      std::is_same_v<U, char*>) {
+      if (const char* const str = value)
+        append_string(str);
+      else
+        append_null();
+    } else if constexpr (std::is_base_of_v<Data, U> ||
+      std::is_same_v<U, Data_view>) {
+      if (value)
+        append_string({static_cast<const char*>(value.bytes()), value.size()});
+      else
+        append_null();
+    } else {
+      if (const auto data = to_data(value))
+        append_string({static_cast<const char*>(data->bytes()), data->size()});
+      else
+        append_null();
+    }
+  }
+};
+
+} // namespace dmitigr::pgfe
+
+#ifndef DMITIGR_PGFE_NOT_HEADER_ONLY
+#include "text_copy_writer.cpp"
+#endif
+
+#endif  // DMITIGR_PGFE_TEXT_COPY_WRITER_HPP
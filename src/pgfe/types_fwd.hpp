@@ -34,10 +34,12 @@ namespace dmitigr::pgfe {
 enum class Channel_binding;
 enum class Communication_mode;
 enum class Connection_status;
+enum class Copy_text_format;
 enum class Data_direction;
 enum class Data_format;
 enum class External_library;
 enum class Password_encryption;
+enum class Pipeline_error_policy;
 enum class Pipeline_status;
 enum class Problem_severity;
 enum class Response_status;
@@ -60,6 +62,9 @@ enum class Large_object_seek_whence;
 // Classes
 // -----------------------------------------------------------------------------
 
+class Binary_copy_reader;
+class Binary_copy_writer;
+class Buffered_copier;
 class Completion;
 class Composite;
 class Compositional;
@@ -67,14 +72,20 @@ class Connection;
 class Connection_options;
 class Connection_pool;
 class Copier;
+class Copy_exporter;
 class Data;
 class Data_view;
 class Error;
 class Large_object;
+class Large_object_streambuf;
 class Message;
 class Notice;
 class Notification;
+class Parallel_copier;
+class Parallel_large_object_transfer;
 class Parameterizable;
+class Pipeline_executor;
+class Pipelined_large_object;
 class Prepared_statement;
 class Named_argument;
 class Problem;
@@ -85,8 +96,10 @@ class Row_info;
 class Signal;
 class Statement;
 class Statement_vector;
+class Text_copy_writer;
 class Transaction_guard;
 class Tuple;
+class Uv_connection;
 
 class Exception;
 class Client_exception;
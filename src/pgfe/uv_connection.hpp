@@ -0,0 +1,433 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DMITIGR_PGFE_UV_CONNECTION_HPP
+#define DMITIGR_PGFE_UV_CONNECTION_HPP
+
+#include "basics.hpp"
+#include "completion.hpp"
+#include "connection.hpp"
+#include "error.hpp"
+#include "exceptions.hpp"
+#include "row.hpp"
+#include "statement.hpp"
+
+#include <uv.h>
+
+#include <cassert>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <utility>
+
+namespace dmitigr::pgfe {
+
+/**
+ * @ingroup main
+ *
+ * @brief An adapter which drives a Connection from the libuv event loop.
+ *
+ * @details The adapter registers the connection socket with `uv_poll_t` and
+ * calls Connection::connect_nio(), Connection::read_input(),
+ * Connection::handle_input() and Connection::flush_output() from the loop
+ * callbacks. Rows, completions and errors of the requests submitted by
+ * execute() are delivered to the handlers on the loop thread. Notifications
+ * and notices are delivered to the handlers of the underlying Connection
+ * (which are also called on the loop thread).
+ *
+ * Requests are queued by the adapter and sent to the server as soon as the
+ * connection becomes ready for them. If the pipeline is enabled on the
+ * underlying connection, several requests are sent without waiting for the
+ * responses of the previous ones.
+ *
+ * @remarks This header is available only if pgfe is built with the CMake
+ * option `DMITIGR_PGFE_UV`, and is not included by `pgfe.hpp`.
+ *
+ * @remarks The functions of this class must be called on the loop thread. The
+ * instance must not be destroyed from within its handlers.
+ */
+class Uv_connection final {
+public:
+  /// The alias of the handler of the connection establishment.
+  using Connect_handler = std::function<void()>;
+
+  /// The alias of the handler of rows.
+  using Row_handler = std::function<void(Row&&)>;
+
+  /**
+   * @brief The alias of the handler of request results.
+   *
+   * @details Exactly one of the arguments is valid, unless the request is
+   * skipped by the server due to the aborted pipeline, in which case both of
+   * them are invalid.
+   */
+  using Result_handler = std::function<void(Completion&&, Error&&)>;
+
+  /**
+   * @brief The alias of the handler of client-side failures.
+   *
+   * @details After calling this handler the connection socket is no longer
+   * polled, and all the queued requests are discarded.
+   */
+  using Failure_handler = std::function<void(std::exception_ptr)>;
+
+  /**
+   * @brief The destructor.
+   *
+   * @details Calls close().
+   */
+  ~Uv_connection() noexcept
+  {
+    close();
+  }
+
+  /**
+   * @brief The constructor.
+   *
+   * @par Requires
+   * `loop`.
+   *
+   * @remarks Both `loop` and `connection` must outlive the instance.
+   */
+  Uv_connection(uv_loop_t* const loop, Connection& connection)
+    : loop_{loop}
+    , connection_{connection}
+  {
+    if (!loop_)
+      throw Client_exception{"cannot create libuv connection adapter: "
+        "null loop given"};
+  }
+
+  /// Not copy-constructible.
+  Uv_connection(const Uv_connection&) = delete;
+
+  /// Not copy-assignable.
+  Uv_connection& operator=(const Uv_connection&) = delete;
+
+  /// Not move-constructible.
+  Uv_connection(Uv_connection&&) = delete;
+
+  /// Not move-assignable.
+  Uv_connection& operator=(Uv_connection&&) = delete;
+
+  /// @returns The underlying connection.
+  Connection& connection() noexcept
+  {
+    return connection_;
+  }
+
+  /// @overload
+  const Connection& connection() const noexcept
+  {
+    return connection_;
+  }
+
+  /// Sets the handler of client-side failures.
+  void set_failure_handler(Failure_handler handler)
+  {
+    failure_handler_ = std::move(handler);
+  }
+
+  /// @returns The handler of client-side failures.
+  const Failure_handler& failure_handler() const noexcept
+  {
+    return failure_handler_;
+  }
+
+  /**
+   * @brief Initiates the connection establishment.
+   *
+   * @details The `handler` is called on the loop thread when the connection is
+   * established. The failure handler is called on failure.
+   *
+   * @par Requires
+   * `!is_polling()`.
+   */
+  void connect(Connect_handler handler)
+  {
+    if (is_polling())
+      throw Client_exception{"cannot connect via libuv adapter: "
+        "already in progress"};
+
+    connect_handler_ = std::move(handler);
+    connection_.connect_nio();
+    continue_connect();
+  }
+
+  /**
+   * @brief Starts to poll the already connected connection.
+   *
+   * @par Requires
+   * `connection().is_connected()`.
+   */
+  void attach()
+  {
+    if (!connection_.is_connected())
+      throw Client_exception{"cannot attach libuv adapter: not connected"};
+    else if (!is_polling()) {
+      connection_.set_nio_output_enabled(true);
+      start_poll(UV_READABLE);
+    }
+  }
+
+  /**
+   * @brief Enqueues the request to execute the `statement`.
+   *
+   * @details The request is sent as soon as the connection is ready for it.
+   * The `on_row` is called for each row, and the `on_result` is called once the
+   * request is completed either successfully or with an error.
+   *
+   * @par Requires
+   * `is_polling()`.
+   *
+   * @remarks Both `statement` and `parameters` are copied.
+   */
+  template<typename ... Types>
+  void execute(Row_handler on_row, Result_handler on_result,
+    const Statement& statement, Types&& ... parameters)
+  {
+    if (!is_polling())
+      throw Client_exception{"cannot execute via libuv adapter: "
+        "not polling"};
+
+    pending_.push(Request{
+      [statement, params = std::make_tuple(std::forward<Types>(parameters)...)]
+      (Connection& conn)
+      {
+        std::apply([&conn, &statement](const auto& ... ps)
+        {
+          conn.execute_nio(statement, ps...);
+        }, params);
+      }, std::move(on_row), std::move(on_result)});
+    submit_pending();
+  }
+
+  /// @returns `true` if the connection socket is polled.
+  bool is_polling() const noexcept
+  {
+    return static_cast<bool>(poll_);
+  }
+
+  /// @returns The number of requests which are not yet completed.
+  std::size_t request_count() const noexcept
+  {
+    return pending_.size() + sent_.size();
+  }
+
+  /**
+   * @brief Stops polling the connection socket.
+   *
+   * @details All the queued requests are discarded. The connection itself is
+   * not closed.
+   */
+  void close() noexcept
+  {
+    if (poll_) {
+      uv_poll_stop(poll_);
+      poll_->data = nullptr;
+      uv_close(reinterpret_cast<uv_handle_t*>(poll_), [](uv_handle_t* const h)
+      {
+        delete reinterpret_cast<uv_poll_t*>(h);
+      });
+      poll_ = nullptr;
+      polled_socket_ = -1;
+      events_ = 0;
+    }
+    pending_ = {};
+    sent_ = {};
+  }
+
+private:
+  struct Request final {
+    std::function<void(Connection&)> submit;
+    Row_handler on_row;
+    Result_handler on_result;
+  };
+
+  uv_loop_t* loop_{};
+  Connection& connection_;
+  uv_poll_t* poll_{};
+  int polled_socket_{-1};
+  int events_{};
+  Connect_handler connect_handler_;
+  Failure_handler failure_handler_;
+  std::queue<Request> pending_;
+  std::queue<Request> sent_;
+
+  void start_poll(const int events)
+  {
+    const int sock = connection_.socket();
+    if (poll_ && sock != polled_socket_)
+      close_poll_only();
+
+    if (!poll_) {
+      auto poll = std::make_unique<uv_poll_t>();
+      if (uv_poll_init_socket(loop_, poll.get(), sock))
+        throw Client_exception{"cannot initialize libuv poll handle"};
+      poll_ = poll.release();
+      poll_->data = this;
+      polled_socket_ = sock;
+      events_ = 0;
+    }
+
+    if (events != events_) {
+      if (uv_poll_start(poll_, events, &on_poll))
+        throw Client_exception{"cannot start libuv poll handle"};
+      events_ = events;
+    }
+  }
+
+  void close_poll_only() noexcept
+  {
+    auto pending = std::move(pending_);
+    auto sent = std::move(sent_);
+    close();
+    pending_ = std::move(pending);
+    sent_ = std::move(sent);
+  }
+
+  void continue_connect()
+  {
+    using Status = Connection_status;
+    switch (connection_.status()) {
+    case Status::establishment_reading:
+      start_poll(UV_READABLE);
+      break;
+    case Status::establishment_writing:
+      start_poll(UV_WRITABLE);
+      break;
+    case Status::connected:
+      connection_.set_nio_output_enabled(true);
+      start_poll(UV_READABLE);
+      if (connect_handler_)
+        std::exchange(connect_handler_, nullptr)();
+      break;
+    case Status::failure:
+      [[fallthrough]];
+    case Status::disconnected:
+      throw Client_exception{"cannot connect via libuv adapter"};
+    }
+  }
+
+  void submit_pending()
+  {
+    while (!pending_.empty() && connection_.is_ready_for_nio_request()) {
+      pending_.front().submit(connection_);
+      sent_.push(std::move(pending_.front()));
+      pending_.pop();
+    }
+    if (poll_)
+      start_poll(connection_.flush_output() ?
+        UV_READABLE : UV_READABLE | UV_WRITABLE);
+  }
+
+  void dispatch()
+  {
+    /*
+     * Notifications are delivered by Connection::handle_input(), which must
+     * be called even if there are no requests (e.g. on a listening connection).
+     */
+    if (connection_.is_connected() && !connection_.has_uncompleted_request())
+      connection_.handle_input();
+
+    while (connection_.is_connected() &&
+      connection_.has_uncompleted_request() &&
+      connection_.handle_input() != Response_status::unready) {
+      if (auto err = connection_.error()) {
+        if (!sent_.empty()) {
+          auto req = std::move(sent_.front());
+          sent_.pop();
+          if (req.on_result)
+            req.on_result(Completion{}, std::move(err));
+        }
+      } else if (auto row = connection_.row()) {
+        if (!sent_.empty() && sent_.front().on_row)
+          sent_.front().on_row(std::move(row));
+      } else if (!connection_.has_response()) {
+        // No response between the results of the pipelined requests.
+        continue;
+      } else if (auto comp = connection_.completion()) {
+        if (!sent_.empty()) {
+          auto req = std::move(sent_.front());
+          sent_.pop();
+          if (req.on_result)
+            req.on_result(std::move(comp), Error{});
+        }
+      } else if (connection_.ready_for_query()) {
+        continue;
+      } else if (connection_.pipeline_status() == Pipeline_status::aborted) {
+        // The request is skipped by the server due to the aborted pipeline.
+        if (!sent_.empty()) {
+          auto req = std::move(sent_.front());
+          sent_.pop();
+          if (req.on_result)
+            req.on_result(Completion{}, Error{});
+        }
+      } else
+        break;
+    }
+
+    if (!connection_.is_connected())
+      throw Client_exception{"libuv adapter: connection lost"};
+  }
+
+  void handle_events(const int status, const int events)
+  {
+    if (status < 0)
+      throw Client_exception{std::string{"libuv poll error: "}
+        .append(uv_strerror(status))};
+
+    using Status = Connection_status;
+    const auto s = connection_.status();
+    if (s == Status::establishment_reading ||
+      s == Status::establishment_writing) {
+      connection_.connect_nio();
+      continue_connect();
+      return;
+    }
+
+    if (events & UV_WRITABLE)
+      connection_.flush_output();
+
+    if (events & UV_READABLE) {
+      connection_.read_input();
+      dispatch();
+    }
+
+    submit_pending();
+  }
+
+  static void on_poll(uv_poll_t* const handle, const int status,
+    const int events) noexcept
+  {
+    auto* const self = static_cast<Uv_connection*>(handle->data);
+    if (!self)
+      return;
+
+    try {
+      self->handle_events(status, events);
+    } catch (...) {
+      self->close();
+      if (self->failure_handler_)
+        self->failure_handler_(std::current_exception());
+    }
+  }
+};
+
+} // namespace dmitigr::pgfe
+
+#endif  // DMITIGR_PGFE_UV_CONNECTION_HPP
@@ -17,7 +17,23 @@
 #ifndef DMITIGR_UTIL_DIAGNOSTIC_HPP
 #define DMITIGR_UTIL_DIAGNOSTIC_HPP
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 namespace dmitigr::util {
 
@@ -44,6 +60,300 @@ auto with_measure(const F& f)
   return chrono::duration_cast<D>(end - start);
 }
 
+// -----------------------------------------------------------------------------
+// Benchmarking
+// -----------------------------------------------------------------------------
+
+namespace detail {
+inline const volatile void* volatile do_not_optimize_sink;
+} // namespace detail
+
+/**
+ * @brief Prevents the compiler from optimizing away the computation of the
+ * `value`.
+ */
+template<typename T>
+inline void do_not_optimize(const T& value) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  detail::do_not_optimize_sink = &value;
+#endif
+}
+
+/**
+ * @brief Prevents the compiler from optimizing away or reordering the writes
+ * to the memory.
+ */
+inline void clobber_memory() noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : : "memory");
+#else
+  detail::do_not_optimize_sink = nullptr;
+#endif
+}
+
+/// The options of benchmark().
+struct Benchmark_options final {
+  /// The minimum duration of the warm-up phase.
+  std::chrono::nanoseconds warmup_time{std::chrono::milliseconds{20}};
+
+  /**
+   * @brief The minimum duration of a sample.
+   *
+   * @details The number of iterations per sample is adjusted during the
+   * warm-up phase to reach this duration.
+   */
+  std::chrono::nanoseconds sample_time{std::chrono::milliseconds{2}};
+
+  /// The number of samples.
+  std::size_t sample_count{30};
+
+  /**
+   * @brief Indicates whether to collect the hardware counters.
+   *
+   * @remarks The counters are available on Linux only and only if the access
+   * to `perf_event_open(2)` is permitted.
+   */
+  bool is_hardware_counters_enabled{};
+};
+
+/// The values of the hardware counters per iteration.
+struct Hardware_counters final {
+  double cycles{};
+  double instructions{};
+  double cache_misses{};
+  double branch_misses{};
+};
+
+/// The result of benchmark().
+struct Benchmark_result final {
+  /// The name of the benchmark.
+  std::string name;
+
+  /// The number of iterations per sample.
+  std::size_t iteration_count{};
+
+  /// The durations of an iteration in nanoseconds sorted in ascending order.
+  std::vector<double> samples;
+
+  /// The hardware counters if collected.
+  std::optional<Hardware_counters> hardware_counters;
+
+  /**
+   * @returns The `p`-th percentile of the samples by the nearest-rank method.
+   *
+   * @par Requires
+   * `!samples.empty() && 0 <= p && p <= 1`.
+   */
+  double percentile(const double p) const noexcept
+  {
+    const auto rank = static_cast<std::size_t>(std::ceil(p * samples.size()));
+    return samples[std::max<std::size_t>(rank, 1) - 1];
+  }
+
+  /// @returns The fastest sample.
+  double min() const noexcept
+  {
+    return samples.front();
+  }
+
+  /// @returns The median of samples.
+  double median() const noexcept
+  {
+    const auto n = samples.size();
+    return n % 2 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+  }
+
+  /// @returns The arithmetic mean of samples.
+  double mean() const noexcept
+  {
+    double result{};
+    for (const auto s : samples)
+      result += s;
+    return result / samples.size();
+  }
+
+  /// @returns The slowest sample.
+  double max() const noexcept
+  {
+    return samples.back();
+  }
+};
+
+/// Prints the `result` in a single line.
+inline std::ostream& operator<<(std::ostream& os, const Benchmark_result& result)
+{
+  os << result.name << ": median " << result.median()
+     << " ns, p99 " << result.percentile(.99)
+     << " ns, min " << result.min()
+     << " ns (" << result.samples.size() << " x "
+     << result.iteration_count << " iterations)";
+  if (const auto& hc = result.hardware_counters) {
+    os << ", " << hc->cycles << " cycles, "
+       << hc->instructions << " instructions, "
+       << hc->cache_misses << " cache misses, "
+       << hc->branch_misses << " branch misses";
+  }
+  return os;
+}
+
+namespace detail {
+
+/// The group of hardware counters.
+class Perf_counters final {
+public:
+  Perf_counters(const Perf_counters&) = delete;
+  Perf_counters& operator=(const Perf_counters&) = delete;
+
+  /// Opens the counters. Leaves the instance invalid on failure.
+  Perf_counters() noexcept
+  {
+#ifdef __linux__
+    const std::uint64_t configs[]{PERF_COUNT_HW_CPU_CYCLES,
+      PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES,
+      PERF_COUNT_HW_BRANCH_MISSES};
+    for (std::size_t i{}; i < size; ++i) {
+      perf_event_attr attr{};
+      attr.size = sizeof(attr);
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = configs[i];
+      attr.disabled = !i;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_GROUP;
+      fds_[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1,
+        i ? fds_[0] : -1, 0));
+      if (fds_[i] < 0) {
+        close();
+        return;
+      }
+    }
+#endif
+  }
+
+  /// The destructor.
+  ~Perf_counters()
+  {
+    close();
+  }
+
+  /// @returns `true` if the counters are opened.
+  bool is_valid() const noexcept
+  {
+    return fds_[0] >= 0;
+  }
+
+  /// Resets and starts the counters.
+  void start() noexcept
+  {
+#ifdef __linux__
+    ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+  }
+
+  /// Stops the counters and returns their values divided by `divisor`.
+  std::optional<Hardware_counters> stop(const double divisor) noexcept
+  {
+#ifdef __linux__
+    ioctl(fds_[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    struct {
+      std::uint64_t nr;
+      std::uint64_t values[size];
+    } data{};
+    if (read(fds_[0], &data, sizeof(data)) != sizeof(data) || data.nr != size)
+      return std::nullopt;
+    return Hardware_counters{data.values[0] / divisor,
+      data.values[1] / divisor, data.values[2] / divisor,
+      data.values[3] / divisor};
+#else
+    (void)divisor;
+    return std::nullopt;
+#endif
+  }
+
+private:
+  static constexpr std::size_t size{4};
+  int fds_[size]{-1, -1, -1, -1};
+
+  void close() noexcept
+  {
+#ifdef __linux__
+    for (auto& fd : fds_) {
+      if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+      }
+    }
+#endif
+  }
+};
+
+} // namespace detail
+
+/**
+ * @brief Measures the duration of call of `f`.
+ *
+ * @details Calls `f` repeatedly during the warm-up phase to adjust the number
+ * of iterations per sample, and then collects `options.sample_count` samples.
+ * The results of `f` should be passed to do_not_optimize().
+ *
+ * @par Requires
+ * `options.sample_count > 0`.
+ */
+template<typename F>
+Benchmark_result benchmark(std::string name, F&& f,
+  const Benchmark_options& options = {})
+{
+  using Clock = std::chrono::steady_clock;
+  using Ns = std::chrono::duration<double, std::nano>;
+  const auto run = [&f](const std::size_t count)
+  {
+    const auto started = Clock::now();
+    for (std::size_t i{}; i < count; ++i)
+      f();
+    return Ns{Clock::now() - started};
+  };
+
+  // Warm up and adjust the iteration count.
+  const Ns sample_time{options.sample_time};
+  std::size_t count{1};
+  for (const auto started = Clock::now();;) {
+    const auto elapsed = run(count);
+    if (elapsed < sample_time) {
+      const auto scale = elapsed.count() > 0 ? sample_time / elapsed : 10;
+      count = static_cast<std::size_t>(std::ceil(count *
+        std::clamp(scale * 1.2, 2., 10.)));
+    } else if (Clock::now() - started >= options.warmup_time) {
+      count = std::max<std::size_t>(1,
+        static_cast<std::size_t>(std::ceil(count * (sample_time / elapsed))));
+      break;
+    }
+  }
+
+  // Measure.
+  Benchmark_result result;
+  result.name = std::move(name);
+  result.iteration_count = count;
+  result.samples.reserve(options.sample_count);
+  std::optional<detail::Perf_counters> counters;
+  if (options.is_hardware_counters_enabled) {
+    counters.emplace();
+    if (counters->is_valid())
+      counters->start();
+  }
+  for (std::size_t i{}; i < options.sample_count; ++i)
+    result.samples.push_back(run(count).count() / count);
+  if (counters && counters->is_valid())
+    result.hardware_counters = counters->stop(
+      static_cast<double>(count) * options.sample_count);
+  std::sort(result.samples.begin(), result.samples.end());
+  return result;
+}
+
 } // namespace dmitigr::util
 
 #endif  // DMITIGR_UTIL_DIAGNOSTIC_HPP
@@ -0,0 +1,212 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+// Usage: dmitigr_pgfe-pool_contention [--pool=N] [--threads=N[,N...]]
+//   [--duration=milliseconds]
+//
+// Measures the contention on Connection_pool by running the threads which
+// acquire and release the connections (with and without a trivial query).
+
+#include "pgfe-unit.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace pgfe = dmitigr::pgfe;
+namespace util = dmitigr::util;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options final {
+  std::size_t pool_size{4};
+  std::vector<std::size_t> thread_counts{1, 2, 4, 8, 16};
+  std::chrono::milliseconds duration{2000};
+};
+
+Options parse_options(const int argc, char* const argv[])
+{
+  Options result;
+  for (int i{1}; i < argc; ++i) {
+    const std::string_view arg{argv[i]};
+    const auto eq = arg.find('=');
+    const auto name = arg.substr(0, eq);
+    const std::string value{eq != std::string_view::npos ?
+      arg.substr(eq + 1) : std::string_view{}};
+    if (name == "--pool")
+      result.pool_size = std::stoul(value);
+    else if (name == "--threads") {
+      result.thread_counts.clear();
+      std::istringstream s{value};
+      for (std::string n; std::getline(s, n, ',');)
+        result.thread_counts.push_back(std::stoul(n));
+    } else if (name == "--duration")
+      result.duration = std::chrono::milliseconds{std::stoul(value)};
+    else
+      throw std::runtime_error{"unknown option " + std::string{arg}};
+  }
+  if (!result.pool_size || result.thread_counts.empty() ||
+    std::count(result.thread_counts.begin(), result.thread_counts.end(), 0))
+    throw std::runtime_error{"invalid options"};
+  return result;
+}
+
+/// The statistics of a worker thread.
+struct Worker_stats final {
+  std::size_t acquire_count{};
+  std::size_t retry_count{};
+  std::vector<double> latencies; // of acquiring in nanoseconds
+};
+
+/// @returns Jain's fairness index of the acquire counts.
+double fairness(const std::vector<Worker_stats>& stats)
+{
+  double sum{};
+  double sum_of_squares{};
+  for (const auto& s : stats) {
+    sum += s.acquire_count;
+    sum_of_squares += static_cast<double>(s.acquire_count) * s.acquire_count;
+  }
+  return sum_of_squares > 0 ? sum * sum / (stats.size() * sum_of_squares) : 0;
+}
+
+void run(pgfe::Connection_pool& pool, const Options& opts,
+  const std::size_t thread_count, const bool is_query)
+{
+  const pgfe::Statement query{"select 1"};
+  std::vector<Worker_stats> stats(thread_count);
+  std::atomic_bool is_started{};
+  std::atomic_bool is_stopped{};
+  std::atomic_bool is_failed{};
+
+  const auto worker = [&](Worker_stats& stat)
+  {
+    stat.latencies.reserve(65536);
+    while (!is_started)
+      std::this_thread::yield();
+    try {
+      while (!is_stopped) {
+        const auto started = Clock::now();
+        auto handle = pool.connection();
+        while (!handle && !is_stopped) {
+          ++stat.retry_count;
+          std::this_thread::yield();
+          handle = pool.connection();
+        }
+        if (!handle)
+          break;
+        stat.latencies.push_back(
+          std::chrono::duration<double, std::nano>{Clock::now() - started}
+          .count());
+        if (is_query)
+          handle->execute(query);
+        handle.release();
+        ++stat.acquire_count;
+      }
+    } catch (const std::exception& e) {
+      std::cerr << e.what() << std::endl;
+      is_failed = true;
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(thread_count);
+  for (auto& stat : stats)
+    threads.emplace_back(worker, std::ref(stat));
+  const auto started = Clock::now();
+  is_started = true;
+  std::this_thread::sleep_for(opts.duration);
+  is_stopped = true;
+  for (auto& thread : threads)
+    thread.join();
+  const std::chrono::duration<double> elapsed{Clock::now() - started};
+  if (is_failed)
+    throw std::runtime_error{"worker failed"};
+
+  util::Benchmark_result latency;
+  std::size_t acquire_count{};
+  std::size_t retry_count{};
+  std::size_t min_count{stats.front().acquire_count};
+  std::size_t max_count{};
+  for (auto& s : stats) {
+    latency.samples.insert(latency.samples.end(),
+      s.latencies.begin(), s.latencies.end());
+    acquire_count += s.acquire_count;
+    retry_count += s.retry_count;
+    min_count = std::min(min_count, s.acquire_count);
+    max_count = std::max(max_count, s.acquire_count);
+  }
+  if (latency.samples.empty())
+    throw std::runtime_error{"no connections acquired"};
+  std::sort(latency.samples.begin(), latency.samples.end());
+
+  std::cout << std::left << std::setw(8) << (is_query ? "query" : "idle")
+            << std::right << std::setw(8) << thread_count
+            << std::setw(12) << std::fixed << std::setprecision(0)
+            << acquire_count / elapsed.count()
+            << std::setprecision(2)
+            << std::setw(10) << latency.median() / 1000
+            << std::setw(10) << latency.percentile(.9) / 1000
+            << std::setw(10) << latency.percentile(.99) / 1000
+            << std::setw(12) << latency.max() / 1000
+            << std::setw(10) << static_cast<double>(retry_count) / acquire_count
+            << std::setw(10) << fairness(stats)
+            << std::setw(10) << min_count
+            << std::setw(10) << max_count << std::endl;
+}
+
+} // namespace
+
+int main(const int argc, char* const argv[])
+try {
+  const auto opts = parse_options(argc, argv);
+  pgfe::Connection_pool pool{opts.pool_size, pgfe::test::connection_options()};
+  pool.connect();
+
+  std::cout << "pool size " << opts.pool_size
+            << ", duration " << opts.duration.count() << " ms"
+            << ", latencies of acquiring in us\n"
+            << std::left << std::setw(8) << "mode"
+            << std::right << std::setw(8) << "threads"
+            << std::setw(12) << "acquires/s"
+            << std::setw(10) << "p50"
+            << std::setw(10) << "p90"
+            << std::setw(10) << "p99"
+            << std::setw(12) << "max"
+            << std::setw(10) << "retries"
+            << std::setw(10) << "fairness"
+            << std::setw(10) << "min"
+            << std::setw(10) << "max" << std::endl;
+  for (const bool is_query : {false, true}) {
+    for (const auto thread_count : opts.thread_counts)
+      run(pool, opts, thread_count, is_query);
+  }
+} catch (const std::exception& e) {
+  std::cerr << e.what() << std::endl;
+  return 1;
+} catch (...) {
+  std::cerr << "unknown error" << std::endl;
+  return 2;
+}
@@ -14,95 +14,639 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+// Usage: dmitigr_pgfe-pq_vs_pgfe [--rows=N] [--queries=N] [--size=N]
+//   [--depth=N] [--warmup=N] [--repeat=N] [--scenario=name[,name...]] [--json]
+
 #include "pgfe-unit.hpp"
 
 #include <libpq-fe.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <memory>
 #include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace pgfe = dmitigr::pgfe;
+
+namespace {
 
-const char* const query = "select generate_series(1,1000000)";
+// -----------------------------------------------------------------------------
+// Options
+// -----------------------------------------------------------------------------
 
-struct Result final {
-  int length{};
-  int format{};
-  char* value{};
-  int is_null{};
-  std::unique_ptr<PGresult> res_;
+struct Options final {
+  unsigned long row_count{100000}; // for the streaming scenarios
+  unsigned long query_count{1000}; // for the per-query scenarios
+  unsigned long value_size{1048576}; // for the large value scenarios
+  unsigned long pipeline_depth{100}; // the number of queries per sync
+  unsigned long warmup_count{1};
+  unsigned long repeat_count{5};
+  std::vector<std::string> scenarios; // empty means all
+  bool is_json{};
 };
 
-auto result(PGresult* res)
+Options parse_options(const int argc, char* const argv[])
 {
-  Result r;
-  r.length = PQgetlength(res, 0, 0);
-  r.format = PQfformat(res, 0);
-  r.value = PQgetvalue(res, 0, 0);
-  r.is_null = PQgetisnull(res, 0, 0);
-  r.res_.reset(res);
-  return r;
+  Options result;
+  for (int i{1}; i < argc; ++i) {
+    const std::string_view arg{argv[i]};
+    const auto eq = arg.find('=');
+    const auto name = arg.substr(0, eq);
+    const std::string value{eq != std::string_view::npos ?
+      arg.substr(eq + 1) : std::string_view{}};
+    const auto number = [&value, &name]
+    {
+      const auto result = std::stoul(value);
+      if (!result)
+        throw std::runtime_error{"invalid value of " + std::string{name}};
+      return result;
+    };
+    if (name == "--rows")
+      result.row_count = number();
+    else if (name == "--queries")
+      result.query_count = number();
+    else if (name == "--size")
+      result.value_size = number();
+    else if (name == "--depth")
+      result.pipeline_depth = number();
+    else if (name == "--warmup")
+      result.warmup_count = std::stoul(value);
+    else if (name == "--repeat")
+      result.repeat_count = number();
+    else if (name == "--scenario") {
+      std::istringstream s{value};
+      for (std::string n; std::getline(s, n, ',');)
+        result.scenarios.push_back(n);
+    } else if (name == "--json")
+      result.is_json = true;
+    else
+      throw std::runtime_error{"unknown option " + std::string{arg}};
+  }
+  return result;
 }
 
-void test_pq()
-{
-  auto* const conn = PQconnectdb("hostaddr=127.0.0.1 user=pgfe_test"
-    " password=pgfe_test dbname=pgfe_test connect_timeout=7");
-
-  if (!conn)
-    throw std::bad_alloc{};
+// -----------------------------------------------------------------------------
+// libpq helpers
+// -----------------------------------------------------------------------------
 
-  if (PQstatus(conn) != CONNECTION_OK) {
+struct Pq_conn_deleter final {
+  void operator()(PGconn* const conn) const noexcept
+  {
     PQfinish(conn);
-    throw std::runtime_error{"cannot connect to server"};
   }
+};
 
-  if (!PQsendQuery(conn, query)) {
-    PQfinish(conn);
-    throw std::runtime_error{"cannot send query"};
+struct Pq_result_deleter final {
+  void operator()(PGresult* const res) const noexcept
+  {
+    PQclear(res);
   }
+};
 
-  if (!PQsetSingleRowMode(conn)) {
-    PQfinish(conn);
-    throw std::runtime_error{"cannot switch to single row mode"};
-  }
+using Pq_conn = std::unique_ptr<PGconn, Pq_conn_deleter>;
+using Pq_result = std::unique_ptr<PGresult, Pq_result_deleter>;
 
-  while (auto* const res = PQgetResult(conn)) {
-    switch (PQresultStatus(res)) {
-    case PGRES_TUPLES_OK:
-      PQclear(res);
+Pq_conn pq_connect()
+{
+  Pq_conn result{PQconnectdb("hostaddr=127.0.0.1 user=pgfe_test"
+    " password=pgfe_test dbname=pgfe_test connect_timeout=7")};
+  if (!result)
+    throw std::bad_alloc{};
+  else if (PQstatus(result.get()) != CONNECTION_OK)
+    throw std::runtime_error{PQerrorMessage(result.get())};
+  return result;
+}
+
+Pq_result pq_check(PGconn* const conn, Pq_result res,
+  const ExecStatusType expected)
+{
+  if (!res)
+    throw std::runtime_error{PQerrorMessage(conn)};
+  else if (PQresultStatus(res.get()) != expected)
+    throw std::runtime_error{PQresultErrorMessage(res.get())};
+  return res;
+}
+
+void pq_exec(PGconn* const conn, const char* const query)
+{
+  Pq_result res{PQexec(conn, query)};
+  if (!res)
+    throw std::runtime_error{PQerrorMessage(conn)};
+  else if (const auto s = PQresultStatus(res.get());
+    s != PGRES_COMMAND_OK && s != PGRES_TUPLES_OK)
+    throw std::runtime_error{PQresultErrorMessage(res.get())};
+}
+
+/// Waits the results of a query sent in single-row mode.
+template<typename F>
+void pq_get_single_rows(PGconn* const conn, F&& callback)
+{
+  if (!PQsetSingleRowMode(conn))
+    throw std::runtime_error{"cannot switch to single row mode"};
+  while (Pq_result res{PQgetResult(conn)}) {
+    switch (PQresultStatus(res.get())) {
+    case PGRES_SINGLE_TUPLE:
+      callback(res.get());
       break;
-    case PGRES_SINGLE_TUPLE: {
-      auto r = result(res);
+    case PGRES_TUPLES_OK:
       break;
-    } default:
-      PQclear(res);
-      PQfinish(conn);
-      throw std::runtime_error{PQresultErrorMessage(res)};
+    default:
+      throw std::runtime_error{PQresultErrorMessage(res.get())};
     }
   }
+}
+
+// -----------------------------------------------------------------------------
+// Scenarios
+// -----------------------------------------------------------------------------
+
+volatile std::size_t sink;
+
+/// Appends `count` rows of COPY text format starting from `offset` to `buf`.
+void append_copy_rows(std::string& buf, const unsigned long offset,
+  const unsigned long count)
+{
+  for (auto i = offset; i < offset + count; ++i) {
+    const auto id = std::to_string(i);
+    buf.append(id).append("\trow ").append(id).append("\n");
+  }
+}
+
+constexpr unsigned long copy_chunk_rows{4096};
+
+struct Scenario final {
+  const char* name{};
+  const char* reset{}; // executed before each run and not measured
+  std::function<void(PGconn*, const Options&)> pq;
+  std::function<void(pgfe::Connection&, const Options&)> pgfe;
+};
+
+const char* const wide_query{"select"
+  " i, i + 1, i + 2, i + 3, i + 4, i + 5, i + 6, i + 7,"
+  " 'a' || i, 'b' || i, 'c' || i, 'd' || i,"
+  " 'e' || i, 'f' || i, 'g' || i, 'h' || i"
+  " from generate_series(1, $1::integer) i"};
 
-  PQfinish(conn);
+std::vector<Scenario> scenarios()
+{
+  std::vector<Scenario> result;
+
+  result.push_back({"point_select", nullptr,
+    [](PGconn* const conn, const Options& opts)
+    {
+      for (unsigned long i{}; i < opts.query_count; ++i) {
+        const auto param = std::to_string(i);
+        const char* const values[]{param.c_str()};
+        const auto res = pq_check(conn, Pq_result{PQexecParams(conn,
+          "select $1::integer", 1, nullptr, values, nullptr, nullptr, 0)},
+          PGRES_TUPLES_OK);
+        sink = std::atoi(PQgetvalue(res.get(), 0, 0));
+      }
+    },
+    [](pgfe::Connection& conn, const Options& opts)
+    {
+      const pgfe::Statement statement{"select $1::integer"};
+      for (unsigned long i{}; i < opts.query_count; ++i)
+        conn.execute([](auto&& row)
+        {
+          sink = pgfe::to<int>(row[0]);
+        }, statement, i);
+    }});
+
+  result.push_back({"point_select_prepared", nullptr,
+    [](PGconn* const conn, const Options& opts)
+    {
+      pq_check(conn, Pq_result{PQprepare(conn, "pq_vs_pgfe",
+        "select $1::integer", 1, nullptr)}, PGRES_COMMAND_OK);
+      for (unsigned long i{}; i < opts.query_count; ++i) {
+        const auto param = std::to_string(i);
+        const char* const values[]{param.c_str()};
+        const auto res = pq_check(conn, Pq_result{PQexecPrepared(conn,
+          "pq_vs_pgfe", 1, values, nullptr, nullptr, 0)}, PGRES_TUPLES_OK);
+        sink = std::atoi(PQgetvalue(res.get(), 0, 0));
+      }
+      pq_exec(conn, "deallocate pq_vs_pgfe");
+    },
+    [](pgfe::Connection& conn, const Options& opts)
+    {
+      auto ps = conn.prepare("select $1::integer", "pq_vs_pgfe");
+      for (unsigned long i{}; i < opts.query_count; ++i)
+        ps.execute([](auto&& row)
+        {
+          sink = pgfe::to<int>(row[0]);
+        }, i);
+      conn.unprepare("pq_vs_pgfe");
+    }});
+
+  result.push_back({"series", nullptr,
+    [](PGconn* const conn, const Options& opts)
+    {
+      const auto param = std::to_string(opts.row_count);
+      const char* const values[]{param.c_str()};
+      if (!PQsendQueryParams(conn,
+          "select generate_series(1, $1::integer)",
+          1, nullptr, values, nullptr, nullptr, 0))
+        throw std::runtime_error{PQerrorMessage(conn)};
+      pq_get_single_rows(conn, [](PGresult* const res)
+      {
+        sink = std::atoi(PQgetvalue(res, 0, 0));
+      });
+    },
+    [](pgfe::Connection& conn, const Options& opts)
+    {
+      conn.execute([](auto&& row)
+      {
+        sink = pgfe::to<int>(row[0]);
+      }, "select generate_series(1, $1::integer)", opts.row_count);
+    }});
+
+  result.push_back({"wide_rows", nullptr,
+    [](PGconn* const conn, const Options& opts)
+    {
+      const auto param = std::to_string(opts.row_count);
+      const char* const values[]{param.c_str()};
+      if (!PQsendQueryParams(conn, wide_query,
+          1, nullptr, values, nullptr, nullptr, 0))
+        throw std::runtime_error{PQerrorMessage(conn)};
+      pq_get_single_rows(conn, [](PGresult* const res)
+      {
+        std::size_t size{};
+        for (int i{}, n = PQnfields(res); i < n; ++i)
+          size += PQgetlength(res, 0, i);
+        sink = size;
+      });
+    },
+    [](pgfe::Connection& conn, const Options& opts)
+    {
+      conn.execute([](auto&& row)
+      {
+        std::size_t size{};
+        for (std::size_t i{}, n = row.field_count(); i < n; ++i)
+          size += row[i].size();
+        sink = size;
+      }, wide_query, opts.row_count);
+    }});
+
+  result.push_back({"large_text", nullptr,
+    [](PGconn* const conn, const Options& opts)
+    {
+      const auto param = std::to_string(opts.value_size);
+      const char* const values[]{param.c_str()};
+      const auto res = pq_check(conn, Pq_result{PQexecParams(conn,
+        "select repeat('x', $1::integer)", 1, nullptr, values, nullptr,
+        nullptr, 0)}, PGRES_TUPLES_OK);
+      sink = std::string{PQgetvalue(res.get(), 0, 0),
+        static_cast<std::size_t>(PQgetlength(res.get(), 0, 0))}.size();
+    },
+    [](pgfe::Connection& conn, const Options& opts)
+    {
+      conn.execute([](auto&& row)
+      {
+        sink = pgfe::to<std::string>(row[0]).size();
+      }, "select repeat('x', $1::integer)", opts.value_size);
+    }});
+
+  result.push_back({"large_bytea", nullptr,
+    [](PGconn* const conn, const Options& opts)
+    {
+      const auto param = std::to_string(opts.value_size);
+      const char* const values[]{param.c_str()};
+      const auto res = pq_check(conn, Pq_result{PQexecParams(conn,
+        "select convert_to(repeat('x', $1::integer), 'UTF8')", 1, nullptr,
+        values, nullptr, nullptr, 0)}, PGRES_TUPLES_OK);
+      std::size_t size{};
+      auto* const bytes = PQunescapeBytea(reinterpret_cast<const unsigned char*>(
+        PQgetvalue(res.get(), 0, 0)), &size);
+      if (!bytes)
+        throw std::bad_alloc{};
+      PQfreemem(bytes);
+      sink = size;
+    },
+    [](pgfe::Connection& conn, const Options& opts)
+    {
+      conn.execute([](auto&& row)
+      {
+        sink = row[0].to_bytea()->size();
+      }, "select convert_to(repeat('x', $1::integer), 'UTF8')",
+        opts.value_size);
+    }});
+
+  result.push_back({"array", nullptr,
+    [](PGconn* const conn, const Options& opts)
+    {
+      const auto param = std::to_string(opts.row_count);
+      const char* const values[]{param.c_str()};
+      const auto res = pq_check(conn, Pq_result{PQexecParams(conn,
+        "select array_agg(i) from generate_series(1, $1::integer) i",
+        1, nullptr, values, nullptr, nullptr, 0)}, PGRES_TUPLES_OK);
+      // Parse the literal like {1,2,3} to make the comparison fair.
+      std::vector<int> array;
+      for (char* p = PQgetvalue(res.get(), 0, 0); *p && *p != '}';)
+        array.push_back(static_cast<int>(std::strtol(p + 1, &p, 10)));
+      sink = array.size();
+    },
+    [](pgfe::Connection& conn, const Options& opts)
+    {
+      conn.execute([](auto&& row)
+      {
+        sink = pgfe::to<std::vector<int>>(row[0]).size();
+      }, "select array_agg(i) from generate_series(1, $1::integer) i",
+        opts.row_count);
+    }});
+
+  result.push_back({"insert", "truncate bench_data",
+    [](PGconn* const conn, const Options& opts)
+    {
+      for (unsigned long i{}; i < opts.query_count; ++i) {
+        const auto id = std::to_string(i);
+        const auto str = "row " + id;
+        const char* const values[]{id.c_str(), str.c_str()};
+        pq_check(conn, Pq_result{PQexecParams(conn,
+          "insert into bench_data values ($1, $2)", 2, nullptr, values,
+          nullptr, nullptr, 0)}, PGRES_COMMAND_OK);
+      }
+    },
+    [](pgfe::Connection& conn, const Options& opts)
+    {
+      const pgfe::Statement statement{"insert into bench_data values ($1, $2)"};
+      for (unsigned long i{}; i < opts.query_count; ++i)
+        conn.execute(statement, i, "row " + std::to_string(i));
+    }});
+
+  result.push_back({"pipeline_insert", "truncate bench_data",
+    [](PGconn* const conn, const Options& opts)
+    {
+      if (!PQenterPipelineMode(conn))
+        throw std::runtime_error{PQerrorMessage(conn)};
+      for (unsigned long i{}; i < opts.query_count;) {
+        const auto count = std::min(opts.pipeline_depth, opts.query_count - i);
+        for (const auto end = i + count; i < end; ++i) {
+          const auto id = std::to_string(i);
+          const auto str = "row " + id;
+          const char* const values[]{id.c_str(), str.c_str()};
+          if (!PQsendQueryParams(conn, "insert into bench_data values ($1, $2)",
+              2, nullptr, values, nullptr, nullptr, 0))
+            throw std::runtime_error{PQerrorMessage(conn)};
+        }
+        if (!PQpipelineSync(conn))
+          throw std::runtime_error{PQerrorMessage(conn)};
+        for (unsigned long j{}; j < count; ++j) {
+          pq_check(conn, Pq_result{PQgetResult(conn)}, PGRES_COMMAND_OK);
+          if (PQgetResult(conn))
+            throw std::runtime_error{"unexpected result"};
+        }
+        pq_check(conn, Pq_result{PQgetResult(conn)}, PGRES_PIPELINE_SYNC);
+      }
+      if (!PQexitPipelineMode(conn))
+        throw std::runtime_error{PQerrorMessage(conn)};
+    },
+    [](pgfe::Connection& conn, const Options& opts)
+    {
+      const pgfe::Statement statement{"insert into bench_data values ($1, $2)"};
+      conn.set_pipeline_enabled(true);
+      for (unsigned long i{}; i < opts.query_count;) {
+        const auto count = std::min(opts.pipeline_depth, opts.query_count - i);
+        for (const auto end = i + count; i < end; ++i)
+          conn.execute_nio(statement, i, "row " + std::to_string(i));
+        conn.send_sync();
+        for (unsigned long j{}; j < count; ++j) {
+          conn.wait_response_throw();
+          if (!conn.completion())
+            throw std::runtime_error{"unexpected response"};
+        }
+        conn.wait_response_throw();
+        if (!conn.ready_for_query())
+          throw std::runtime_error{"unexpected response"};
+      }
+      conn.set_pipeline_enabled(false);
+    }});
+
+  result.push_back({"copy_in", "truncate bench_data",
+    [](PGconn* const conn, const Options& opts)
+    {
+      pq_check(conn, Pq_result{PQexec(conn, "copy bench_data from stdin")},
+        PGRES_COPY_IN);
+      std::string buf;
+      for (unsigned long i{}; i < opts.row_count; i += copy_chunk_rows) {
+        buf.clear();
+        append_copy_rows(buf, i, std::min(copy_chunk_rows, opts.row_count - i));
+        if (PQputCopyData(conn, buf.data(), static_cast<int>(buf.size())) != 1)
+          throw std::runtime_error{PQerrorMessage(conn)};
+      }
+      if (PQputCopyEnd(conn, nullptr) != 1)
+        throw std::runtime_error{PQerrorMessage(conn)};
+      pq_check(conn, Pq_result{PQgetResult(conn)}, PGRES_COMMAND_OK);
+      if (PQgetResult(conn))
+        throw std::runtime_error{"unexpected result"};
+    },
+    [](pgfe::Connection& conn, const Options& opts)
+    {
+      conn.execute("copy bench_data from stdin");
+      auto copier = conn.copier();
+      std::string buf;
+      for (unsigned long i{}; i < opts.row_count; i += copy_chunk_rows) {
+        buf.clear();
+        append_copy_rows(buf, i, std::min(copy_chunk_rows, opts.row_count - i));
+        copier.send(buf);
+      }
+      copier.end();
+      conn.wait_response_throw();
+      if (!conn.completion())
+        throw std::runtime_error{"unexpected response"};
+    }});
+
+  result.push_back({"copy_out", nullptr,
+    [](PGconn* const conn, const Options& opts)
+    {
+      const auto query = "copy (select i, 'row ' || i from generate_series(1, "
+        + std::to_string(opts.row_count) + ") i) to stdout";
+      pq_check(conn, Pq_result{PQexec(conn, query.c_str())}, PGRES_COPY_OUT);
+      char* buf{};
+      std::size_t size{};
+      int len{};
+      while ((len = PQgetCopyData(conn, &buf, 0)) > 0) {
+        size += len;
+        PQfreemem(buf);
+      }
+      if (len != -1)
+        throw std::runtime_error{PQerrorMessage(conn)};
+      pq_check(conn, Pq_result{PQgetResult(conn)}, PGRES_COMMAND_OK);
+      if (PQgetResult(conn))
+        throw std::runtime_error{"unexpected result"};
+      sink = size;
+    },
+    [](pgfe::Connection& conn, const Options& opts)
+    {
+      conn.execute("copy (select i, 'row ' || i from generate_series(1, "
+        + std::to_string(opts.row_count) + ") i) to stdout");
+      auto copier = conn.copier();
+      std::size_t size{};
+      while (const auto data = copier.receive())
+        size += data.size();
+      conn.wait_response_throw();
+      if (!conn.completion())
+        throw std::runtime_error{"unexpected response"};
+      sink = size;
+    }});
+
+  return result;
+}
+
+// -----------------------------------------------------------------------------
+// Measurement
+// -----------------------------------------------------------------------------
+
+struct Stats final {
+  std::vector<double> samples; // in milliseconds, sorted
+  double min{};
+  double median{};
+  double p99{};
+};
+
+/// @returns The `p`-th percentile of `sorted` by the nearest-rank method.
+double percentile(const std::vector<double>& sorted, const double p)
+{
+  const auto rank = static_cast<std::size_t>(std::ceil(p * sorted.size()));
+  return sorted[std::max<std::size_t>(rank, 1) - 1];
 }
 
-void test_pgfe()
+Stats make_stats(std::vector<double> samples)
 {
-  namespace pgfe = dmitigr::pgfe;
-  pgfe::Connection conn{pgfe::Connection_options{}
-    .set(pgfe::Communication_mode::net)
-    .set_address("127.0.0.1")
-    .set_username("pgfe_test")
-    .set_password("pgfe_test")
-    .set_database("pgfe_test")
-    .set_connect_timeout(std::chrono::seconds{7})};
-  conn.connect();
-  conn.execute([](auto&& r) { auto d = r.data(); }, query);
+  std::sort(samples.begin(), samples.end());
+  Stats result;
+  result.min = samples.front();
+  result.median = samples.size() % 2 ? samples[samples.size() / 2] :
+    (samples[samples.size() / 2 - 1] + samples[samples.size() / 2]) / 2;
+  result.p99 = percentile(samples, .99);
+  result.samples = std::move(samples);
+  return result;
 }
 
-int main()
+template<typename F>
+double measure(F&& f)
 {
-  using dmitigr::util::with_measure;
-  std::cout << "Pq: ";
-  const auto elapsed_pq = with_measure(test_pq);
-  std::cout << elapsed_pq.count() << std::endl;
-  std::cout << "Pgfe: ";
-  const auto elapsed_pgfe = with_measure(test_pgfe);
-  std::cout << elapsed_pgfe.count() << std::endl;
+  using Clock = std::chrono::steady_clock;
+  const auto started = Clock::now();
+  f();
+  return std::chrono::duration<double, std::milli>{Clock::now() - started}
+    .count();
+}
+
+void print_json(std::ostream& out, const Stats& stats)
+{
+  out << "{\"min_ms\":" << stats.min
+      << ",\"median_ms\":" << stats.median
+      << ",\"p99_ms\":" << stats.p99
+      << ",\"samples_ms\":[";
+  for (std::size_t i{}; i < stats.samples.size(); ++i)
+    out << (i ? "," : "") << stats.samples[i];
+  out << "]}";
+}
+
+} // namespace
+
+int main(const int argc, char* const argv[])
+try {
+  const auto opts = parse_options(argc, argv);
+
+  auto pq = pq_connect();
+  auto conn = pgfe::test::make_connection();
+  conn->connect();
+  const char* const create_table{"create temp table bench_data"
+    "(id integer not null, str text not null)"};
+  pq_exec(pq.get(), create_table);
+  conn->execute(create_table);
+
+  auto all = scenarios();
+  for (const auto& name : opts.scenarios) {
+    if (std::none_of(all.begin(), all.end(),
+        [&name](const auto& s){return s.name == name;}))
+      throw std::runtime_error{"unknown scenario " + name};
+  }
+
+  if (opts.is_json)
+    std::cout << std::setprecision(6) << "{\"rows\":" << opts.row_count
+              << ",\"queries\":" << opts.query_count
+              << ",\"size\":" << opts.value_size
+              << ",\"depth\":" << opts.pipeline_depth
+              << ",\"warmup\":" << opts.warmup_count
+              << ",\"repeat\":" << opts.repeat_count
+              << ",\"results\":[";
+  else
+    std::cout << std::fixed << std::setprecision(3)
+              << std::left << std::setw(24) << "scenario"
+              << std::right << std::setw(12) << "pq median"
+              << std::setw(12) << "pq p99"
+              << std::setw(12) << "pgfe median"
+              << std::setw(12) << "pgfe p99"
+              << std::setw(10) << "ratio" << " (ms)" << std::endl;
+
+  bool is_first{true};
+  for (const auto& scenario : all) {
+    if (!opts.scenarios.empty() && std::find(opts.scenarios.begin(),
+        opts.scenarios.end(), scenario.name) == opts.scenarios.end())
+      continue;
+
+    const auto run_pq = [&]
+    {
+      if (scenario.reset)
+        pq_exec(pq.get(), scenario.reset);
+      return measure([&]{scenario.pq(pq.get(), opts);});
+    };
+    const auto run_pgfe = [&]
+    {
+      if (scenario.reset)
+        conn->execute(scenario.reset);
+      return measure([&]{scenario.pgfe(*conn, opts);});
+    };
+
+    for (unsigned long i{}; i < opts.warmup_count; ++i) {
+      run_pq();
+      run_pgfe();
+    }
+
+    // Alternate the clients to spread out the drift of the environment.
+    std::vector<double> pq_samples;
+    std::vector<double> pgfe_samples;
+    for (unsigned long i{}; i < opts.repeat_count; ++i) {
+      pq_samples.push_back(run_pq());
+      pgfe_samples.push_back(run_pgfe());
+    }
+    const auto pq_stats = make_stats(std::move(pq_samples));
+    const auto pgfe_stats = make_stats(std::move(pgfe_samples));
+    const auto ratio = pq_stats.median > 0 ?
+      pgfe_stats.median / pq_stats.median : 0;
+
+    if (opts.is_json) {
+      std::cout << (is_first ? "" : ",")
+                << "{\"scenario\":\"" << scenario.name << "\",\"pq\":";
+      print_json(std::cout, pq_stats);
+      std::cout << ",\"pgfe\":";
+      print_json(std::cout, pgfe_stats);
+      std::cout << ",\"ratio\":" << ratio << "}";
+    } else
+      std::cout << std::left << std::setw(24) << scenario.name
+                << std::right << std::setw(12) << pq_stats.median
+                << std::setw(12) << pq_stats.p99
+                << std::setw(12) << pgfe_stats.median
+                << std::setw(12) << pgfe_stats.p99
+                << std::setw(10) << ratio << std::endl;
+    is_first = false;
+  }
+
+  if (opts.is_json)
+    std::cout << "]}" << std::endl;
+} catch (const std::exception& e) {
+  std::cerr << e.what() << std::endl;
+  return 1;
+} catch (...) {
+  std::cerr << "unknown error" << std::endl;
+  return 2;
 }
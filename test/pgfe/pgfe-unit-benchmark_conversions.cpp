@@ -0,0 +1,185 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+// Usage: dmitigr_pgfe-unit-benchmark_conversions [--hw-counters]
+
+#include "pgfe-unit.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pgfe = dmitigr::pgfe;
+namespace util = dmitigr::util;
+using util::benchmark;
+using util::do_not_optimize;
+
+namespace {
+
+util::Benchmark_options opts;
+
+void print(const util::Benchmark_result& r, const std::size_t byte_count)
+{
+  DMITIGR_ASSERT(r.iteration_count > 0 && !r.samples.empty());
+  std::cout << r;
+  if (byte_count >= 1024)
+    std::cout << ", " << byte_count / r.median() * 1e9 / 1048576 << " MiB/s";
+  std::cout << std::endl;
+}
+
+/// Measures the text encoding of `value` and the text decoding of it.
+template<typename T>
+void text(const std::string& name, const T& value)
+{
+  const auto data = pgfe::to_data(value);
+  DMITIGR_ASSERT(data && data->format() == pgfe::Data_format::text);
+  DMITIGR_ASSERT(pgfe::to<T>(*data) == value);
+  print(benchmark(name + " text encode", [&]
+  {
+    const auto d = pgfe::to_data(value);
+    do_not_optimize(d);
+  }, opts), data->size());
+  print(benchmark(name + " text decode", [&]
+  {
+    const auto v = pgfe::to<T>(*data);
+    do_not_optimize(v);
+  }, opts), data->size());
+}
+
+/// Measures the binary decoding of `value` in network byte order.
+template<typename T>
+void binary(const std::string& name, const T value)
+{
+  std::string bytes(sizeof(T), '\0');
+  dmitigr::net::copy(bytes.data(), bytes.size(), value);
+  const auto data = pgfe::Data::make(std::move(bytes), pgfe::Data_format::binary);
+  DMITIGR_ASSERT(pgfe::to<T>(*data) == value);
+  print(benchmark(name + " binary decode", [&]
+  {
+    const auto v = pgfe::to<T>(*data);
+    do_not_optimize(v);
+  }, opts), data->size());
+}
+
+template<typename T>
+void numeric(const std::string& name, const T value)
+{
+  text(name, value);
+  binary(name, value);
+}
+
+/// @returns The array of `size` integers.
+pgfe::Array_optional1<int> ints(const std::size_t size)
+{
+  pgfe::Array_optional1<int> result(size);
+  for (std::size_t i{}; i < size; ++i)
+    result[i] = static_cast<int>(i * 7919);
+  return result;
+}
+
+/// Measures Data::to_bytea() for the `text` of the given escape format.
+void bytea(const std::string& name, const std::string& text)
+{
+  const auto data = pgfe::Data::make(text);
+  print(benchmark(name, [&]
+  {
+    const auto d = data->to_bytea();
+    do_not_optimize(d);
+  }, opts), text.size());
+}
+
+} // namespace
+
+int main(const int argc, char* const argv[])
+try {
+  opts.is_hardware_counters_enabled = argc > 1 &&
+    std::string_view{argv[1]} == "--hw-counters";
+
+  // Numerics
+  numeric<short>("short", std::numeric_limits<short>::min());
+  numeric<int>("int", std::numeric_limits<int>::min());
+  numeric<long>("long", std::numeric_limits<long>::min());
+  numeric<long long>("long long", std::numeric_limits<long long>::min());
+  numeric<float>("float", 3.1415927f);
+  numeric<double>("double", 3.141592653589793);
+  text<long double>("long double", 3.25l);
+
+  // Characters and booleans
+  numeric<char>("char", 'x');
+  numeric<bool>("bool", true);
+
+  // Generic (stream-based) conversions
+  text<unsigned>("unsigned (generic)", std::numeric_limits<unsigned>::max());
+
+  // Strings
+  for (const std::size_t size : {16, 1024, 65536}) {
+    const std::string str(size, 'x');
+    const auto suffix = " " + std::to_string(size) + " B";
+    text<std::string>("std::string" + suffix, str);
+    text<std::string_view>("std::string_view" + suffix, str);
+  }
+
+  // Arrays of various nesting depths with the same number of elements
+  {
+    using A2 = pgfe::Array_optional2<int>;
+    using A3 = pgfe::Array_optional3<int>;
+    const auto a1 = ints(4096);
+    const A2 a2(64, ints(64));
+    const A3 a3(16, A2(16, ints(16)));
+    text("array<int> depth 1", a1);
+    text("array<int> depth 2", a2);
+    text("array<int> depth 3", a3);
+
+    auto nulls = a1;
+    for (std::size_t i{}; i < nulls.size(); i += 2)
+      nulls[i] = std::nullopt;
+    text("array<int> with NULLs depth 1", nulls);
+
+    const auto data = pgfe::to_data(a1);
+    print(benchmark("array<int> depth 1 text decode to values", [&]
+    {
+      const auto v = pgfe::to<std::vector<int>>(*data);
+      do_not_optimize(v);
+    }, opts), data->size());
+
+    const pgfe::Array_optional1<std::string>
+      strs(1024, "quoted \"value\", with {braces}");
+    text("array<string> depth 1", strs);
+  }
+
+  // Bytea
+  for (const std::size_t size : {16, 1024, 65536, 1048576}) {
+    const auto suffix = " " + std::to_string(size) + " B";
+    std::string hex{"\\x"};
+    std::string escape;
+    for (std::size_t i{}; i < size; ++i) {
+      hex.append("7f");
+      escape.append(i % 2 ? "a" : "\\001");
+    }
+    bytea("bytea hex decode" + suffix, hex);
+    bytea("bytea escape decode" + suffix, escape);
+  }
+} catch (const std::exception& e) {
+  std::cerr << e.what() << std::endl;
+  return 1;
+} catch (...) {
+  std::cerr << "unknown error" << std::endl;
+  return 2;
+}
@@ -0,0 +1,141 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+// Usage: dmitigr_pgfe-unit-benchmark_hot_paths [--hw-counters]
+
+#include "pgfe-unit.hpp"
+
+#include <string>
+#include <string_view>
+
+int main(const int argc, char* const argv[])
+try {
+  namespace pgfe = dmitigr::pgfe;
+  namespace util = dmitigr::util;
+  using util::benchmark;
+  using util::do_not_optimize;
+
+  util::Benchmark_options opts;
+  opts.is_hardware_counters_enabled = argc > 1 &&
+    std::string_view{argv[1]} == "--hw-counters";
+  const auto print = [](const util::Benchmark_result& r)
+  {
+    DMITIGR_ASSERT(r.iteration_count > 0 && !r.samples.empty());
+    std::cout << r << std::endl;
+  };
+
+  // Statement
+  {
+    const std::string query{"SELECT :list FROM t WHERE a = :a AND b = $1"
+      " -- comment\n AND c IN (:{c}) AND d = $$dollar$$ AND e = 'quoted'"};
+    print(benchmark("Statement parse", [&]
+    {
+      pgfe::Statement s{query};
+      do_not_optimize(s);
+    }, opts));
+
+    const pgfe::Statement statement{query};
+    print(benchmark("Statement copy", [&]
+    {
+      auto s = statement;
+      do_not_optimize(s);
+    }, opts));
+
+    print(benchmark("Statement to_string", [&]
+    {
+      const auto s = statement.to_string();
+      do_not_optimize(s);
+    }, opts));
+
+    print(benchmark("Statement bind", [&]
+    {
+      auto s = statement;
+      s.bind("list", "id, name").bind("a", "1");
+      do_not_optimize(s);
+    }, opts));
+  }
+
+  // Conversions
+  {
+    const auto data = pgfe::Data::make("-1234567890");
+    print(benchmark("Conversions to<int>", [&]
+    {
+      const auto value = pgfe::to<int>(*data);
+      do_not_optimize(value);
+    }, opts));
+
+    print(benchmark("Conversions to_data(int)", [&]
+    {
+      const auto d = pgfe::to_data(-1234567890);
+      do_not_optimize(d);
+    }, opts));
+
+    const auto str = pgfe::Data::make("The quick brown fox jumps over the dog");
+    print(benchmark("Conversions to<std::string>", [&]
+    {
+      const auto value = pgfe::to<std::string>(*str);
+      do_not_optimize(value);
+    }, opts));
+
+    const auto arr = pgfe::Data::make("{1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16}");
+    print(benchmark("Conversions to<std::vector<int>>", [&]
+    {
+      const auto value = pgfe::to<std::vector<int>>(*arr);
+      do_not_optimize(value);
+    }, opts));
+  }
+
+  // Data
+  {
+    const std::string bytes(1024, 'x');
+    print(benchmark("Data make 1 KiB", [&]
+    {
+      const auto d = pgfe::Data::make(bytes);
+      do_not_optimize(d);
+    }, opts));
+
+    const pgfe::Data_view view{bytes.data(), bytes.size()};
+    print(benchmark("Data_view to_data 1 KiB", [&]
+    {
+      const auto d = view.to_data();
+      do_not_optimize(d);
+    }, opts));
+
+    std::string hex{"\\x"};
+    for (std::size_t i{}; i < 1024; ++i)
+      hex.append("78");
+    const auto bytea = pgfe::Data::make(hex);
+    print(benchmark("Data to_bytea 1 KiB", [&]
+    {
+      const auto d = bytea->to_bytea();
+      do_not_optimize(d);
+    }, opts));
+
+    const auto other = pgfe::Data::make(bytes);
+    print(benchmark("Data compare 1 KiB", [&]
+    {
+      const bool result = *other == view;
+      do_not_optimize(result);
+    }, opts));
+  }
+} catch (const std::exception& e) {
+  std::cerr << e.what() << std::endl;
+  return 1;
+} catch (...) {
+  std::cerr << "unknown error" << std::endl;
+  return 2;
+}
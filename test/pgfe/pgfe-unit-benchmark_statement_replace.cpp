@@ -16,21 +16,78 @@
 
 #include "../../src/pgfe/statement.hpp"
 
+#include <chrono>
 #include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace pgfe = dmitigr::pgfe;
+
+namespace {
+
+template<typename F>
+void measure(const char* const what, const unsigned long count, F&& f)
+{
+  using Clock = std::chrono::steady_clock;
+  const auto started = Clock::now();
+  f();
+  const std::chrono::duration<double> elapsed{Clock::now() - started};
+  std::cout << what << ": " << count << " in " << elapsed.count() << " s";
+  if (elapsed.count() > 0)
+    std::cout << " (" << static_cast<unsigned long>(count / elapsed.count())
+              << " per second)";
+  std::cout << std::endl;
+}
+
+} // namespace
 
 int main(const int argc, char* const argv[])
 try {
-  namespace pgfe = dmitigr::pgfe;
-  pgfe::Statement s;
   const unsigned long iteration_count{(argc >= 2) ? std::stoul(argv[1]) : 1};
+  const unsigned long substitution_count{(argc >= 3) ? std::stoul(argv[2]) : 500};
+
+  // Template instantiation.
+  measure("template replacements", iteration_count * 4, [&]
+  {
+    pgfe::Statement s;
+    for (unsigned long i{}; i < iteration_count; ++i) {
+      s = "SELECT :list_ FROM :t1_ t1 JOIN :t2_ t2 ON (t1.t2 = t2.id) WHERE :where_";
+      s.replace_parameter("list_", "t1.id id, t1.age age, t2.dat dat");
+      s.replace_parameter("t1_", "table1");
+      s.replace_parameter("t2_", "table2");
+      s.replace_parameter("where_", "t1.nm = :nm AND t2.age = :age");
+    }
+    const auto modified_string = s.to_string();
+  });
+
+  // Dynamic filter building.
+  const pgfe::Statement condition{"c = :p AND :filter"};
   for (unsigned long i{}; i < iteration_count; ++i) {
-    s = "SELECT :list_ FROM :t1_ t1 JOIN :t2_ t2 ON (t1.t2 = t2.id) WHERE :where_";
-    s.replace_parameter("list_", "t1.id id, t1.age age, t2.dat dat");
-    s.replace_parameter("t1_", "table1");
-    s.replace_parameter("t2_", "table2");
-    s.replace_parameter("where_", "t1.nm = :nm AND t2.age = :age");
+    pgfe::Statement s{"SELECT * FROM t WHERE :filter"};
+    measure("filter substitutions", substitution_count, [&]
+    {
+      for (unsigned long j{}; j < substitution_count; ++j) {
+        auto cond = condition;
+        cond.replace_parameter("p", pgfe::Statement{":p" + std::to_string(j)});
+        s.replace_parameter("filter", cond);
+      }
+      s.replace_parameter("filter", "true");
+    });
+    if (s.named_parameter_count() != substitution_count)
+      throw std::runtime_error{"unexpected parameter count"};
   }
-  const auto modified_string = s.to_string();
+
+  // Appending.
+  measure("appends", iteration_count * substitution_count, [&]
+  {
+    const pgfe::Statement appendix{" UNION ALL SELECT :v"};
+    for (unsigned long i{}; i < iteration_count; ++i) {
+      pgfe::Statement s{"SELECT :v"};
+      for (unsigned long j{}; j < substitution_count; ++j)
+        s.append(appendix);
+      const auto modified_string = s.to_string();
+    }
+  });
 } catch (const std::exception& e) {
   std::cerr << e.what() << std::endl;
   return 1;
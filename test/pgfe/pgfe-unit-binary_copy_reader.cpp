@@ -0,0 +1,115 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pgfe-unit.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#define ASSERT DMITIGR_ASSERT
+
+int main()
+try {
+  namespace pgfe = dmitigr::pgfe;
+  using pgfe::to;
+
+  // Prepare.
+  auto conn = pgfe::test::make_connection();
+  conn->connect();
+  conn->execute("create temp table item(id integer not null, name text,"
+    " price float8, big bigint, ok boolean, small smallint)");
+  conn->execute("insert into item select i, 'item ' || i, i + .5,"
+    " case when i % 2 = 0 then i * 10 end, i % 2 = 0, -i"
+    " from generate_series(1, 1000) i");
+
+  // Test read.
+  conn->execute("copy (select * from item order by id) to stdout"
+    " (format binary)");
+  {
+    auto copier = conn->copier();
+    ASSERT(copier);
+    ASSERT(copier.data_format(0) == pgfe::Data_format::binary);
+    pgfe::Binary_copy_reader reader{copier};
+    ASSERT(!reader.field_count());
+    std::int32_t i{};
+    while (reader.read()) {
+      ++i;
+      ASSERT(reader.field_count() == 6);
+      ASSERT(reader.field(0).format() == pgfe::Data_format::binary);
+      ASSERT(to<std::int32_t>(reader.field(0)) == i);
+      ASSERT(to<std::string_view>(reader.field(1)) == "item " + std::to_string(i));
+      ASSERT(to<double>(reader.field(2)) == i + .5);
+      if (i % 2 == 0) {
+        ASSERT(to<std::int64_t>(reader.field(3)) == i * 10);
+        ASSERT(to<bool>(reader.field(4)));
+      } else {
+        ASSERT(!reader.field(3));
+        ASSERT(!to<bool>(reader.field(4)));
+      }
+      const auto [id, name, price, big, ok, small] = reader.to_tuple<
+        std::int32_t, std::string, double, std::optional<std::int64_t>,
+        bool, std::int16_t>();
+      ASSERT(id == i);
+      ASSERT(name == "item " + std::to_string(i));
+      ASSERT(price == i + .5);
+      ASSERT(big.has_value() == (i % 2 == 0));
+      ASSERT(ok == (i % 2 == 0));
+      ASSERT(small == -i);
+    }
+    ASSERT(i == 1000);
+    ASSERT(reader.tuple_count() == 1000);
+    ASSERT(!reader.field_count());
+    ASSERT(!reader.read());
+  }
+  conn->wait_response_throw();
+  ASSERT(conn->completion().row_count() == 1000);
+  ASSERT(conn->is_ready_for_request());
+
+  // Test empty result.
+  conn->execute("copy (select * from item where false) to stdout"
+    " (format binary)");
+  {
+    auto copier = conn->copier();
+    pgfe::Binary_copy_reader reader{copier};
+    ASSERT(!reader.read());
+    ASSERT(!reader.tuple_count());
+  }
+  conn->wait_response_throw();
+  ASSERT(conn->completion().row_count() == 0);
+
+  // Test text format is rejected.
+  conn->execute("copy item to stdout");
+  {
+    auto copier = conn->copier();
+    bool is_thrown{};
+    try {
+      pgfe::Binary_copy_reader reader{copier};
+    } catch (const pgfe::Client_exception&) {
+      is_thrown = true;
+    }
+    ASSERT(is_thrown);
+    while (copier.receive());
+  }
+  conn->wait_response_throw();
+} catch (const std::exception& e) {
+  std::cerr << e.what() << std::endl;
+  return 1;
+} catch (...) {
+  std::cerr << "unknown error" << std::endl;
+  return 2;
+}
@@ -0,0 +1,129 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pgfe-unit.hpp"
+
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#define ASSERT DMITIGR_ASSERT
+
+int main()
+try {
+  namespace pgfe = dmitigr::pgfe;
+  using pgfe::to;
+
+  struct Item final {
+    int id;
+    std::string name;
+    double price;
+  };
+
+  // Prepare.
+  auto conn = pgfe::test::make_connection();
+  conn->connect();
+  conn->execute("create temp table item(id integer not null, name text,"
+    " price float8, big bigint, ok boolean)");
+
+  // Test write.
+  conn->execute("copy item from stdin (format binary)");
+  {
+    auto copier = conn->copier();
+    ASSERT(copier);
+    ASSERT(copier.data_format(0) == pgfe::Data_format::binary);
+    pgfe::Binary_copy_writer writer{copier, 16};
+    writer.write(1, "one", 1.5, 10LL, true);
+    writer.write(std::make_tuple(2, std::string{"two"}, 2.5,
+        std::optional<long long>{}, false));
+    const Item item{3, "three", 3.5};
+    writer.write(std::tie(item.id, item.name, item.price), std::nullopt,
+      std::optional<bool>{true});
+    writer.write_columns(std::vector<int>{4, 5},
+      std::vector<std::string_view>{"four", "five"},
+      std::vector<double>{4.5, 5.5},
+      std::vector<long long>{40, 50},
+      std::vector<bool>{true, false});
+    writer.finish();
+    ASSERT(!copier);
+  }
+  conn->wait_response_throw();
+  ASSERT(conn->completion().row_count() == 5);
+
+  // Test read back.
+  int count{};
+  conn->execute([&count](auto&& row)
+  {
+    const auto id = to<int>(row["id"]);
+    ASSERT(id == ++count);
+    ASSERT(to<double>(row["price"]) == id + .5);
+  }, "select * from item order by id");
+  ASSERT(count == 5);
+  conn->execute([](auto&& row)
+  {
+    ASSERT(to<std::string_view>(row["name"]) == "three");
+    ASSERT(!row["big"]);
+    ASSERT(to<bool>(row["ok"]));
+  }, "select * from item where id = 3");
+
+  // Test that the tuple which cannot be encoded is not written.
+  conn->execute("copy item from stdin (format binary)");
+  {
+    auto copier = conn->copier();
+    pgfe::Binary_copy_writer writer{copier};
+    const auto size = writer.buffered_size();
+    const pgfe::Data_view too_large{"", std::size_t{1} << 31};
+    try {
+      writer.write(6, too_large, 6.5, 60LL, true);
+      ASSERT(false);
+    } catch (const pgfe::Client_exception&) {}
+    ASSERT(writer.buffered_size() == size);
+    const std::vector<pgfe::Data_view> range(5, too_large);
+    try {
+      writer.write_range(range);
+      ASSERT(false);
+    } catch (const pgfe::Client_exception&) {}
+    ASSERT(writer.buffered_size() == size);
+    writer.write(6, "six", 6.5, 60LL, true);
+    writer.finish();
+  }
+  conn->wait_response_throw();
+  ASSERT(conn->completion().row_count() == 1);
+  conn->execute("delete from item where id = 6");
+
+  // Test abort.
+  conn->execute("copy item from stdin (format binary)");
+  {
+    auto copier = conn->copier();
+    pgfe::Binary_copy_writer writer{copier};
+    writer.write(6, "six", 6.5, 60LL, true);
+    writer.abort("test");
+    ASSERT(!copier);
+  }
+  try {
+    conn->wait_response_throw();
+    ASSERT(false);
+  } catch (const pgfe::Server_exception& e) {
+    ASSERT(e.error().condition() == pgfe::Server_errc::c57_query_canceled);
+  }
+} catch (const std::exception& e) {
+  std::cerr << e.what() << std::endl;
+  return 1;
+} catch (...) {
+  std::cerr << "unknown error" << std::endl;
+  return 2;
+}
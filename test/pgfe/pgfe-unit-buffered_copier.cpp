@@ -0,0 +1,81 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pgfe-unit.hpp"
+
+#include <string>
+
+#define ASSERT DMITIGR_ASSERT
+
+int main()
+try {
+  namespace pgfe = dmitigr::pgfe;
+
+  // Prepare.
+  auto conn = pgfe::test::make_connection();
+  conn->connect();
+  conn->execute("create temp table num(id integer not null, str text)");
+
+  for (const bool is_nio : {false, true}) {
+    conn->execute("truncate num");
+    conn->execute("copy num from stdin");
+    if (is_nio)
+      conn->set_nio_output_enabled(true);
+    {
+      auto copier = conn->copier();
+      pgfe::Buffered_copier stream{copier, 4096};
+      ASSERT(stream.buffer_size() == 4096);
+      constexpr int row_count{100000};
+      std::string row;
+      for (int i{}; i < row_count; ++i) {
+        row.assign(std::to_string(i)).append("\tvalue\n");
+        stream.append(row);
+        ASSERT(stream.buffered_size() < stream.buffer_size());
+      }
+      // Appending data which is larger than the buffer.
+      stream.append(std::string(8192, 'x').insert(0, "-1\t").append("\n"));
+      stream.finish();
+      ASSERT(!copier);
+      ASSERT(stream.sent_size() > 8192);
+    }
+    if (is_nio)
+      conn->set_nio_output_enabled(false);
+    conn->wait_response_throw();
+    ASSERT(conn->completion().row_count() == 100001);
+  }
+
+  // Test abort.
+  conn->execute("copy num from stdin");
+  {
+    auto copier = conn->copier();
+    pgfe::Buffered_copier stream{copier};
+    stream.append("1\tone\n");
+    stream.abort("test");
+    ASSERT(!copier);
+  }
+  try {
+    conn->wait_response_throw();
+    ASSERT(false);
+  } catch (const pgfe::Server_exception& e) {
+    ASSERT(e.error().condition() == pgfe::Server_errc::c57_query_canceled);
+  }
+} catch (const std::exception& e) {
+  std::cerr << e.what() << std::endl;
+  return 1;
+} catch (...) {
+  std::cerr << "unknown error" << std::endl;
+  return 2;
+}
@@ -425,6 +425,41 @@ try {
         DMITIGR_ASSERT(conn->is_ready_for_request());
       }
 
+      // Execute simple queries
+      {
+        int sum{};
+        const auto comps = conn->execute_simple([&sum](auto&& row)
+        {
+          sum += to<int>(row[0]);
+        }, "SELECT generate_series(1,3); SET application_name = 'pgfe';"
+           "SELECT 10");
+        DMITIGR_ASSERT(comps.size() == 3);
+        DMITIGR_ASSERT(comps[0].tag() == "SELECT");
+        DMITIGR_ASSERT(comps[1].tag() == "SET");
+        DMITIGR_ASSERT(comps[2].tag() == "SELECT");
+        DMITIGR_ASSERT(sum == 16);
+        DMITIGR_ASSERT(conn->is_ready_for_request());
+
+        bool is_thrown{};
+        try {
+          conn->execute_simple("SELECT 1; SELECT 1/0; SELECT 3");
+        } catch (const pgfe::Server_exception& e) {
+          is_thrown = true;
+          DMITIGR_ASSERT(e.error().condition() ==
+            pgfe::Server_errc::c22_division_by_zero);
+        }
+        DMITIGR_ASSERT(is_thrown);
+        DMITIGR_ASSERT(conn->is_ready_for_request());
+
+        // Parameterless statements can be executed via simple query protocol.
+        DMITIGR_ASSERT(!conn->is_simple_query_protocol_enabled());
+        conn->set_simple_query_protocol_enabled(true);
+        const auto comp = conn->execute("BEGIN");
+        DMITIGR_ASSERT(comp.tag() == "BEGIN");
+        DMITIGR_ASSERT(conn->execute("COMMIT").tag() == "COMMIT");
+        conn->set_simple_query_protocol_enabled(false);
+      }
+
       // TODO: Execute with exception and server exception upon completion
 
       // invoke 1
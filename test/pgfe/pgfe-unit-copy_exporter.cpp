@@ -0,0 +1,120 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pgfe-unit.hpp"
+
+#include <cstdio>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#define ASSERT DMITIGR_ASSERT
+
+int main()
+try {
+  namespace pgfe = dmitigr::pgfe;
+
+  // Prepare.
+  auto conn = pgfe::test::make_connection();
+  conn->connect();
+  conn->execute("create temp table num(id integer not null, str text)");
+  conn->execute("insert into num select i, 'row ' || i"
+    " from generate_series(1, 10000) i");
+  std::string expected;
+  for (int i{1}; i <= 10000; ++i)
+    expected.append(std::to_string(i)).append(",row ")
+      .append(std::to_string(i)).append("\n");
+
+  const auto export_to = [&conn](const bool is_threaded, auto&& sink)
+  {
+    conn->execute("copy (select * from num order by id) to stdout"
+      " (format csv)");
+    auto copier = conn->copier();
+    ASSERT(copier);
+    pgfe::Copy_exporter exporter{copier, 4096};
+    ASSERT(exporter.batch_size() == 4096);
+    exporter.set_writer_thread_enabled(is_threaded).set_queue_capacity(2);
+    ASSERT(exporter.is_writer_thread_enabled() == is_threaded);
+    ASSERT(exporter.queue_capacity() == 2);
+    exporter.copy_to(sink);
+    ASSERT(exporter.row_count() == 10000);
+    conn->wait_response_throw();
+    ASSERT(conn->completion().row_count() == 10000);
+    ASSERT(conn->is_ready_for_request());
+    return exporter.byte_count();
+  };
+
+  for (const bool is_threaded : {false, true}) {
+    // Test stream sink.
+    {
+      std::ostringstream stream;
+      ASSERT(export_to(is_threaded, stream) == expected.size());
+      ASSERT(stream.str() == expected);
+    }
+
+    // Test callback sink.
+    {
+      std::string result;
+      std::size_t batch_count{};
+      const pgfe::Copy_exporter::Sink sink{[&](const std::string_view batch)
+      {
+        ASSERT(batch.size() >= 4096 || result.size() + batch.size() ==
+          expected.size());
+        result.append(batch);
+        ++batch_count;
+      }};
+      export_to(is_threaded, sink);
+      ASSERT(result == expected);
+      ASSERT(batch_count > 1 && batch_count < 10000);
+    }
+
+#ifndef _WIN32
+    // Test file descriptor sink.
+    {
+      std::FILE* const file = std::tmpfile();
+      ASSERT(file);
+      export_to(is_threaded, fileno(file));
+      std::rewind(file);
+      std::string result(expected.size() + 1, '\0');
+      result.resize(std::fread(result.data(), 1, result.size(), file));
+      std::fclose(file);
+      ASSERT(result == expected);
+    }
+#endif
+
+    // Test failed sink.
+    {
+      bool is_thrown{};
+      try {
+        export_to(is_threaded, pgfe::Copy_exporter::Sink{[](std::string_view)
+        {
+          throw std::runtime_error{"sink failed"};
+        }});
+      } catch (const std::runtime_error& e) {
+        is_thrown = std::string_view{e.what()} == "sink failed";
+      }
+      ASSERT(is_thrown);
+      conn->wait_response_throw();
+      ASSERT(conn->is_ready_for_request());
+    }
+  }
+} catch (const std::exception& e) {
+  std::cerr << e.what() << std::endl;
+  return 1;
+} catch (...) {
+  std::cerr << "unknown error" << std::endl;
+  return 2;
+}
@@ -0,0 +1,426 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+// Tests and benchmarks the client side against the in-process fake server.
+// Requires no PostgreSQL server.
+
+#include "pgfe-unit-fake_server.hpp"
+
+#define ASSERT DMITIGR_ASSERT
+
+int main()
+try {
+  namespace pgfe = dmitigr::pgfe;
+  namespace util = dmitigr::util;
+  using pgfe::Row;
+  using pgfe::Server_errc;
+  using pgfe::Transaction_status;
+  using pgfe::to;
+  using pgfe::test::Fake_response;
+  using Params = pgfe::test::Fake_server::Params;
+
+  // The command (prefix) to fail once.
+  std::mutex failing_mutex;
+  std::string failing_command;
+
+  pgfe::test::Fake_server server{[&](const std::string_view query,
+    const Params& params) -> std::optional<Fake_response>
+  {
+    if (query == "select $1")
+      return Fake_response::select({"v"}, {{params[0]}});
+
+    const std::lock_guard lg{failing_mutex};
+    if (!failing_command.empty() && query.rfind(failing_command, 0) == 0) {
+      failing_command.clear();
+      return Fake_response::error("40001", "could not serialize access");
+    }
+    return std::nullopt;
+  }};
+  const auto fail_once = [&](std::string command)
+  {
+    const std::lock_guard lg{failing_mutex};
+    failing_command = std::move(command);
+  };
+  server.set_response("select 1", Fake_response::select({"n"}, {{"1"}}));
+  server.set_response("select 'x'", Fake_response::select({"v"}, {{"x"}}));
+  server.set_response("select null", Fake_response::select({"n"}, {{std::nullopt}}));
+  server.set_response("select stream", Fake_response::select({"i", "s"},
+    {{"1", "one"}, {"2", "two"}}, 5000));
+  server.set_response("select boom",
+    Fake_response::error("42P01", "relation \"boom\" does not exist"));
+  server.set_response("copy t from stdin", Fake_response::copy_in(2));
+  server.set_response("copy t to stdout", Fake_response::copy_out(
+    {{"1", "one"}, {"2", std::nullopt}}, 3));
+
+  pgfe::Connection conn{server.connection_options()};
+  conn.connect();
+  ASSERT(conn.is_connected());
+  ASSERT(server.session_count() == 1);
+  ASSERT(conn.transaction_status() == Transaction_status::unstarted);
+
+  // Canned rows.
+  {
+    int n{};
+    conn.execute([&n](auto&& row)
+    {
+      n = to<int>(row["n"]);
+    }, "select 1");
+    ASSERT(n == 1);
+
+    bool is_null{};
+    conn.execute([&is_null](auto&& row)
+    {
+      is_null = !row[0];
+    }, "select null");
+    ASSERT(is_null);
+  }
+
+  // Protocols. (Statement keeps only the first command of the string.)
+  {
+    ASSERT(!conn.is_simple_query_protocol_enabled());
+    for (const bool is_enabled : {false, true}) {
+      conn.set_simple_query_protocol_enabled(is_enabled);
+      const auto count = server.simple_query_count();
+      int row_count{};
+      const auto comp = conn.execute([&row_count](auto&& row)
+      {
+        ASSERT(to<int>(row[0]) == 1);
+        ++row_count;
+      }, "select 1; select 2");
+      ASSERT(row_count == 1);
+      ASSERT(comp.tag() == "SELECT");
+      ASSERT(server.simple_query_count() == count + is_enabled);
+      ASSERT(conn.is_ready_for_request());
+    }
+    conn.set_simple_query_protocol_enabled(false);
+  }
+
+  // Parameters.
+  {
+    int v{};
+    const auto comp = conn.execute([&v](auto&& row)
+    {
+      v = to<int>(row[0]);
+    }, "select $1", 42);
+    ASSERT(v == 42);
+    ASSERT(comp.tag() == "SELECT");
+    ASSERT(comp.row_count() == 1);
+  }
+
+  // Errors.
+  {
+    bool ok{};
+    try {
+      conn.execute("select boom");
+    } catch (const pgfe::Server_exception& e) {
+      ASSERT(e.error().condition() == Server_errc::c42_undefined_table);
+      ok = true;
+    }
+    ASSERT(ok);
+    ASSERT(conn.is_ready_for_request());
+  }
+
+  // Transactions.
+  {
+    conn.execute("begin");
+    ASSERT(conn.transaction_status() == Transaction_status::uncommitted);
+    bool ok{};
+    try {
+      conn.execute("select boom");
+    } catch (const pgfe::Server_exception&) {
+      ok = true;
+    }
+    ASSERT(ok);
+    ASSERT(conn.transaction_status() == Transaction_status::failed);
+    ok = false;
+    try {
+      conn.execute("select 1");
+    } catch (const pgfe::Server_exception& e) {
+      ASSERT(e.error().condition() ==
+        Server_errc::c25_in_failed_sql_transaction);
+      ok = true;
+    }
+    ASSERT(ok);
+    conn.execute("rollback");
+    ASSERT(conn.transaction_status() == Transaction_status::unstarted);
+  }
+
+  // Simple query protocol.
+  {
+    int sum{};
+    const auto comps = conn.execute_simple([&sum](auto&& row)
+    {
+      sum += to<int>(row[0]);
+    }, "select 1; set search_path to public; select stream");
+    ASSERT(comps.size() == 3);
+    ASSERT(comps[1].tag() == "SET");
+    ASSERT(sum == 1 + 3*5000);
+  }
+
+  // Prepared statements.
+  {
+    auto ps = conn.prepare("select $1", "ps");
+    ASSERT(ps.parameter_count() == 1);
+    for (int i{}; i < 3; ++i) {
+      int v{};
+      ps.bind(0, i).execute([&v](auto&& row)
+      {
+        v = to<int>(row[0]);
+      });
+      ASSERT(v == i);
+    }
+    conn.unprepare("ps");
+  }
+
+  // Pipeline.
+  {
+    conn.set_pipeline_enabled(true);
+    for (int i{}; i < 10; ++i)
+      conn.execute_nio("select 1");
+    conn.execute_nio("select boom");
+    conn.execute_nio("select 1");
+    conn.send_sync();
+    int row_count{};
+    int comp_count{};
+    for (int i{}; i < 10; ++i) {
+      conn.wait_response();
+      if (conn.row()) {
+        ++row_count;
+        conn.wait_response();
+      }
+      if (conn.completion())
+        ++comp_count;
+    }
+    ASSERT(row_count == 10 && comp_count == 10);
+    conn.wait_response();
+    ASSERT(conn.error());
+    ASSERT(conn.pipeline_status() == pgfe::Pipeline_status::aborted);
+    conn.wait_response();
+    ASSERT(!conn.ready_for_query());
+    conn.wait_response();
+    ASSERT(conn.ready_for_query());
+    ASSERT(!conn.has_uncompleted_request());
+    conn.set_pipeline_enabled(false);
+  }
+
+  // Pipeline executor. (Rows across several sync points, and the abort.)
+  {
+    conn.set_pipeline_enabled(true);
+    pgfe::Pipeline_executor executor{conn};
+    executor.set_sync_count(4);
+    std::vector<pgfe::Pipeline_executor::Handle> handles;
+    for (int i{}; i < 5; ++i)
+      handles.push_back(executor.execute("select stream"));
+    int row_count{};
+    auto streamed = executor.execute([&row_count](auto&&)
+    {
+      ++row_count;
+    }, "select stream");
+    auto failed = executor.execute("select boom");
+    auto skipped = executor.execute("select 1");
+    executor.finish();
+    ASSERT(!executor.unprocessed_count());
+    for (auto& handle : handles) {
+      ASSERT(handle.rows().size() == 10000);
+      ASSERT(handle.completion().tag() == "SELECT");
+    }
+    ASSERT(row_count == 10000 && streamed.rows().empty());
+    try {
+      std::rethrow_exception(failed.exception());
+    } catch (const pgfe::Server_exception& e) {
+      ASSERT(e.error().condition() == Server_errc::c42_undefined_table);
+    }
+    try {
+      std::rethrow_exception(skipped.exception());
+    } catch (const pgfe::Client_exception& e) {
+      ASSERT(e.condition() == pgfe::Client_errc::pipeline_aborted);
+    }
+    conn.set_pipeline_enabled(false);
+    ASSERT(conn.is_ready_for_request());
+  }
+
+  // COPY FROM STDIN.
+  {
+    conn.execute("copy t from stdin");
+    auto copier = conn.copier();
+    ASSERT(copier);
+    ASSERT(copier.field_count() == 2);
+    for (int i{}; i < 100; ++i)
+      ASSERT(copier.send(std::to_string(i).append("\tvalue\n")));
+    ASSERT(copier.end());
+    conn.wait_response_throw();
+    ASSERT(conn.completion().row_count() == 100);
+  }
+
+  // COPY TO STDOUT.
+  {
+    conn.execute("copy t to stdout");
+    auto copier = conn.copier();
+    ASSERT(copier);
+    std::string data;
+    while (const auto d = copier.receive())
+      data.append(static_cast<const char*>(d.bytes()), d.size());
+    ASSERT(data == "1\tone\n2\t\\N\n1\tone\n2\t\\N\n1\tone\n2\t\\N\n");
+    conn.wait_response_throw();
+    ASSERT(conn.completion().row_count() == 6);
+  }
+
+  // Parallel COPY.
+  {
+    pgfe::Connection_pool pool{2, server.connection_options()};
+    pool.connect();
+    pgfe::Parallel_copier loader{pool, "copy t from stdin", 2};
+    const auto load = [&loader]
+    {
+      int i{};
+      return loader.load([&i](std::string& row)
+      {
+        if (i == 1000)
+          return false;
+        row.assign(std::to_string(i++)).append("\tvalue\n");
+        return true;
+      }, [](const std::string_view row){return row.size();});
+    };
+    const auto committed_count = [&loader]
+    {
+      const auto& stats = loader.last_stream_stats();
+      return std::count_if(stats.begin(), stats.end(),
+        [](const auto& stat){return stat.is_committed;});
+    };
+    const auto is_load_failed = [&load]
+    {
+      try {
+        load();
+      } catch (const pgfe::Server_exception& e) {
+        ASSERT(e.error().condition() ==
+          Server_errc::c40_serialization_failure);
+        return true;
+      }
+      return false;
+    };
+
+    // Independent commits.
+    ASSERT(!loader.is_two_phase_commit_enabled());
+    ASSERT(load().size() == 2);
+    ASSERT(committed_count() == 2);
+    fail_once("commit");
+    ASSERT(is_load_failed());
+    ASSERT(committed_count() == 1); // not atomic
+
+    // Two-phase commit.
+    loader.set_two_phase_commit_enabled(true);
+    ASSERT(loader.is_two_phase_commit_enabled());
+    ASSERT(load().size() == 2);
+    ASSERT(committed_count() == 2);
+    fail_once("prepare transaction");
+    ASSERT(is_load_failed());
+    ASSERT(committed_count() == 0);
+  }
+
+  // Concurrent sessions sharing the statements.
+  {
+    const pgfe::Statement shared{"select $1"};
+    const auto literal = pgfe::Statement{"select :'v'"}.bind("v", "x");
+    const auto session_count = server.session_count();
+    std::vector<std::thread> threads;
+    for (int i{}; i < 4; ++i) {
+      threads.emplace_back([&server, &shared, &literal]
+      {
+        pgfe::Connection c{server.connection_options()};
+        c.connect();
+        int sum{};
+        for (int j{}; j < 100; ++j) {
+          c.execute([&sum](auto&& row)
+          {
+            sum += to<int>(row[0]);
+          }, shared, j);
+          c.execute([](auto&& row)
+          {
+            ASSERT(to<std::string_view>(row[0]) == "x");
+          }, literal);
+          ASSERT(shared.to_query_string(c) == "select $1");
+        }
+        ASSERT(sum == 4950);
+      });
+    }
+    for (auto& thread : threads)
+      thread.join();
+    ASSERT(server.session_count() == session_count + 4);
+  }
+
+  // Client overhead.
+  {
+    util::Benchmark_options opts;
+    opts.sample_count = 10;
+    const auto print = [](const util::Benchmark_result& r)
+    {
+      ASSERT(r.iteration_count > 0 && !r.samples.empty());
+      std::cout << r << std::endl;
+    };
+
+    print(util::benchmark("Round trip (extended query protocol)", [&]
+    {
+      conn.execute("select 1");
+    }, opts));
+
+    conn.set_simple_query_protocol_enabled(true);
+    print(util::benchmark("Round trip (simple query protocol)", [&]
+    {
+      conn.execute("select 1");
+    }, opts));
+    conn.set_simple_query_protocol_enabled(false);
+
+    print(util::benchmark("Round trip (parameterized)", [&]
+    {
+      conn.execute([](auto&& row)
+      {
+        util::do_not_optimize(row);
+      }, "select $1", 1);
+    }, opts));
+
+    print(util::benchmark("Row streaming (10000 rows)", [&]
+    {
+      long sum{};
+      conn.execute([&sum](auto&& row)
+      {
+        sum += to<int>(row[0]);
+      }, "select stream");
+      util::do_not_optimize(sum);
+    }, opts));
+
+    conn.set_pipeline_enabled(true);
+    print(util::benchmark("Pipeline (100 queries)", [&]
+    {
+      for (int i{}; i < 100; ++i)
+        conn.execute_nio("select 1");
+      conn.send_sync();
+      while (conn.has_uncompleted_request()) {
+        conn.process_responses([](auto&& row)
+        {
+          util::do_not_optimize(row);
+        });
+      }
+    }, opts));
+    conn.set_pipeline_enabled(false);
+  }
+} catch (const std::exception& e) {
+  std::cerr << e.what() << std::endl;
+  return 1;
+} catch (...) {
+  std::cerr << "unknown error" << std::endl;
+  return 2;
+}
@@ -0,0 +1,1101 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef DMITIGR_LIBS_TEST_PGFE_UNIT_FAKE_SERVER_HPP
+#define DMITIGR_LIBS_TEST_PGFE_UNIT_FAKE_SERVER_HPP
+
+#include "pgfe-unit.hpp"
+#include "../../src/net/descriptor.hpp"
+#include "../../src/net/listener.hpp"
+#include "../../src/os/pid.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace dmitigr::pgfe::test {
+
+/// A scripted response of Fake_server to a query.
+struct Fake_response final {
+  /// The kind of `COPY` started by the response.
+  enum class Copy { none, in, out };
+
+  /// The column names. (All the columns are of type `text`.)
+  std::vector<std::string> columns;
+
+  /// The rows. (Text format, `std::nullopt` denotes NULL.)
+  std::vector<std::vector<std::optional<std::string>>> rows;
+
+  /// The number of times the rows are sent.
+  std::size_t repeat{1};
+
+  /// The command tag. (`SELECT n` by default.)
+  std::string tag;
+
+  /// The SQLSTATE of the error, or empty string if the response is not an error.
+  std::string error_code;
+
+  /// The message of the error.
+  std::string error_message;
+
+  /// The kind of `COPY`.
+  Copy copy{Copy::none};
+
+  /// @returns The response to a command with the given `tag`.
+  static Fake_response command(std::string tag)
+  {
+    Fake_response result;
+    result.tag = std::move(tag);
+    return result;
+  }
+
+  /// @returns The response with the rows which are sent `repeat` times.
+  static Fake_response
+  select(std::vector<std::string> columns,
+    std::vector<std::vector<std::optional<std::string>>> rows,
+    const std::size_t repeat = 1)
+  {
+    Fake_response result;
+    result.columns = std::move(columns);
+    result.rows = std::move(rows);
+    result.repeat = repeat;
+    return result;
+  }
+
+  /// @returns The error response.
+  static Fake_response error(std::string code, std::string message)
+  {
+    Fake_response result;
+    result.error_code = std::move(code);
+    result.error_message = std::move(message);
+    return result;
+  }
+
+  /// @returns The response which starts `COPY ... FROM STDIN`.
+  static Fake_response copy_in(const std::size_t column_count)
+  {
+    Fake_response result;
+    result.columns.resize(column_count);
+    result.copy = Copy::in;
+    return result;
+  }
+
+  /// @returns The response which sends the rows by `COPY ... TO STDOUT`.
+  static Fake_response
+  copy_out(std::vector<std::vector<std::optional<std::string>>> rows,
+    const std::size_t repeat = 1)
+  {
+    Fake_response result;
+    result.columns.resize(rows.empty() ? 0 : rows.front().size());
+    result.rows = std::move(rows);
+    result.repeat = repeat;
+    result.copy = Copy::out;
+    return result;
+  }
+};
+
+/**
+ * @brief An in-process server which speaks the frontend/backend protocol v3
+ * and serves the scripted responses.
+ *
+ * @details The server accepts any startup packet without authentication,
+ * declines SSL and GSS encryption, supports both the simple and the extended
+ * query protocols (including pipelining), `COPY` in both directions and
+ * tracks the transaction status on `BEGIN`, `COMMIT` and `ROLLBACK`. Each
+ * session is served by its own thread. Intended for measuring the client-side
+ * costs without the noise of a real server.
+ *
+ * The response to a query is looked up in the following order:
+ *   -# the responses registered by set_response() (by the exact query text
+ *   with leading and trailing spaces removed);
+ *   -# the handler passed to the constructor;
+ *   -# the built-in responses to the transaction control (including the
+ *   two-phase commit), `SET`, `LISTEN`, `DEALLOCATE` and `DISCARD`
+ *   commands.
+ * Otherwise, the error with SQLSTATE `42601` is responded.
+ *
+ * @remarks The parameters are passed to the handler as is. The data is always
+ * sent in the text format.
+ */
+class Fake_server final {
+public:
+  /// The alias of the query parameters.
+  using Params = std::vector<std::optional<std::string>>;
+
+  /**
+   * @brief The alias of the handler of queries.
+   *
+   * @details The handler is called on the session threads concurrently. The
+   * handler is called with all the parameters set to NULL in order to describe
+   * a prepared statement.
+   */
+  using Handler = std::function<std::optional<Fake_response>(std::string_view,
+    const Params&)>;
+
+  /// The constructor. Starts the server.
+  explicit Fake_server(Handler handler = {})
+    : handler_{std::move(handler)}
+  {
+#ifdef _WIN32
+    listener_ = net::Listener::make(net::Listener_options{"127.0.0.1", port_,
+      64});
+#else
+    static std::atomic_uint instance_count;
+    namespace fs = std::filesystem;
+    directory_ = fs::temp_directory_path() / ("dmitigr_pgfe_fake_server-"
+      + std::to_string(os::pid()) + "-" + std::to_string(instance_count++));
+    fs::create_directories(directory_);
+    listener_ = net::Listener::make(net::Listener_options{
+      directory_ / (".s.PGSQL." + std::to_string(port_)), 64});
+#endif
+    listener_->listen();
+    acceptor_ = std::thread{[this]{accept_loop();}};
+  }
+
+  /// The destructor. Stops the server and disconnects the clients.
+  ~Fake_server()
+  {
+    is_stopped_ = true;
+    acceptor_.join();
+    {
+      const std::lock_guard lg{sessions_mutex_};
+      for (auto& session : sessions_)
+        session.shutdown();
+    }
+    for (auto& session : sessions_)
+      session.thread.join();
+    try {
+      listener_->close();
+    } catch (...) {}
+#ifndef _WIN32
+    std::error_code ec;
+    std::filesystem::remove_all(directory_, ec);
+#endif
+  }
+
+  /// Non copy-constructible.
+  Fake_server(const Fake_server&) = delete;
+
+  /// Non copy-assignable.
+  Fake_server& operator=(const Fake_server&) = delete;
+
+  /// Non move-constructible.
+  Fake_server(Fake_server&&) = delete;
+
+  /// Non move-assignable.
+  Fake_server& operator=(Fake_server&&) = delete;
+
+  /// Sets the `response` to the `query`.
+  void set_response(std::string query, Fake_response response)
+  {
+    auto r = std::make_shared<const Fake_response>(std::move(response));
+    const std::lock_guard lg{responses_mutex_};
+    responses_[std::string{trimmed(query)}] = std::move(r);
+  }
+
+  /// @returns The options to connect to this server.
+  Connection_options connection_options() const
+  {
+    return Connection_options{}
+#ifdef _WIN32
+      .set(Communication_mode::net)
+      .set_address("127.0.0.1")
+#else
+      .set(Communication_mode::uds)
+      .set_uds_directory(directory_)
+#endif
+      .set_port(port_)
+      .set_database("fake")
+      .set_username("fake")
+      .set_connect_timeout(std::chrono::seconds{7});
+  }
+
+  /// @returns The number of sessions accepted.
+  std::size_t session_count() const noexcept
+  {
+    return session_count_;
+  }
+
+  /**
+   * @brief Sends the notification to all the sessions.
+   *
+   * @details The notification is sent immediately, regardless of whether the
+   * sessions are processing the queries or listening the `channel`.
+   */
+  void notify(const std::string_view channel, const std::string_view payload)
+  {
+    const std::lock_guard lg{sessions_mutex_};
+    for (auto& session : sessions_)
+      session.notify(channel, payload);
+  }
+
+  /// @returns The number of Query messages (of the simple query protocol).
+  std::size_t simple_query_count() const noexcept
+  {
+    return simple_query_count_;
+  }
+
+private:
+  using Response_ptr = std::shared_ptr<const Fake_response>;
+
+  /// A prepared statement.
+  struct Statement final {
+    std::string query;
+    std::vector<std::uint32_t> param_oids;
+  };
+
+  /// A portal.
+  struct Portal final {
+    std::string query;
+    Params params;
+    Response_ptr response; // cached by Describe
+  };
+
+  /// A parser of message bodies.
+  class Reader final {
+  public:
+    explicit Reader(const std::string_view data) noexcept
+      : data_{data}
+    {}
+
+    std::int16_t int16()
+    {
+      return static_cast<std::int16_t>(uint(2));
+    }
+
+    std::int32_t int32()
+    {
+      return static_cast<std::int32_t>(uint(4));
+    }
+
+    std::string_view bytes(const std::size_t size)
+    {
+      check(size);
+      const auto result = data_.substr(pos_, size);
+      pos_ += size;
+      return result;
+    }
+
+    std::string_view cstr()
+    {
+      const auto end = data_.find('\0', pos_);
+      if (end == std::string_view::npos)
+        throw std::runtime_error{"fake server: malformed message"};
+      const auto result = data_.substr(pos_, end - pos_);
+      pos_ = end + 1;
+      return result;
+    }
+
+    char byte()
+    {
+      return bytes(1)[0];
+    }
+
+  private:
+    std::string_view data_;
+    std::size_t pos_{};
+
+    void check(const std::size_t size) const
+    {
+      if (data_.size() - pos_ < size)
+        throw std::runtime_error{"fake server: malformed message"};
+    }
+
+    std::uint32_t uint(const std::size_t size)
+    {
+      const auto b = bytes(size);
+      std::uint32_t result{};
+      for (const char c : b)
+        result = (result << 8) | static_cast<unsigned char>(c);
+      return result;
+    }
+  };
+
+  /// A session with a client.
+  class Session final {
+  public:
+    std::thread thread;
+
+    Session(Fake_server& server, std::unique_ptr<net::Descriptor> descriptor,
+      const std::int32_t pid)
+      : server_{server}
+      , descriptor_{std::move(descriptor)}
+      , pid_{pid}
+    {}
+
+    void run() noexcept
+    {
+      try {
+        if (startup()) {
+          char type{};
+          std::string_view body;
+          while (next_message(type, body) && dispatch(type, body));
+          flush();
+        }
+      } catch (...) {}
+      // The descriptor is closed upon destruction of the server.
+      shutdown();
+    }
+
+    void notify(const std::string_view channel,
+      const std::string_view payload) noexcept
+    {
+      try {
+        std::string msg{'A'};
+        put_int(msg, static_cast<std::uint32_t>(4 + 4 + channel.size() + 1 +
+            payload.size() + 1), 4);
+        put_int(msg, static_cast<std::uint32_t>(pid_), 4);
+        msg.append(channel).push_back('\0');
+        msg.append(payload).push_back('\0');
+        const std::lock_guard lg{write_mutex_};
+        write(msg);
+      } catch (...) {} // the session is probably finished
+    }
+
+    void shutdown() noexcept
+    {
+      ::shutdown(static_cast<net::Socket_native>(descriptor_->native_handle()),
+        net::sd_both);
+    }
+
+  private:
+    static constexpr std::size_t buffer_size_{65536};
+
+    Fake_server& server_;
+    std::unique_ptr<net::Descriptor> descriptor_;
+    std::int32_t pid_{};
+    std::string input_;
+    std::size_t input_pos_{};
+    std::string output_;
+    std::size_t message_pos_{};
+    std::mutex write_mutex_; // notify() writes from the other threads
+    char transaction_status_{'I'};
+    bool is_skipping_until_sync_{};
+    bool is_transaction_ending_{}; // by the last looked up query
+    bool is_copy_in_{};
+    bool is_copy_in_simple_{};
+    std::size_t copy_row_count_{};
+    std::deque<std::string> simple_queries_;
+    std::map<std::string, Statement, std::less<>> statements_;
+    std::map<std::string, Portal, std::less<>> portals_;
+
+    // -------------------------------------------------------------------------
+    // Input
+    // -------------------------------------------------------------------------
+
+    /// Ensures that `size` bytes are available in the input buffer.
+    bool fill(const std::size_t size)
+    {
+      if (input_.size() - input_pos_ >= size)
+        return true;
+
+      input_.erase(0, input_pos_);
+      input_pos_ = 0;
+      while (input_.size() < size) {
+        // Never block on read with the pending output.
+        flush();
+        const auto offset = input_.size();
+        input_.resize(offset + std::max(size - offset, buffer_size_));
+        const auto n = descriptor_->read(input_.data() + offset,
+          static_cast<std::streamsize>(input_.size() - offset));
+        input_.resize(offset + static_cast<std::size_t>(std::max(n,
+          std::streamsize{})));
+        if (n <= 0)
+          return false;
+      }
+      return true;
+    }
+
+    static std::size_t length(const char* const data)
+    {
+      std::uint32_t result{};
+      for (int i{}; i < 4; ++i)
+        result = (result << 8) | static_cast<unsigned char>(data[i]);
+      if (result < 4)
+        throw std::runtime_error{"fake server: malformed message length"};
+      return result;
+    }
+
+    bool next_message(char& type, std::string_view& body)
+    {
+      if (!fill(5))
+        return false;
+      const auto size = length(input_.data() + input_pos_ + 1);
+      if (!fill(size + 1))
+        return false;
+      type = input_[input_pos_];
+      body = std::string_view{input_}.substr(input_pos_ + 5, size - 4);
+      input_pos_ += size + 1;
+      return true;
+    }
+
+    bool next_startup_message(std::string_view& body)
+    {
+      if (!fill(4))
+        return false;
+      const auto size = length(input_.data() + input_pos_);
+      if (!fill(size))
+        return false;
+      body = std::string_view{input_}.substr(input_pos_ + 4, size - 4);
+      input_pos_ += size;
+      return true;
+    }
+
+    // -------------------------------------------------------------------------
+    // Output
+    // -------------------------------------------------------------------------
+
+    void write(const std::string_view data)
+    {
+      std::size_t offset{};
+      while (offset < data.size()) {
+        const auto n = descriptor_->write(data.data() + offset,
+          static_cast<std::streamsize>(data.size() - offset));
+        if (n <= 0)
+          throw std::runtime_error{"fake server: cannot write"};
+        offset += static_cast<std::size_t>(n);
+      }
+    }
+
+    void flush()
+    {
+      const std::lock_guard lg{write_mutex_};
+      write(output_);
+      output_.clear();
+    }
+
+    void flush_if_full()
+    {
+      if (output_.size() >= buffer_size_)
+        flush();
+    }
+
+    static void put_int(std::string& out, const std::uint32_t value,
+      const int size)
+    {
+      for (int i{size - 1}; i >= 0; --i)
+        out.push_back(static_cast<char>((value >> (8*i)) & 0xff));
+    }
+
+    void put_int16(const std::int16_t value)
+    {
+      put_int(output_, static_cast<std::uint16_t>(value), 2);
+    }
+
+    void put_int32(const std::int32_t value)
+    {
+      put_int(output_, static_cast<std::uint32_t>(value), 4);
+    }
+
+    void put_cstr(const std::string_view value)
+    {
+      output_.append(value);
+      output_.push_back('\0');
+    }
+
+    void begin_message(const char type)
+    {
+      output_.push_back(type);
+      message_pos_ = output_.size();
+      output_.append(4, '\0');
+    }
+
+    void end_message()
+    {
+      const auto size = output_.size() - message_pos_;
+      std::string len;
+      put_int(len, static_cast<std::uint32_t>(size), 4);
+      output_.replace(message_pos_, 4, len);
+    }
+
+    void message(const char type)
+    {
+      begin_message(type);
+      end_message();
+    }
+
+    void parameter_status(const std::string_view name,
+      const std::string_view value)
+    {
+      begin_message('S');
+      put_cstr(name);
+      put_cstr(value);
+      end_message();
+    }
+
+    void ready_for_query()
+    {
+      begin_message('Z');
+      output_.push_back(transaction_status_);
+      end_message();
+      flush();
+    }
+
+    void command_complete(const std::string_view tag)
+    {
+      begin_message('C');
+      put_cstr(tag);
+      end_message();
+    }
+
+    void error_response(const std::string_view code,
+      const std::string_view message)
+    {
+      begin_message('E');
+      for (const char field : {'S', 'V'}) {
+        output_.push_back(field);
+        put_cstr("ERROR");
+      }
+      output_.push_back('C');
+      put_cstr(code);
+      output_.push_back('M');
+      put_cstr(message);
+      output_.push_back('\0');
+      end_message();
+      if (transaction_status_ == 'T')
+        transaction_status_ = 'E';
+    }
+
+    void row_description(const Fake_response& response)
+    {
+      begin_message('T');
+      put_int16(static_cast<std::int16_t>(response.columns.size()));
+      for (const auto& column : response.columns) {
+        put_cstr(column);
+        put_int32(0); // table OID
+        put_int16(0); // column number
+        put_int32(25); // type OID (text)
+        put_int16(-1); // type size
+        put_int32(-1); // type modifier
+        put_int16(0); // format code
+      }
+      end_message();
+    }
+
+    void copy_response(const char type, const Fake_response& response)
+    {
+      begin_message(type);
+      output_.push_back('\0'); // text format
+      put_int16(static_cast<std::int16_t>(response.columns.size()));
+      for (std::size_t i{}; i < response.columns.size(); ++i)
+        put_int16(0);
+      end_message();
+    }
+
+    /// Sends the response. Returns `false` on error.
+    bool respond(const Fake_response& response, const bool is_described)
+    {
+      if (!response.error_code.empty()) {
+        error_response(response.error_code, response.error_message);
+        // The failed COMMIT or PREPARE TRANSACTION ends the transaction.
+        if (is_transaction_ending_)
+          transaction_status_ = 'I';
+        return false;
+      }
+
+      switch (response.copy) {
+      case Fake_response::Copy::in:
+        copy_response('G', response);
+        is_copy_in_ = true;
+        copy_row_count_ = 0;
+        return true;
+      case Fake_response::Copy::out: {
+        copy_response('H', response);
+        std::string rows;
+        for (const auto& row : response.rows) {
+          const auto offset = rows.size();
+          rows.push_back('d');
+          rows.append(4, '\0');
+          for (std::size_t i{}; i < row.size(); ++i) {
+            if (i)
+              rows.push_back('\t');
+            rows.append(row[i] ? *row[i] : "\\N");
+          }
+          rows.push_back('\n');
+          std::string len;
+          put_int(len, static_cast<std::uint32_t>(rows.size() - offset - 1), 4);
+          rows.replace(offset + 1, 4, len);
+        }
+        for (std::size_t i{}; i < response.repeat; ++i) {
+          output_.append(rows);
+          flush_if_full();
+        }
+        message('c');
+        command_complete(response.tag.empty() ? "COPY " +
+          std::to_string(response.rows.size() * response.repeat) :
+          response.tag);
+        return true;
+      }
+      case Fake_response::Copy::none:
+        break;
+      }
+
+      if (!response.columns.empty() && !is_described)
+        row_description(response);
+
+      // Encode the rows once and send them `repeat` times.
+      const auto offset = output_.size();
+      for (const auto& row : response.rows) {
+        begin_message('D');
+        put_int16(static_cast<std::int16_t>(row.size()));
+        for (const auto& field : row) {
+          if (field) {
+            put_int32(static_cast<std::int32_t>(field->size()));
+            output_.append(*field);
+          } else
+            put_int32(-1);
+        }
+        end_message();
+      }
+      if (response.repeat > 1) {
+        const std::string rows{output_.substr(offset)};
+        flush_if_full();
+        for (std::size_t i{1}; i < response.repeat; ++i) {
+          output_.append(rows);
+          flush_if_full();
+        }
+      } else if (response.repeat == 0)
+        output_.resize(offset);
+
+      const auto& tag = !response.tag.empty() ? response.tag :
+        "SELECT " + std::to_string(response.rows.size() * response.repeat);
+      command_complete(tag);
+      if (tag == "BEGIN" || tag == "START TRANSACTION")
+        transaction_status_ = 'T';
+      else if (tag == "COMMIT" || tag == "ROLLBACK" ||
+        tag == "PREPARE TRANSACTION")
+        transaction_status_ = 'I';
+      return true;
+    }
+
+    // -------------------------------------------------------------------------
+    // Protocol
+    // -------------------------------------------------------------------------
+
+    bool startup()
+    {
+      while (true) {
+        std::string_view body;
+        if (!next_startup_message(body))
+          return false;
+
+        Reader reader{body};
+        const auto code = reader.int32();
+        if (code == 80877103 || code == 80877104) { // SSLRequest, GSSENCRequest
+          output_.push_back('N');
+          flush();
+        } else if (code == 80877102) // CancelRequest
+          return false;
+        else if (code >> 16 == 3)
+          break;
+        else
+          throw std::runtime_error{"fake server: unsupported protocol"};
+      }
+
+      begin_message('R'); // AuthenticationOk
+      put_int32(0);
+      end_message();
+      parameter_status("server_version", "16.0");
+      parameter_status("server_encoding", "UTF8");
+      parameter_status("client_encoding", "UTF8");
+      parameter_status("DateStyle", "ISO, MDY");
+      parameter_status("integer_datetimes", "on");
+      parameter_status("standard_conforming_strings", "on");
+      begin_message('K'); // BackendKeyData
+      put_int32(pid_);
+      put_int32(pid_);
+      end_message();
+      ready_for_query();
+      return true;
+    }
+
+    /// Processes the message. Returns `false` on Terminate.
+    bool dispatch(const char type, const std::string_view body)
+    {
+      Reader reader{body};
+      if (is_copy_in_) {
+        switch (type) {
+        case 'd': // CopyData
+          copy_row_count_ += std::count(body.begin(), body.end(), '\n');
+          return true;
+        case 'c': // CopyDone
+          is_copy_in_ = false;
+          command_complete("COPY " + std::to_string(copy_row_count_));
+          break;
+        case 'f': // CopyFail
+          is_copy_in_ = false;
+          error_response("57014", "COPY from stdin failed: "
+            + std::string{reader.cstr()});
+          if (!is_copy_in_simple_)
+            is_skipping_until_sync_ = true;
+          simple_queries_.clear();
+          break;
+        case 'H': case 'S': // ignored during COPY
+          return true;
+        default:
+          throw std::runtime_error{"fake server: unexpected message during COPY"};
+        }
+        if (is_copy_in_simple_)
+          execute_simple_queries();
+        return true;
+      }
+
+      if (is_skipping_until_sync_ && type != 'S' && type != 'X')
+        return true;
+
+      switch (type) {
+      case 'Q': simple_query(reader); break;
+      case 'P': parse(reader); break;
+      case 'B': bind(reader); break;
+      case 'D': describe(reader); break;
+      case 'E': execute(reader); break;
+      case 'C': close(reader); break;
+      case 'H': flush(); break;
+      case 'S':
+        is_skipping_until_sync_ = false;
+        ready_for_query();
+        break;
+      case 'X':
+        return false;
+      default:
+        error_response("08P01", "fake server: unsupported message type");
+        is_skipping_until_sync_ = true;
+      }
+      return true;
+    }
+
+    void simple_query(Reader& reader)
+    {
+      ++server_.simple_query_count_;
+      const auto query = reader.cstr();
+      try {
+        const Statement_vector statements{query};
+        for (std::size_t i{}; i < statements.size(); ++i) {
+          const auto& statement = statements[i];
+          if (!statement.is_query_empty())
+            simple_queries_.emplace_back(trimmed(statement.to_string()));
+        }
+      } catch (const std::exception& e) {
+        error_response("42601", e.what());
+        ready_for_query();
+        return;
+      }
+      if (simple_queries_.empty())
+        message('I'); // EmptyQueryResponse
+      execute_simple_queries();
+    }
+
+    void execute_simple_queries()
+    {
+      is_copy_in_simple_ = true;
+      while (!simple_queries_.empty()) {
+        const auto query = std::move(simple_queries_.front());
+        simple_queries_.pop_front();
+        if (!respond(*lookup(query, {}), false)) {
+          simple_queries_.clear();
+          break;
+        } else if (is_copy_in_)
+          return;
+      }
+      is_copy_in_simple_ = false;
+      ready_for_query();
+    }
+
+    void parse(Reader& reader)
+    {
+      const auto name = reader.cstr();
+      Statement statement{std::string{trimmed(reader.cstr())}, {}};
+      const auto oid_count = reader.int16();
+      for (std::int16_t i{}; i < oid_count; ++i)
+        statement.param_oids.push_back(static_cast<std::uint32_t>(reader.int32()));
+
+      // Deduce the number of parameters from the highest `$n` of the query.
+      std::size_t param_count{};
+      const auto& q = statement.query;
+      for (std::size_t i{}; i < q.size(); ++i) {
+        if (q[i] == '$' && i + 1 < q.size() && std::isdigit(q[i + 1])) {
+          std::size_t n{};
+          for (++i; i < q.size() && std::isdigit(q[i]); ++i)
+            n = n*10 + static_cast<std::size_t>(q[i] - '0');
+          param_count = std::max(param_count, n);
+        }
+      }
+      if (statement.param_oids.size() < param_count)
+        statement.param_oids.resize(param_count);
+      for (auto& oid : statement.param_oids) {
+        if (!oid)
+          oid = 25; // text
+      }
+
+      statements_.insert_or_assign(std::string{name}, std::move(statement));
+      message('1'); // ParseComplete
+    }
+
+    void bind(Reader& reader)
+    {
+      const auto portal_name = reader.cstr();
+      const auto statement_name = reader.cstr();
+      const auto s = statements_.find(statement_name);
+      if (s == statements_.end()) {
+        error_response("26000", "prepared statement \""
+          + std::string{statement_name} + "\" does not exist");
+        is_skipping_until_sync_ = true;
+        return;
+      }
+
+      Portal portal{s->second.query, {}, {}};
+      const auto format_count = reader.int16();
+      for (std::int16_t i{}; i < format_count; ++i)
+        reader.int16();
+      const auto param_count = reader.int16();
+      for (std::int16_t i{}; i < param_count; ++i) {
+        if (const auto size = reader.int32(); size >= 0)
+          portal.params.emplace_back(reader.bytes(static_cast<std::size_t>(size)));
+        else
+          portal.params.emplace_back();
+      }
+      portals_.insert_or_assign(std::string{portal_name}, std::move(portal));
+      message('2'); // BindComplete
+    }
+
+    void describe(Reader& reader)
+    {
+      const auto kind = reader.byte();
+      const auto name = reader.cstr();
+      Response_ptr response;
+      if (kind == 'S') {
+        const auto s = statements_.find(name);
+        if (s == statements_.end()) {
+          error_response("26000", "prepared statement \""
+            + std::string{name} + "\" does not exist");
+          is_skipping_until_sync_ = true;
+          return;
+        }
+        const auto& oids = s->second.param_oids;
+        begin_message('t'); // ParameterDescription
+        put_int16(static_cast<std::int16_t>(oids.size()));
+        for (const auto oid : oids)
+          put_int32(static_cast<std::int32_t>(oid));
+        end_message();
+        response = lookup(s->second.query, Params(oids.size()));
+      } else {
+        const auto p = portals_.find(name);
+        if (p == portals_.end()) {
+          error_response("34000", "portal \""
+            + std::string{name} + "\" does not exist");
+          is_skipping_until_sync_ = true;
+          return;
+        }
+        response = p->second.response = lookup(p->second.query,
+          p->second.params);
+      }
+
+      if (!response->error_code.empty()) {
+        respond(*response, false);
+        is_skipping_until_sync_ = true;
+      } else if (!response->columns.empty()
+        && response->copy == Fake_response::Copy::none)
+        row_description(*response);
+      else
+        message('n'); // NoData
+    }
+
+    void execute(Reader& reader)
+    {
+      const auto name = reader.cstr();
+      const auto p = portals_.find(name);
+      if (p == portals_.end()) {
+        error_response("34000", "portal \""
+          + std::string{name} + "\" does not exist");
+        is_skipping_until_sync_ = true;
+        return;
+      }
+
+      auto& portal = p->second;
+      if (portal.query.empty()) {
+        message('I'); // EmptyQueryResponse
+        return;
+      }
+      const auto response = portal.response ? std::move(portal.response) :
+        lookup(portal.query, portal.params);
+      is_copy_in_simple_ = false;
+      if (!respond(*response, true))
+        is_skipping_until_sync_ = true;
+    }
+
+    void close(Reader& reader)
+    {
+      const auto kind = reader.byte();
+      const auto name = reader.cstr();
+      if (kind == 'S') {
+        if (const auto s = statements_.find(name); s != statements_.end())
+          statements_.erase(s);
+      } else if (const auto p = portals_.find(name); p != portals_.end())
+        portals_.erase(p);
+      message('3'); // CloseComplete
+    }
+
+    // -------------------------------------------------------------------------
+    // Responses
+    // -------------------------------------------------------------------------
+
+    Response_ptr lookup(const std::string& query, const Params& params)
+    {
+      static const auto begin = make_command("BEGIN");
+      static const auto commit = make_command("COMMIT");
+      static const auto rollback = make_command("ROLLBACK");
+      static const auto set = make_command("SET");
+      static const auto listen = make_command("LISTEN");
+      static const auto deallocate = make_command("DEALLOCATE");
+      static const auto discard = make_command("DISCARD ALL");
+      static const auto prepare_transaction = make_command("PREPARE TRANSACTION");
+      static const auto commit_prepared = make_command("COMMIT PREPARED");
+      static const auto rollback_prepared = make_command("ROLLBACK PREPARED");
+      static const auto in_failed_transaction = std::make_shared<const
+        Fake_response>(Fake_response::error("25P02", "current transaction is "
+          "aborted, commands ignored until end of transaction block"));
+
+      // Extract the first two words of the query in lower case.
+      std::string command;
+      std::string qualifier;
+      {
+        std::string word;
+        for (std::size_t i{}; i <= query.size(); ++i) {
+          const auto c = i < query.size() ?
+            static_cast<unsigned char>(query[i]) : '\0';
+          if (std::isalpha(c)) {
+            word.push_back(static_cast<char>(std::tolower(c)));
+            continue;
+          } else if (!word.empty()) {
+            (command.empty() ? command : qualifier) = std::move(word);
+            word.clear();
+          }
+          if (c != ' ' || !qualifier.empty())
+            break;
+        }
+      }
+
+      const bool is_commit = command == "commit" || command == "end";
+      const bool is_rollback = command == "rollback" || command == "abort";
+      const bool is_prepared = qualifier == "prepared";
+      const bool is_prepare_transaction = command == "prepare" &&
+        qualifier == "transaction";
+      is_transaction_ending_ = !is_prepared &&
+        (is_commit || is_rollback || is_prepare_transaction);
+
+      if (transaction_status_ == 'E')
+        return is_rollback || (!is_prepared && (is_commit ||
+          is_prepare_transaction)) ? rollback : in_failed_transaction;
+
+      {
+        const std::lock_guard lg{server_.responses_mutex_};
+        if (const auto r = server_.responses_.find(query);
+          r != server_.responses_.end())
+          return r->second;
+      }
+
+      if (server_.handler_) {
+        if (auto r = server_.handler_(query, params))
+          return std::make_shared<const Fake_response>(std::move(*r));
+      }
+
+      if (command == "begin" || command == "start")
+        return begin;
+      else if (is_prepare_transaction)
+        return prepare_transaction;
+      else if (is_commit)
+        return is_prepared ? commit_prepared : commit;
+      else if (is_rollback)
+        return is_prepared ? rollback_prepared : rollback;
+      else if (command == "set")
+        return set;
+      else if (command == "listen")
+        return listen;
+      else if (command == "deallocate")
+        return deallocate;
+      else if (command == "discard")
+        return discard;
+      else
+        return std::make_shared<const Fake_response>(Fake_response::error(
+          "42601", "fake server has no response to query: " + query));
+    }
+
+    static Response_ptr make_command(std::string tag)
+    {
+      return std::make_shared<const Fake_response>(
+        Fake_response::command(std::move(tag)));
+    }
+  };
+
+  static constexpr int port_{54329};
+  Handler handler_;
+  std::filesystem::path directory_;
+  std::unique_ptr<net::Listener> listener_;
+  std::thread acceptor_;
+  std::atomic_bool is_stopped_{};
+  std::atomic_size_t session_count_{};
+  std::atomic_size_t simple_query_count_{};
+  std::mutex sessions_mutex_;
+  std::list<Session> sessions_;
+  std::mutex responses_mutex_;
+  std::map<std::string, Response_ptr, std::less<>> responses_;
+
+  void accept_loop() noexcept
+  {
+    try {
+      while (!is_stopped_) {
+        if (!listener_->wait(std::chrono::milliseconds{50}))
+          continue;
+        auto descriptor = listener_->accept();
+        const std::lock_guard lg{sessions_mutex_};
+        auto& session = sessions_.emplace_back(*this, std::move(descriptor),
+          static_cast<std::int32_t>(++session_count_));
+        session.thread = std::thread{[&session]{session.run();}};
+      }
+    } catch (...) {}
+  }
+
+  static std::string_view trimmed(std::string_view str) noexcept
+  {
+    const auto is_space = [](const char c)
+    {
+      return std::isspace(static_cast<unsigned char>(c));
+    };
+    while (!str.empty() && is_space(str.front()))
+      str.remove_prefix(1);
+    while (!str.empty() && is_space(str.back()))
+      str.remove_suffix(1);
+    return str;
+  }
+};
+
+} // namespace dmitigr::pgfe::test
+
+#endif // DMITIGR_LIBS_TEST_PGFE_UNIT_FAKE_SERVER_HPP
@@ -0,0 +1,120 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pgfe-unit.hpp"
+
+#include <istream>
+#include <iterator>
+#include <ostream>
+#include <string>
+
+#define ASSERT DMITIGR_ASSERT
+
+int main()
+try {
+  namespace pgfe = dmitigr::pgfe;
+
+  // Prepare.
+  auto conn = pgfe::test::make_connection();
+  conn->connect();
+  conn->execute("begin");
+  const auto oid = conn->create_large_object();
+  ASSERT(oid != pgfe::invalid_oid);
+  auto lob = conn->open_large_object(oid,
+    pgfe::Large_object_open_mode::writing |
+    pgfe::Large_object_open_mode::reading);
+  ASSERT(lob);
+
+  std::string expected;
+  for (int i{}; i < 10000; ++i)
+    expected.append(std::to_string(i)).append("\n");
+  const std::string large(100, 'x');
+
+  // Test write.
+  {
+    pgfe::Large_object_streambuf buf{lob, 64};
+    ASSERT(&buf.large_object() == &lob);
+    ASSERT(buf.buffer_size() == 64);
+    std::ostream out{&buf};
+    for (int i{}; i < 10000; ++i)
+      out << i << '\n';
+    out.write(large.data(), large.size()); // written directly
+    ASSERT(out.flush());
+    ASSERT(lob.tell() == static_cast<std::int_fast64_t>(expected.size() +
+        large.size()));
+  }
+  expected.append(large);
+
+  // Test read.
+  lob.seek(0, pgfe::Large_object_seek_whence::begin);
+  {
+    pgfe::Large_object_streambuf buf{lob, 64};
+    std::istream in{&buf};
+    const std::string content{std::istreambuf_iterator<char>{in},
+      std::istreambuf_iterator<char>{}};
+    ASSERT(content == expected);
+  }
+
+  // Test seek and mixed reading and writing.
+  {
+    pgfe::Large_object_streambuf buf{lob, 64};
+    std::iostream io{&buf};
+    ASSERT(io.seekg(10));
+    ASSERT(io.tellg() == 10);
+    char chars[4]{};
+    ASSERT(io.read(chars, 3));
+    ASSERT(std::string_view(chars, 3) == expected.substr(10, 3));
+
+    // Seek backward within the buffer.
+    ASSERT(io.seekg(-3, std::ios_base::cur));
+    ASSERT(io.tellg() == 10);
+
+    // Overwrite.
+    ASSERT(io.seekp(20));
+    ASSERT(io.write("abc", 3));
+    ASSERT(io.tellp() == 23);
+    expected.replace(20, 3, "abc");
+
+    // Read after writing.
+    ASSERT(io.seekg(18));
+    ASSERT(io.read(chars, 4));
+    ASSERT(std::string_view(chars, 4) == expected.substr(18, 4));
+
+    // Write after reading.
+    ASSERT(io.write("z", 1));
+    ASSERT(io.flush());
+    expected.replace(22, 1, "z");
+
+    // Read large block directly.
+    std::string block(expected.size(), '\0');
+    ASSERT(io.seekg(0));
+    ASSERT(io.read(block.data(), block.size()));
+    ASSERT(block == expected);
+
+    // Seek to the end.
+    ASSERT(io.seekg(0, std::ios_base::end));
+    ASSERT(io.tellg() == static_cast<std::streamoff>(expected.size()));
+    ASSERT(io.get() == std::char_traits<char>::eof());
+  }
+
+  conn->execute("rollback");
+} catch (const std::exception& e) {
+  std::cerr << e.what() << std::endl;
+  return 1;
+} catch (...) {
+  std::cerr << "unknown error" << std::endl;
+  return 2;
+}
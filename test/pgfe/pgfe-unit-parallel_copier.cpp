@@ -0,0 +1,132 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pgfe-unit.hpp"
+
+#include <string>
+
+#define ASSERT DMITIGR_ASSERT
+
+int main()
+try {
+  namespace pgfe = dmitigr::pgfe;
+  using pgfe::to;
+
+  // Prepare.
+  auto conn = pgfe::test::make_connection();
+  conn->connect();
+  conn->execute("drop table if exists pgfe_parallel_copy");
+  conn->execute("create table pgfe_parallel_copy(id integer not null, str text)");
+
+  pgfe::Connection_pool pool{4, pgfe::test::connection_options()};
+  pool.connect();
+  pgfe::Parallel_copier loader{pool, "copy pgfe_parallel_copy from stdin", 4};
+  ASSERT(loader.stream_count() == 4);
+  loader.set_batch_size(1024).set_queue_capacity(2);
+  ASSERT(loader.batch_size() == 1024);
+  ASSERT(loader.queue_capacity() == 2);
+
+  const auto partitioner = [](const std::string_view row)
+  {
+    return static_cast<std::size_t>(std::stoi(std::string{row.substr(0,
+            row.find('\t'))}));
+  };
+
+  // Test success.
+  {
+    constexpr int row_count{100000};
+    int i{};
+    const auto stats = loader.load([&i](std::string& row)
+    {
+      if (i == row_count)
+        return false;
+      row.assign(std::to_string(i++)).append("\tvalue\n");
+      return true;
+    }, partitioner);
+    ASSERT(stats.size() == 4);
+    std::size_t total{};
+    for (const auto& stat : stats) {
+      ASSERT(stat.row_count == row_count / 4);
+      ASSERT(stat.byte_count > 0);
+      ASSERT(stat.bytes_per_second() > 0);
+      ASSERT(stat.is_committed);
+      total += stat.row_count;
+    }
+    ASSERT(total == row_count);
+    conn->execute([](auto&& row)
+    {
+      ASSERT(to<int>(row[0]) == row_count);
+    }, "select count(*) from pgfe_parallel_copy");
+  }
+
+  // Test failure (the invalid row is sent to one of the streams).
+  {
+    int i{};
+    bool is_thrown{};
+    try {
+      loader.load([&i](std::string& row)
+      {
+        if (i == 1000)
+          return false;
+        row.assign(std::to_string(i)).append(i == 500 ? "\n" : "\tvalue\n");
+        ++i;
+        return true;
+      }, partitioner);
+    } catch (const pgfe::Server_exception&) {
+      is_thrown = true;
+    }
+    ASSERT(is_thrown);
+    ASSERT(loader.last_stream_stats().size() == 4);
+    for (const auto& stat : loader.last_stream_stats())
+      ASSERT(!stat.is_committed);
+    conn->execute([](auto&& row)
+    {
+      ASSERT(to<int>(row[0]) == 100000);
+    }, "select count(*) from pgfe_parallel_copy");
+  }
+
+  // Test two-phase commit (if the server permits).
+  int max_prepared_transactions{};
+  conn->execute([&max_prepared_transactions](auto&& row)
+  {
+    max_prepared_transactions = to<int>(row[0]);
+  }, "show max_prepared_transactions");
+  if (max_prepared_transactions >= 4) {
+    loader.set_two_phase_commit_enabled(true);
+    int i{};
+    const auto stats = loader.load([&i](std::string& row)
+    {
+      if (i == 1000)
+        return false;
+      row.assign(std::to_string(i++)).append("\tvalue\n");
+      return true;
+    }, partitioner);
+    for (const auto& stat : stats)
+      ASSERT(stat.is_committed);
+    conn->execute([](auto&& row)
+    {
+      ASSERT(to<int>(row[0]) == 101000);
+    }, "select count(*) from pgfe_parallel_copy");
+  }
+
+  conn->execute("drop table pgfe_parallel_copy");
+} catch (const std::exception& e) {
+  std::cerr << e.what() << std::endl;
+  return 1;
+} catch (...) {
+  std::cerr << "unknown error" << std::endl;
+  return 2;
+}
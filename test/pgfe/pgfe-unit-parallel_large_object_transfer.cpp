@@ -0,0 +1,95 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pgfe-unit.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#define ASSERT DMITIGR_ASSERT
+
+int main()
+try {
+  namespace pgfe = dmitigr::pgfe;
+  namespace fs = std::filesystem;
+
+  // Prepare.
+  const auto dir = fs::temp_directory_path();
+  const auto source = dir / "pgfe-unit-parallel_lob-source";
+  const auto target = dir / "pgfe-unit-parallel_lob-target";
+  std::string content;
+  for (int i{}; content.size() < 1000000; ++i)
+    content.append(std::to_string(i)).append(" ");
+  {
+    std::ofstream out{source, std::ios_base::binary};
+    out.write(content.data(), content.size());
+    ASSERT(out);
+  }
+  const auto read_file = [](const fs::path& path)
+  {
+    std::ifstream in{path, std::ios_base::binary};
+    return std::string{std::istreambuf_iterator<char>{in},
+      std::istreambuf_iterator<char>{}};
+  };
+
+  pgfe::Connection_pool pool{4, pgfe::test::connection_options()};
+  pool.connect();
+  pgfe::Parallel_large_object_transfer transfer{pool, 4};
+  ASSERT(transfer.stream_count() == 4);
+  transfer.set_chunk_size(65536);
+  ASSERT(transfer.chunk_size() == 65536);
+
+  // Test import.
+  const auto oid = transfer.import_file(source);
+  ASSERT(oid != pgfe::invalid_oid);
+
+  // Test export.
+  transfer.export_file(oid, target);
+  ASSERT(read_file(target) == content);
+
+  // Test export of the nonexistent large object.
+  auto conn = pgfe::test::make_connection();
+  conn->connect();
+  conn->remove_large_object(oid);
+  bool is_thrown{};
+  try {
+    transfer.export_file(oid, target);
+  } catch (const pgfe::Client_exception&) {
+    is_thrown = true;
+  }
+  ASSERT(is_thrown);
+  ASSERT(!fs::exists(target));
+
+  // Test the empty file.
+  {
+    std::ofstream{source, std::ios_base::trunc};
+  }
+  const auto empty_oid = transfer.import_file(source);
+  transfer.export_file(empty_oid, target);
+  ASSERT(fs::file_size(target) == 0);
+  conn->remove_large_object(empty_oid);
+
+  fs::remove(source);
+  fs::remove(target);
+} catch (const std::exception& e) {
+  std::cerr << e.what() << std::endl;
+  return 1;
+} catch (...) {
+  std::cerr << "unknown error" << std::endl;
+  return 2;
+}
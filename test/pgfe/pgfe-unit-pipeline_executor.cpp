@@ -0,0 +1,174 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pgfe-unit.hpp"
+
+#define ASSERT DMITIGR_ASSERT
+
+int main()
+try {
+  namespace pgfe = dmitigr::pgfe;
+  using pgfe::Client_errc;
+  using pgfe::Pipeline_executor;
+  using pgfe::to;
+
+  // Prepare.
+  auto conn = pgfe::test::make_connection();
+  conn->connect();
+  Pipeline_executor executor{*conn};
+  ASSERT(conn->pipeline_status() == pgfe::Pipeline_status::enabled);
+  ASSERT(executor.sync_count() > 0);
+  ASSERT(executor.sync_bytes() > 0);
+  ASSERT(!executor.sync_interval());
+
+  /*
+   * Test case 1. Deep pipeline with automatic syncs.
+   */
+  {
+    executor.set_sync_count(100);
+    std::vector<Pipeline_executor::Handle> handles;
+    for (int i{}; i < 1000; ++i)
+      handles.push_back(executor.execute("select $1::integer", i));
+    ASSERT(executor.unprocessed_count() <= handles.size());
+    for (int i{}; i < 1000; ++i) {
+      auto& handle = handles[static_cast<unsigned>(i)];
+      ASSERT(handle.completion().tag() == "SELECT");
+      ASSERT(handle.rows().size() == 1);
+      ASSERT(to<int>(handle.rows()[0][0]) == i);
+    }
+    ASSERT(!executor.unprocessed_count());
+  }
+
+  /*
+   * Test case 2. Row handler.
+   */
+  {
+    int sum{};
+    auto handle = executor.execute([&sum](auto&& row)
+    {
+      sum += to<int>(row[0]);
+    }, "select generate_series(1, 10)");
+    executor.finish();
+    ASSERT(handle.is_ready());
+    ASSERT(handle.rows().empty());
+    ASSERT(sum == 55);
+  }
+
+  /*
+   * Test case 3. Pipeline abort attribution.
+   */
+  {
+    auto h1 = executor.execute("select 1");
+    auto h2 = executor.execute("syntax error");
+    auto h3 = executor.execute("select 3");
+    executor.sync();
+    auto h4 = executor.execute("select 4");
+    executor.finish();
+    ASSERT(!h1.exception());
+    ASSERT(h2.exception());
+    try {
+      h2.completion();
+      ASSERT(false);
+    } catch (const pgfe::Server_exception& e) {
+      ASSERT(e.error().condition() == pgfe::Server_errc::c42_syntax_error);
+    }
+    try {
+      h3.completion();
+      ASSERT(false);
+    } catch (const pgfe::Client_exception& e) {
+      ASSERT(e.condition() == Client_errc::pipeline_aborted);
+    }
+    ASSERT(!h4.exception());
+    ASSERT(to<int>(h4.rows()[0][0]) == 4);
+  }
+
+  /*
+   * Test case 4. Time-based sync.
+   */
+  {
+    executor.set_sync_count(1000000);
+    executor.set_sync_interval(std::chrono::microseconds{0});
+    auto handle = executor.execute("select 1");
+    executor.poll();
+    ASSERT(handle.completion().tag() == "SELECT");
+  }
+
+  /*
+   * Test case 5. Statement vector with shared arguments.
+   */
+  {
+    using pgfe::a;
+    using pgfe::Pipeline_error_policy;
+    const pgfe::Statement_vector bundle{std::string_view{
+      "select :x::integer;"
+      "-- just a comment\n;"
+      "select :x::integer + :y::integer;"
+      "select :y::integer"}};
+    std::vector<std::size_t> completed;
+    auto handles = executor.execute(bundle,
+      [&completed](const std::size_t index, auto& handle)
+      {
+        ASSERT(handle.is_ready());
+        completed.push_back(index);
+      }, a{"x", 1}, a{"y", 2});
+    ASSERT(handles.size() == 4);
+    ASSERT(!handles[1]);
+    ASSERT((completed == std::vector<std::size_t>{0, 2, 3}));
+    ASSERT(to<int>(handles[0].rows()[0][0]) == 1);
+    ASSERT(to<int>(handles[2].rows()[0][0]) == 3);
+    ASSERT(to<int>(handles[3].rows()[0][0]) == 2);
+
+    // Arguments known at runtime only.
+    std::vector<pgfe::Named_argument> args;
+    args.emplace_back("x", 3);
+    args.emplace_back("y", 4);
+    handles = executor.execute(bundle, {}, args);
+    ASSERT(to<int>(handles[2].rows()[0][0]) == 7);
+
+    // Stop on the first error.
+    const pgfe::Statement_vector failing{std::string_view{
+      "select 1; syntax error; select 3"}};
+    completed.clear();
+    try {
+      executor.execute(failing, [&completed](const std::size_t index, auto&)
+      {
+        completed.push_back(index);
+      });
+      ASSERT(false);
+    } catch (const pgfe::Server_exception& e) {
+      ASSERT(e.error().condition() == pgfe::Server_errc::c42_syntax_error);
+    }
+    ASSERT((completed == std::vector<std::size_t>{0}));
+
+    // Isolated errors.
+    completed.clear();
+    handles = executor.execute<Pipeline_error_policy::isolate>(failing,
+      [&completed](const std::size_t index, auto&)
+      {
+        completed.push_back(index);
+      });
+    ASSERT((completed == std::vector<std::size_t>{0, 1, 2}));
+    ASSERT(handles[1].exception());
+    ASSERT(to<int>(handles[2].rows()[0][0]) == 3);
+    ASSERT(!executor.unprocessed_count());
+  }
+} catch (const std::exception& e) {
+  std::cerr << e.what() << std::endl;
+  return 1;
+} catch (...) {
+  std::cerr << "unknown error" << std::endl;
+  return 2;
+}
@@ -0,0 +1,90 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pgfe-unit.hpp"
+
+#include <string>
+
+#define ASSERT DMITIGR_ASSERT
+
+int main()
+try {
+  namespace pgfe = dmitigr::pgfe;
+  using pgfe::Pipelined_large_object;
+  using pgfe::to;
+
+  // Prepare.
+  auto conn = pgfe::test::make_connection();
+  conn->connect();
+  const auto oid = conn->create_large_object();
+  ASSERT(oid != pgfe::invalid_oid);
+  std::string content;
+  for (int i{}; content.size() < 1000000; ++i)
+    content.append(std::to_string(i)).append(" ");
+
+  {
+    pgfe::Pipeline_executor executor{*conn};
+    executor.execute("begin");
+    Pipelined_large_object lob{executor, oid,
+      pgfe::Large_object_open_mode::writing |
+      pgfe::Large_object_open_mode::reading};
+    ASSERT(lob.descriptor() >= 0);
+    ASSERT(&lob.executor() == &executor);
+
+    // Test write.
+    lob.write_all(content, 65536);
+    auto pos = lob.seek(0, pgfe::Large_object_seek_whence::current);
+    ASSERT(Pipelined_large_object::position(pos) ==
+      static_cast<std::int64_t>(content.size()));
+
+    // Test single operations.
+    auto seek = lob.seek(0, pgfe::Large_object_seek_whence::begin);
+    auto read = lob.read(5);
+    auto write = lob.write("abc");
+    ASSERT(Pipelined_large_object::position(seek) == 0);
+    ASSERT(Pipelined_large_object::data(read).size() == 5);
+    ASSERT(std::string_view(static_cast<const char*>(
+          Pipelined_large_object::data(read).bytes()), 5) ==
+      content.substr(0, 5));
+    ASSERT(Pipelined_large_object::written_size(write) == 3);
+    content.replace(5, 3, "abc");
+
+    // Test read.
+    lob.seek(0, pgfe::Large_object_seek_whence::begin);
+    std::string result;
+    const auto size = lob.read_all([&result](const pgfe::Data_view data)
+    {
+      ASSERT(data.format() == pgfe::Data_format::binary);
+      result.append(static_cast<const char*>(data.bytes()), data.size());
+    }, 10000, 4);
+    ASSERT(size == content.size());
+    ASSERT(result == content);
+
+    // Test close.
+    lob.close();
+    ASSERT(lob.descriptor() == -1);
+    executor.execute("commit");
+    executor.finish();
+  }
+  conn->set_pipeline_enabled(false);
+  conn->remove_large_object(oid);
+} catch (const std::exception& e) {
+  std::cerr << e.what() << std::endl;
+  return 1;
+} catch (...) {
+  std::cerr << "unknown error" << std::endl;
+  return 2;
+}
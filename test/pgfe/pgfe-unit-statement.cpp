@@ -21,7 +21,34 @@
 #include "../../src/pgfe/statement.hpp"
 #include "pgfe-unit.hpp"
 
+#include <algorithm>
+#include <cstdlib>
 #include <functional>
+#include <new>
+
+namespace {
+bool is_allocation_tracked;
+std::size_t max_allocation_size;
+} // namespace
+
+void* operator new(const std::size_t size)
+{
+  if (is_allocation_tracked)
+    max_allocation_size = std::max(max_allocation_size, size);
+  if (const auto result = std::malloc(size ? size : 1))
+    return result;
+  throw std::bad_alloc{};
+}
+
+void operator delete(void* const ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void* const ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
 
 int main()
 {
@@ -70,6 +97,25 @@ int main()
       std::cout << st.to_string() << std::endl;
     }
 
+    // Neither the text nor the fragments of the replaced parameters accumulate.
+    {
+      pgfe::Statement st{"SELECT :a FROM t"};
+      is_allocation_tracked = true;
+      for (int i{}; i < 10000; ++i) {
+        st.replace_parameter("a", ":b");
+        st.replace_parameter("b", ":a");
+      }
+      pgfe::Statement st_copy{st};
+      pgfe::Statement st_appended{"SELECT 1 UNION "};
+      st_appended.append(st);
+      is_allocation_tracked = false;
+      DMITIGR_ASSERT(max_allocation_size < 1024);
+      DMITIGR_ASSERT(st.to_string() == "SELECT :a FROM t");
+      DMITIGR_ASSERT(st_copy.to_string() == st.to_string());
+      DMITIGR_ASSERT(st_appended.to_string() == "SELECT 1 UNION SELECT :a FROM t");
+      DMITIGR_ASSERT(st_appended.parameter_index("a") == 0);
+    }
+
     {
       pgfe::Statement st{R"(SELECT :num, :num, :'txt', :'txt' FROM :"tab", :"tab")"};
       DMITIGR_ASSERT(!st.is_empty());
@@ -107,6 +153,50 @@ int main()
       std::cout << st.to_query_string(*conn) << std::endl;
     }
 
+    // Compiled form.
+    {
+      const auto conn = pgfe::test::make_connection();
+      conn->connect();
+
+      pgfe::Statement st{"SELECT :a, :b, :a -- comment"};
+      const auto compiled = st.compiled(*conn);
+      DMITIGR_ASSERT(compiled->query == "SELECT $1, $2, $1 ");
+      DMITIGR_ASSERT(compiled->named_parameters.size() == 2);
+      DMITIGR_ASSERT(st.compiled(*conn) == compiled);
+      DMITIGR_ASSERT(st.to_query_string(*conn) == compiled->query);
+      const auto hash = compiled->hash;
+      DMITIGR_ASSERT(pgfe::Statement{"SELECT :a, :b, :a /* other */"}
+        .compiled(*conn)->hash == hash);
+
+      st.bind("a", "1");
+      DMITIGR_ASSERT(st.compiled(*conn)->query == "SELECT 1, $1, 1 ");
+      DMITIGR_ASSERT(st.compiled(*conn)->named_parameters.size() == 1);
+      DMITIGR_ASSERT(st.compiled(*conn)->named_parameters[0] == 1);
+      DMITIGR_ASSERT(st.compiled(*conn)->hash != hash);
+      DMITIGR_ASSERT(!st.compiled(*conn)->is_simple);
+      DMITIGR_ASSERT(pgfe::Statement{"SELECT 1"}.compiled(*conn)->is_simple);
+      DMITIGR_ASSERT(!pgfe::Statement{"SELECT $1"}.compiled(*conn)->is_simple);
+      DMITIGR_ASSERT(!pgfe::Statement{"SELECT :a"}.bind("a", "1")
+        .compiled(*conn)->is_simple);
+      DMITIGR_ASSERT(pgfe::Statement{"SAVEPOINT :\"s\""}.bind("s", "p")
+        .compiled(*conn)->is_simple);
+
+      // The connection dependent compiled form is not cached.
+      pgfe::Statement lit{"SELECT :'v'"};
+      lit.bind("v", "x");
+      const auto lit_compiled = lit.compiled(*conn);
+      DMITIGR_ASSERT(lit_compiled->query == "SELECT 'x'");
+      DMITIGR_ASSERT(lit.compiled(*conn) != lit_compiled);
+
+      for (int i{}; i < 3; ++i) {
+        conn->execute([i](auto&& row)
+        {
+          DMITIGR_ASSERT(pgfe::to<int>(row[0]) == 1);
+          DMITIGR_ASSERT(pgfe::to<int>(row[1]) == i);
+        }, st, i);
+      }
+    }
+
     {
       pgfe::Statement s_orig{
         "-- Id: complex\n"
@@ -64,6 +64,96 @@ try {
   DMITIGR_ASSERT(bunch[1].extra().field_index("id") == 0);
   DMITIGR_ASSERT(bunch[1].extra().field_index("cond") == 1);
 
+  // -------------------------------------------------------------------------
+  // Index
+  // -------------------------------------------------------------------------
+
+  bunch.index_by("id");
+  DMITIGR_ASSERT(bunch.indexed_extra_name() == "id");
+  DMITIGR_ASSERT(&bunch.statement("plus_one") == &bunch[0]);
+  DMITIGR_ASSERT(&bunch.statement("digit") == &bunch[1]);
+  DMITIGR_ASSERT(bunch.statement_index("id", "digit") == 1);
+  DMITIGR_ASSERT(bunch.statement_index("id", "none") == bunch.size());
+  {
+    pgfe::Statement_vector v{std::string_view{
+      "-- $id$a$id$\nSELECT 1;"
+      "-- $id$b$id$\nSELECT 2;"
+      "-- $id$a$id$\nSELECT 3"}};
+    v.index_by("id");
+    DMITIGR_ASSERT(v.statement_index("id", "a") == 0);
+    DMITIGR_ASSERT(v.statement_index("id", "b") == 1);
+    v.insert(0, "-- $id$c$id$\nSELECT 0");
+    DMITIGR_ASSERT(v.statement_index("id", "c") == 0);
+    DMITIGR_ASSERT(v.statement_index("id", "a") == 1);
+    DMITIGR_ASSERT(v.statement_index("id", "b") == 2);
+    v.remove(1);
+    DMITIGR_ASSERT(v.statement_index("id", "b") == 1);
+    DMITIGR_ASSERT(v.statement_index("id", "a") == 2);
+    DMITIGR_ASSERT(v.statement("a").to_string() == "-- $id$a$id$\nSELECT 3");
+    v.append("-- $id$d$id$\nSELECT 4");
+    DMITIGR_ASSERT(v.statement_index("id", "d") == 3);
+    v.drop_index();
+    DMITIGR_ASSERT(v.indexed_extra_name().empty());
+    DMITIGR_ASSERT(v.statement_index("id", "d") == 3);
+  }
+
+  // -------------------------------------------------------------------------
+  // Parallel parsing
+  // -------------------------------------------------------------------------
+
+  {
+    const auto is_equal = [](const pgfe::Statement_vector& lhs,
+      const pgfe::Statement_vector& rhs)
+    {
+      if (lhs.size() != rhs.size())
+        return false;
+      for (std::size_t i{}; i < lhs.size(); ++i) {
+        if (lhs[i].to_string() != rhs[i].to_string() ||
+          lhs[i].positional_parameter_count() !=
+          rhs[i].positional_parameter_count() ||
+          lhs[i].named_parameter_count() != rhs[i].named_parameter_count() ||
+          lhs[i].extra().field_count() != rhs[i].extra().field_count())
+          return false;
+      }
+      return true;
+    };
+
+    std::string large;
+    for (int i{}; i < 2000; ++i) {
+      large.append("-- $id$q").append(std::to_string(i)).append("$id$\n")
+        .append("SELECT :a, $1, 'x;''y', \"i;d\", a[1:2][b[c;]]")
+        .append(" /* c; /* nested; */ */ $f$;$$;$g$;$f$ $;; $$;$$;")
+        .append("-- tail; comment\nSELECT 1/2 ; /;");
+    }
+    const pgfe::Statement_vector serial{large};
+    for (const std::size_t thread_count : {0, 1, 2, 3, 8}) {
+      const pgfe::Statement_vector parallel{large, thread_count};
+      DMITIGR_ASSERT(is_equal(serial, parallel));
+    }
+
+    // Errors are the same as of serial parsing.
+    std::string serial_error;
+    std::string parallel_error;
+    large.append("SELECT $t-$;");
+    try {
+      pgfe::Statement_vector{large};
+    } catch (const pgfe::Client_exception& e) {
+      serial_error = e.what();
+    }
+    try {
+      pgfe::Statement_vector{large, 4};
+    } catch (const pgfe::Client_exception& e) {
+      parallel_error = e.what();
+    }
+    DMITIGR_ASSERT(!serial_error.empty());
+    DMITIGR_ASSERT(serial_error == parallel_error);
+
+    // Loading the file.
+    const auto loaded = pgfe::Statement_vector::load(this_exe_dir_name /
+      "pgfe-unit-statement_vector.sql");
+    DMITIGR_ASSERT(is_equal(loaded, pgfe::Statement_vector{input}));
+  }
+
   auto& digit = bunch[1];
   const auto& plus_one = bunch[0];
   const auto conn = pgfe::test::make_connection();
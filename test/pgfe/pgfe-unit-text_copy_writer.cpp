@@ -0,0 +1,178 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pgfe-unit.hpp"
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#define ASSERT DMITIGR_ASSERT
+
+/// A type which cannot be converted to Data.
+struct Unconvertible final {};
+
+namespace dmitigr::pgfe {
+
+template<> struct Conversions<Unconvertible> final {
+  static std::unique_ptr<Data> to_data(const Unconvertible&)
+  {
+    throw Client_exception{"cannot convert Unconvertible to data"};
+  }
+};
+
+} // namespace dmitigr::pgfe
+
+int main()
+try {
+  namespace pgfe = dmitigr::pgfe;
+  namespace detail = pgfe::detail;
+  using pgfe::to;
+
+  // Test find_any_of() on the boundaries of vectorized scanning.
+  for (std::size_t size{}; size < 100; ++size) {
+    const std::string str(size, 'a');
+    ASSERT(detail::find_any_of(str.data(), str.data() + size,
+        '\\', '\n', '\r', '\t') == str.data() + size);
+    for (std::size_t pos{}; pos < size; ++pos) {
+      std::string s{str};
+      s[pos] = '\r';
+      if (pos + 1 < size)
+        s[pos + 1] = '\n';
+      ASSERT(detail::find_any_of(s.data(), s.data() + size,
+          '\\', '\n', '\r', '\t') == s.data() + pos);
+    }
+  }
+
+  // Test text escaping.
+  {
+    std::string buf;
+    detail::append_copy_text_field(buf, "plain", '\t');
+    ASSERT(buf == "plain");
+    buf.clear();
+    detail::append_copy_text_field(buf, "a\\b\tc\nd\re|", '\t');
+    ASSERT(buf == "a\\\\b\\tc\\nd\\re|");
+    buf.clear();
+    detail::append_copy_text_field(buf, "a|b\tc", '|');
+    ASSERT(buf == "a\\|b\tc");
+    buf.clear();
+    const std::string long_str(1000, 'x');
+    detail::append_copy_text_field(buf, long_str + "\n" + long_str, '\t');
+    ASSERT(buf == long_str + "\\n" + long_str);
+  }
+
+  // Test CSV quoting.
+  {
+    std::string buf;
+    detail::append_copy_csv_field(buf, "plain", ',', '"', false);
+    ASSERT(buf == "plain");
+    buf.clear();
+    detail::append_copy_csv_field(buf, "", ',', '"', false);
+    ASSERT(buf == "\"\"");
+    buf.clear();
+    detail::append_copy_csv_field(buf, "a,b", ',', '"', false);
+    ASSERT(buf == "\"a,b\"");
+    buf.clear();
+    detail::append_copy_csv_field(buf, "say \"hi\"", ',', '"', false);
+    ASSERT(buf == "\"say \"\"hi\"\"\"");
+    buf.clear();
+    detail::append_copy_csv_field(buf, "NULL", ',', '"', true);
+    ASSERT(buf == "\"NULL\"");
+  }
+
+  // Prepare.
+  auto conn = pgfe::test::make_connection();
+  conn->connect();
+  conn->execute("create temp table item(id integer not null, name text,"
+    " price float8, ok boolean)");
+  const std::string tricky{"tab\there, new\nline, back\\slash, \"quoted\""};
+
+  for (const auto format : {pgfe::Copy_text_format::text,
+        pgfe::Copy_text_format::csv}) {
+    conn->execute("truncate item");
+
+    // Test write.
+    conn->execute(format == pgfe::Copy_text_format::text ?
+      "copy item from stdin" : "copy item from stdin (format csv)");
+    {
+      auto copier = conn->copier();
+      ASSERT(copier);
+      pgfe::Text_copy_writer writer{copier, format, 16};
+      ASSERT(writer.format() == format);
+      writer.write(1, tricky, 1.5, true);
+      writer.write(2, std::string{}, std::nullopt, false);
+      writer.write(std::make_pair(3, std::optional<std::string>{}), 3.25,
+        std::optional<bool>{true});
+      writer.write_range(std::vector<std::string>{"4", "\\N", "4.5", "t"});
+      writer.finish();
+      ASSERT(!copier);
+    }
+    conn->wait_response_throw();
+    ASSERT(conn->completion().row_count() == 4);
+
+    // Test read back.
+    int count{};
+    conn->execute([&](auto&& row)
+    {
+      const auto id = to<int>(row["id"]);
+      ASSERT(id == ++count);
+      if (id == 1) {
+        ASSERT(to<std::string>(row["name"]) == tricky);
+        ASSERT(to<double>(row["price"]) == 1.5);
+      } else if (id == 2) {
+        ASSERT(to<std::string>(row["name"]).empty());
+        ASSERT(!row["price"]);
+        ASSERT(!to<bool>(row["ok"]));
+      } else if (id == 3) {
+        ASSERT(!row["name"]);
+        ASSERT(to<double>(row["price"]) == 3.25);
+      } else if (id == 4)
+        ASSERT(to<std::string>(row["name"]) == "\\N"); // not NULL
+    }, "select * from item order by id");
+    ASSERT(count == 4);
+  }
+
+  // Test that the tuple which cannot be converted is not written.
+  conn->execute("truncate item");
+  conn->execute("copy item from stdin");
+  {
+    auto copier = conn->copier();
+    pgfe::Text_copy_writer writer{copier};
+    writer.write(1, "one", 1.5, true);
+    const auto size = writer.buffered_size();
+    try {
+      writer.write(2, "two", Unconvertible{}, false);
+      ASSERT(false);
+    } catch (const pgfe::Client_exception&) {}
+    ASSERT(writer.buffered_size() == size);
+    writer.write(3, "three", 3.5, true);
+    writer.finish();
+  }
+  conn->wait_response_throw();
+  ASSERT(conn->completion().row_count() == 2);
+  conn->execute([](auto&& row)
+  {
+    ASSERT(to<std::string>(row["name"]) == "three");
+    ASSERT(to<double>(row["price"]) == 3.5);
+  }, "select * from item where id = 3");
+} catch (const std::exception& e) {
+  std::cerr << e.what() << std::endl;
+  return 1;
+} catch (...) {
+  std::cerr << "unknown error" << std::endl;
+  return 2;
+}
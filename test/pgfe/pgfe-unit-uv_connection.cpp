@@ -0,0 +1,131 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests the libuv adapter against the in-process fake server.
+// Requires no PostgreSQL server.
+
+#include "pgfe-unit-fake_server.hpp"
+#include "../../src/pgfe/uv_connection.hpp"
+
+#define ASSERT DMITIGR_ASSERT
+
+int main()
+try {
+  namespace pgfe = dmitigr::pgfe;
+  using pgfe::Completion;
+  using pgfe::Error;
+  using pgfe::Row;
+  using pgfe::to;
+  using pgfe::test::Fake_response;
+  using Params = pgfe::test::Fake_server::Params;
+
+  pgfe::test::Fake_server server{[](const std::string_view query,
+    const Params& params) -> std::optional<Fake_response>
+  {
+    if (query == "select $1")
+      return Fake_response::select({"v"}, {{params[0]}});
+    return std::nullopt;
+  }};
+  server.set_response("select 1", Fake_response::select({"n"}, {{"1"}}));
+  server.set_response("select boom",
+    Fake_response::error("42P01", "relation \"boom\" does not exist"));
+
+  uv_loop_t loop;
+  ASSERT(!uv_loop_init(&loop));
+
+  {
+    pgfe::Connection conn{server.connection_options()};
+    pgfe::Uv_connection uv_conn{&loop, conn};
+    std::exception_ptr failure;
+    uv_conn.set_failure_handler([&failure](std::exception_ptr e)
+    {
+      failure = std::move(e);
+    });
+
+    bool is_connected{};
+    int n{};
+    std::string v;
+    std::vector<std::string> tags;
+    std::string error_code;
+    std::string notification;
+    conn.set_notification_handler([&](pgfe::Notification&& n)
+    {
+      notification.assign(n.channel_name()).append(":")
+        .append(to<std::string_view>(n.payload()));
+      uv_conn.close(); // the loop exits as there are no more active handles
+    });
+    uv_conn.connect([&]
+    {
+      is_connected = true;
+      ASSERT(conn.is_connected());
+      ASSERT(uv_conn.is_polling());
+
+      uv_conn.execute([&n](Row&& row)
+      {
+        n = to<int>(row[0]);
+      }, [&tags](Completion&& comp, Error&& err)
+      {
+        ASSERT(comp && !err);
+        tags.push_back(comp.tag());
+      }, "select 1");
+
+      uv_conn.execute([&v](Row&& row)
+      {
+        v = to<std::string>(row[0]);
+      }, [&tags](Completion&& comp, Error&& err)
+      {
+        ASSERT(comp && !err);
+        tags.push_back(comp.tag());
+      }, "select $1", "value");
+
+      uv_conn.execute(nullptr, [&](Completion&& comp, Error&& err)
+      {
+        ASSERT(!comp && err);
+        error_code = err.sqlstate();
+      }, "select boom");
+
+      // The notification is delivered when no request is in flight.
+      uv_conn.execute(nullptr, [&](Completion&& comp, Error&& err)
+      {
+        ASSERT(comp && !err);
+        tags.push_back(comp.tag());
+        server.notify("chan", "payload");
+      }, "listen chan");
+      ASSERT(uv_conn.request_count() == 4);
+    });
+    uv_run(&loop, UV_RUN_DEFAULT);
+    if (failure)
+      std::rethrow_exception(failure);
+
+    ASSERT(is_connected);
+    ASSERT(n == 1);
+    ASSERT(v == "value");
+    ASSERT(tags == std::vector<std::string>({"SELECT", "SELECT", "LISTEN"}));
+    ASSERT(error_code == "42P01");
+    ASSERT(notification == "chan:payload");
+    ASSERT(!uv_conn.is_polling());
+    ASSERT(!uv_conn.request_count());
+    ASSERT(conn.is_connected());
+  }
+
+  ASSERT(!uv_loop_close(&loop));
+} catch (const std::exception& e) {
+  std::cerr << e.what() << std::endl;
+  return 1;
+} catch (...) {
+  std::cerr << "unknown error" << std::endl;
+  return 2;
+}
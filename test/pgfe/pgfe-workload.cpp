@@ -0,0 +1,436 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+// Usage: dmitigr_pgfe-workload [options] script.sql
+//
+// A load generator which runs the weighted transactions of the script from
+// the threads over the connections of Connection_pool.
+//
+// The script is loaded by Statement_vector::load(). Each transaction begins
+// with the statement which extra data has the field `tx` with the name of the
+// transaction, and consists of this statement and the statements which
+// follow it up to the next transaction. The extra data of the statements of
+// the transaction can contain:
+//   - the field `weight` with the relative frequency of the transaction
+//   (defaults to 1);
+//   - the field named by each named parameter of the statements with the
+//   range "min max" of the uniformly distributed random integers bound to the
+//   parameter upon each execution of the transaction.
+//
+// Example:
+//
+//   -- $tx$transfer$tx$
+//   -- $weight$3$weight$
+//   -- $from$1 100000$from$
+//   -- $to$1 100000$to$
+//   begin;
+//   update account set balance = balance - 1 where id = :from;
+//   update account set balance = balance + 1 where id = :to;
+//   commit;
+//
+// Options:
+//   --threads=M         the number of threads (defaults to 1)
+//   --connections=N     the size of the connection pool (defaults to M)
+//   --time=S            the duration in seconds (defaults to 10)
+//   --transactions=T    the number of transactions per thread (overrides --time)
+//   --rate=R            the target total rate in transactions per second
+//                       (the arrivals are Poisson distributed)
+//   --pipeline          send the statements of each transaction in a pipeline
+//                       rather than one by one
+//   --host=H, --hostaddr=A, --port=P, --dbname=D, --user=U, --password=W
+//                       override the connection options of the tests
+
+#include "pgfe-unit.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <iomanip>
+#include <map>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace pgfe = dmitigr::pgfe;
+namespace util = dmitigr::util;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// -----------------------------------------------------------------------------
+// Options
+// -----------------------------------------------------------------------------
+
+struct Options final {
+  std::filesystem::path script;
+  std::size_t thread_count{1};
+  std::size_t connection_count{};
+  std::chrono::duration<double> duration{10};
+  std::size_t transaction_count{}; // per thread, 0 means unlimited
+  double rate{}; // 0 means unlimited
+  bool is_pipeline{};
+  pgfe::Connection_options connection_options{pgfe::test::connection_options()};
+};
+
+Options parse_options(const int argc, char* const argv[])
+{
+  Options result;
+  for (int i{1}; i < argc; ++i) {
+    const std::string_view arg{argv[i]};
+    const auto eq = arg.find('=');
+    const auto name = arg.substr(0, eq);
+    const std::string value{eq != std::string_view::npos ?
+      arg.substr(eq + 1) : std::string_view{}};
+    auto& co = result.connection_options;
+    if (name == "--threads")
+      result.thread_count = std::stoul(value);
+    else if (name == "--connections")
+      result.connection_count = std::stoul(value);
+    else if (name == "--time")
+      result.duration = std::chrono::duration<double>{std::stod(value)};
+    else if (name == "--transactions")
+      result.transaction_count = std::stoul(value);
+    else if (name == "--rate")
+      result.rate = std::stod(value);
+    else if (name == "--pipeline")
+      result.is_pipeline = true;
+    else if (name == "--host")
+      co.set_hostname(value).set_address(std::nullopt);
+    else if (name == "--hostaddr")
+      co.set_address(value);
+    else if (name == "--port")
+      co.set_port(std::stoi(value));
+    else if (name == "--dbname")
+      co.set_database(value);
+    else if (name == "--user")
+      co.set_username(value);
+    else if (name == "--password")
+      co.set_password(value);
+    else if (!name.empty() && name[0] != '-' && result.script.empty())
+      result.script = std::string{arg};
+    else
+      throw std::runtime_error{"unknown option " + std::string{arg}};
+  }
+  if (result.script.empty())
+    throw std::runtime_error{"no script specified"};
+  else if (!result.thread_count || result.duration.count() <= 0 ||
+    result.rate < 0)
+    throw std::runtime_error{"invalid options"};
+  if (!result.connection_count)
+    result.connection_count = result.thread_count;
+  return result;
+}
+
+// -----------------------------------------------------------------------------
+// Script
+// -----------------------------------------------------------------------------
+
+struct Transaction final {
+  /// The range of the random values of a named parameter.
+  struct Range final {
+    std::string name;
+    std::uniform_int_distribution<long long> distribution;
+  };
+
+  std::string name;
+  double weight{1};
+  pgfe::Statement_vector statements;
+  std::vector<pgfe::Statement_vector> singles; // for the one by one execution
+  std::vector<Range> ranges;
+};
+
+std::vector<Transaction> load_script(const std::filesystem::path& path)
+{
+  std::vector<Transaction> result;
+  std::vector<std::map<std::string, std::string, std::less<>>> extras;
+  auto script = pgfe::Statement_vector::load(path);
+  for (auto& statement : script.vector()) {
+    if (statement.is_query_empty())
+      continue;
+
+    const auto& extra = statement.extra();
+    if (const auto i = extra.field_index("tx"); i < extra.field_count()) {
+      result.emplace_back().name = pgfe::to<std::string>(extra.data(i));
+      extras.emplace_back();
+    } else if (result.empty())
+      throw std::runtime_error{"statement outside of transaction: "
+        + statement.to_string()};
+
+    for (std::size_t i{}; i < extra.field_count(); ++i)
+      extras.back()[std::string{extra.field_name(i)}] =
+        pgfe::to<std::string>(extra.data(i));
+    result.back().singles.emplace_back(std::vector<pgfe::Statement>{statement});
+    result.back().statements.append(std::move(statement));
+  }
+  if (result.empty())
+    throw std::runtime_error{"no transactions in " + path.string()};
+
+  for (std::size_t i{}; i < result.size(); ++i) {
+    auto& tx = result[i];
+    const auto& extra = extras[i];
+    if (const auto w = extra.find("weight"); w != extra.end()) {
+      tx.weight = std::stod(w->second);
+      if (!(tx.weight > 0))
+        throw std::runtime_error{"invalid weight of transaction " + tx.name};
+    }
+    for (const auto& statement : tx.statements.vector()) {
+      for (auto j = statement.positional_parameter_count();
+           j < statement.parameter_count(); ++j) {
+        const auto name = statement.parameter_name(j);
+        if (std::any_of(tx.ranges.begin(), tx.ranges.end(),
+            [name](const auto& r){return r.name == name;}))
+          continue;
+
+        const auto r = extra.find(name);
+        if (r == extra.end())
+          throw std::runtime_error{"no range of parameter " + std::string{name}
+            + " of transaction " + tx.name};
+        std::istringstream s{r->second};
+        long long min{};
+        long long max{};
+        if (!(s >> min >> max) || min > max)
+          throw std::runtime_error{"invalid range of parameter "
+            + std::string{name} + " of transaction " + tx.name};
+        tx.ranges.push_back({std::string{name},
+          std::uniform_int_distribution<long long>{min, max}});
+      }
+    }
+  }
+  return result;
+}
+
+// -----------------------------------------------------------------------------
+// Load
+// -----------------------------------------------------------------------------
+
+/// The statistics of a worker thread.
+struct Worker_stats final {
+  std::vector<double> latencies; // in microseconds
+  std::vector<std::size_t> counts; // per transaction
+  std::vector<std::size_t> failures; // per transaction
+  std::vector<double> latency_sums; // per transaction
+  std::chrono::duration<double> lag{};
+};
+
+/**
+ * @returns `false` if the transaction is failed with Server_exception.
+ *
+ * @throws Any other exception.
+ */
+bool run(pgfe::Connection& conn, const Transaction& tx,
+  const std::vector<pgfe::Named_argument>& args, const bool is_pipeline)
+{
+  bool result{true};
+  {
+    pgfe::Pipeline_executor executor{conn};
+    try {
+      if (is_pipeline)
+        executor.execute(tx.statements, {}, args);
+      else {
+        for (const auto& single : tx.singles)
+          executor.execute(single, {}, args);
+      }
+    } catch (const pgfe::Server_exception&) {
+      result = false;
+    }
+  }
+  conn.set_pipeline_enabled(false);
+  if (conn.transaction_status() != pgfe::Transaction_status::unstarted)
+    conn.execute("rollback");
+  return result;
+}
+
+void work(pgfe::Connection_pool& pool, std::vector<Transaction> txs,
+  const Options& opts, Worker_stats& stat, const std::atomic_bool& is_stopped,
+  const Clock::time_point started, const unsigned seed)
+{
+  std::mt19937_64 rng{seed};
+  std::vector<double> weights;
+  for (const auto& tx : txs)
+    weights.push_back(tx.weight);
+  std::discrete_distribution<std::size_t> pick{weights.begin(), weights.end()};
+  std::optional<std::exponential_distribution<double>> arrival;
+  if (opts.rate > 0)
+    arrival.emplace(opts.rate / opts.thread_count);
+  stat.counts.resize(txs.size());
+  stat.failures.resize(txs.size());
+  stat.latency_sums.resize(txs.size());
+
+  std::vector<pgfe::Named_argument> args;
+  auto scheduled = started;
+  for (std::size_t n{}; !is_stopped &&
+         (!opts.transaction_count || n < opts.transaction_count); ++n) {
+    if (arrival) {
+      scheduled += std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>{(*arrival)(rng)});
+      std::this_thread::sleep_until(scheduled);
+      stat.lag += Clock::now() - scheduled;
+    }
+
+    const auto index = pick(rng);
+    auto& tx = txs[index];
+    args.clear();
+    for (auto& range : tx.ranges)
+      args.emplace_back(range.name, range.distribution(rng));
+
+    const auto tx_started = Clock::now();
+    auto handle = pool.connection();
+    while (!handle) {
+      std::this_thread::yield();
+      handle = pool.connection();
+    }
+    const bool is_ok = run(*handle, tx, args, opts.is_pipeline);
+    handle.release();
+    const std::chrono::duration<double, std::micro> latency{
+      Clock::now() - tx_started};
+
+    stat.latencies.push_back(latency.count());
+    ++stat.counts[index];
+    stat.latency_sums[index] += latency.count();
+    if (!is_ok)
+      ++stat.failures[index];
+  }
+}
+
+void print_histogram(const util::Benchmark_result& latency)
+{
+  // Bucket k holds the latencies in [2^k, 2^(k+1)) microseconds.
+  std::vector<std::size_t> buckets;
+  for (const auto l : latency.samples) {
+    const auto k = l < 1 ? 0 : static_cast<std::size_t>(std::log2(l));
+    if (k >= buckets.size())
+      buckets.resize(k + 1);
+    ++buckets[k];
+  }
+  const auto total = latency.samples.size();
+  const auto peak = *std::max_element(buckets.begin(), buckets.end());
+  std::cout << "latency histogram:" << std::endl;
+  for (std::size_t k{}; k < buckets.size(); ++k) {
+    if (!buckets[k])
+      continue;
+    std::cout << "  < " << std::setw(10) << (std::size_t{2} << k) << " us "
+              << std::setw(10) << buckets[k]
+              << std::setw(8) << std::fixed << std::setprecision(2)
+              << 100. * buckets[k] / total << "% "
+              << std::string(50 * buckets[k] / peak, '#') << std::endl;
+  }
+}
+
+} // namespace
+
+int main(const int argc, char* const argv[])
+try {
+  const auto opts = parse_options(argc, argv);
+  const auto txs = load_script(opts.script);
+
+  pgfe::Connection_pool pool{opts.connection_count, opts.connection_options};
+  pool.connect();
+
+  std::vector<Worker_stats> stats(opts.thread_count);
+  std::atomic_bool is_stopped{};
+  std::atomic_bool is_failed{};
+  std::vector<std::thread> threads;
+  threads.reserve(opts.thread_count);
+  const auto started = Clock::now();
+  std::random_device seeds;
+  for (auto& stat : stats) {
+    threads.emplace_back([&, seed = seeds()]
+    {
+      try {
+        work(pool, txs, opts, stat, is_stopped, started, seed);
+      } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        is_failed = true;
+        is_stopped = true;
+      }
+    });
+  }
+  if (!opts.transaction_count) {
+    const auto deadline = started +
+      std::chrono::duration_cast<Clock::duration>(opts.duration);
+    while (!is_stopped && Clock::now() < deadline)
+      std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    is_stopped = true;
+  }
+  for (auto& thread : threads)
+    thread.join();
+  const std::chrono::duration<double> elapsed{Clock::now() - started};
+  if (is_failed)
+    return 1;
+
+  // Merge the statistics.
+  util::Benchmark_result latency;
+  std::vector<std::size_t> counts(txs.size());
+  std::vector<std::size_t> failures(txs.size());
+  std::vector<double> latency_sums(txs.size());
+  std::chrono::duration<double> lag{};
+  for (const auto& s : stats) {
+    latency.samples.insert(latency.samples.end(),
+      s.latencies.begin(), s.latencies.end());
+    for (std::size_t i{}; i < txs.size(); ++i) {
+      counts[i] += s.counts[i];
+      failures[i] += s.failures[i];
+      latency_sums[i] += s.latency_sums[i];
+    }
+    lag += s.lag;
+  }
+  if (latency.samples.empty())
+    throw std::runtime_error{"no transactions executed"};
+  std::sort(latency.samples.begin(), latency.samples.end());
+
+  const auto total = latency.samples.size();
+  std::size_t failed{};
+  for (const auto f : failures)
+    failed += f;
+  std::cout << std::fixed << std::setprecision(3)
+            << "threads: " << opts.thread_count
+            << ", connections: " << opts.connection_count
+            << ", pipeline: " << (opts.is_pipeline ? "on" : "off") << '\n'
+            << "transactions: " << total << " (" << failed << " failed) in "
+            << elapsed.count() << " s\n"
+            << "throughput: " << total / elapsed.count() << " tps\n"
+            << "latency (ms): mean " << latency.mean() / 1000
+            << ", p50 " << latency.median() / 1000
+            << ", p90 " << latency.percentile(.9) / 1000
+            << ", p99 " << latency.percentile(.99) / 1000
+            << ", max " << latency.max() / 1000 << '\n';
+  if (opts.rate > 0)
+    std::cout << "schedule lag (ms): mean "
+              << lag.count() * 1000 / total << '\n';
+  std::cout << "per transaction:" << std::endl;
+  for (std::size_t i{}; i < txs.size(); ++i)
+    std::cout << "  " << std::left << std::setw(24) << txs[i].name << std::right
+              << " weight " << std::setw(8) << txs[i].weight
+              << " count " << std::setw(10) << counts[i]
+              << " failed " << std::setw(8) << failures[i]
+              << " mean latency (ms) " << (counts[i] ?
+                latency_sums[i] / counts[i] / 1000 : 0) << std::endl;
+  print_histogram(latency);
+} catch (const std::exception& e) {
+  std::cerr << e.what() << std::endl;
+  return 1;
+} catch (...) {
+  std::cerr << "unknown error" << std::endl;
+  return 2;
+}
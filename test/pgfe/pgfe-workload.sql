@@ -0,0 +1,31 @@
+-- -*- SQL -*-
+--
+-- Copyright 2022 Dmitry Igrishin
+--
+-- Licensed under the Apache License, Version 2.0 (the "License");
+-- you may not use this file except in compliance with the License.
+-- You may obtain a copy of the License at
+--
+--     http://www.apache.org/licenses/LICENSE-2.0
+--
+-- Unless required by applicable law or agreed to in writing, software
+-- distributed under the License is distributed on an "AS IS" BASIS,
+-- WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+-- See the License for the specific language governing permissions and
+-- limitations under the License.
+
+-- An example script for dmitigr_pgfe-workload which needs no tables.
+
+-- $tx$point$tx$
+-- $weight$8$weight$
+-- $n$1 100000$n$
+select :n::integer * 2;
+
+-- $tx$range$tx$
+-- $weight$2$weight$
+-- $lo$1 1000$lo$
+-- $len$1 100$len$
+begin;
+select sum(i) from generate_series(:lo::integer, :lo::integer + :len::integer) i;
+select :lo::integer;
+commit;
@@ -0,0 +1,71 @@
+// -*- C++ -*-
+//
+// Copyright 2022 Dmitry Igrishin
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "../../src/base/assert.hpp"
+#include "../../src/util/diagnostic.hpp"
+
+#include <iostream>
+#include <string>
+
+int main()
+try {
+  namespace util = dmitigr::util;
+
+  // Percentiles.
+  {
+    util::Benchmark_result r;
+    for (int i{1}; i <= 100; ++i)
+      r.samples.push_back(i);
+    DMITIGR_ASSERT(r.min() == 1);
+    DMITIGR_ASSERT(r.max() == 100);
+    DMITIGR_ASSERT(r.median() == 50.5);
+    DMITIGR_ASSERT(r.mean() == 50.5);
+    DMITIGR_ASSERT(r.percentile(.99) == 99);
+    DMITIGR_ASSERT(r.percentile(1) == 100);
+    DMITIGR_ASSERT(r.percentile(0) == 1);
+  }
+
+  // Benchmark.
+  {
+    util::Benchmark_options opts;
+    opts.warmup_time = std::chrono::milliseconds{5};
+    opts.sample_time = std::chrono::microseconds{500};
+    opts.sample_count = 10;
+    opts.is_hardware_counters_enabled = true;
+    std::size_t call_count{};
+    const auto r = util::benchmark("string concatenation", [&call_count]
+    {
+      std::string s{"Hello"};
+      s += ", World!";
+      util::do_not_optimize(s);
+      ++call_count;
+    }, opts);
+    DMITIGR_ASSERT(r.name == "string concatenation");
+    DMITIGR_ASSERT(r.iteration_count > 0);
+    DMITIGR_ASSERT(r.samples.size() == opts.sample_count);
+    DMITIGR_ASSERT(call_count >= r.iteration_count * opts.sample_count);
+    DMITIGR_ASSERT(r.min() <= r.median());
+    DMITIGR_ASSERT(r.median() <= r.percentile(.99));
+    DMITIGR_ASSERT(r.percentile(.99) <= r.max());
+    std::cout << r << std::endl;
+  }
+} catch (const std::exception& e) {
+  std::cerr << e.what() << std::endl;
+  return 1;
+} catch (...) {
+  std::cerr << "unknown error" << std::endl;
+  return 2;
+}